@@ -0,0 +1,54 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+ 
+ Adonthell is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ Adonthell is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with Adonthell; if not, write to the Free Software 
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/** 
+ * @file common/intern.cc
+ *
+ * @author Kai Sterker
+ * @brief Map frequently used strings to compact ids.
+ */
+
+#include "intern.h"
+
+// ids of pooled strings
+std::hash_map<std::string, u_int32> intern::Ids;
+
+// pooled strings
+std::vector<const std::string*> intern::Strings;
+
+// get id of string
+u_int32 intern::get (const std::string & str)
+{
+    std::hash_map<std::string, u_int32>::const_iterator i = Ids.find (str);
+    if (i != Ids.end()) return i->second;
+
+    u_int32 id = Strings.size();
+    i = Ids.insert (std::make_pair (str, id)).first;
+
+    // keys of a hash_map never move, so no need for a second copy
+    Strings.push_back (&(i->first));
+
+    return id;
+}
+
+// get string with id
+const std::string & intern::str (const u_int32 & id)
+{
+    return *Strings[id];
+}
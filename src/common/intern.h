@@ -0,0 +1,78 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+ 
+ Adonthell is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ Adonthell is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with Adonthell; if not, write to the Free Software 
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/** 
+ * @file common/intern.h
+ *
+ * @author Kai Sterker
+ * @brief Map frequently used strings to compact ids.
+ */
+
+#ifndef COMMON_INTERN_H
+#define COMMON_INTERN_H
+
+#include <string>
+#include <vector>
+#include <adonthell/base/types.h>
+#include <adonthell/base/hash_map.h>
+
+/**
+ * Global pool of strings like tags, connector names or object
+ * states that are shared by a lot of objects. Each distinct string
+ * is stored only once and assigned a small id, so that comparing
+ * and hashing them becomes a cheap integer operation. Ids are
+ * handed out in ascending order, starting with 0, and stay valid
+ * for the lifetime of the application. They are not meant to be
+ * saved to disk.
+ */
+class intern
+{
+public:
+    /**
+     * Get the id of the given string. Strings not yet part
+     * of the pool are added.
+     * @param str a string.
+     * @return id of the string.
+     */
+    static u_int32 get (const std::string & str);
+
+    /**
+     * Get the string belonging to the given id.
+     * @param id id returned by intern::get.
+     * @return the string with that id.
+     */
+    static const std::string & str (const u_int32 & id);
+
+    /**
+     * Get the number of distinct strings in the pool.
+     * @return number of strings, which is also the next id.
+     */
+    static u_int32 size () { return Strings.size(); }
+
+private:
+    /// forbid instantiation
+    intern ();
+
+    /// ids of all strings in the pool
+    static std::hash_map<std::string, u_int32> Ids;
+    /// the strings, indexed by id
+    static std::vector<const std::string*> Strings;
+};
+
+#endif // COMMON_INTERN_H
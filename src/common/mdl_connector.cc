@@ -38,7 +38,7 @@
 MdlConnectorTemplate::MdlConnectorTemplate(const u_int32 & id)
 {
     Uid = uid::create(id);
-    Name = "";
+    Name = intern::get ("");
     Length = 0;
     Width = 0;
 }
@@ -47,7 +47,7 @@ MdlConnectorTemplate::MdlConnectorTemplate(const u_int32 & id)
 MdlConnectorTemplate::MdlConnectorTemplate(base::flat & record)
 {
     Uid = uid::from_string(record.get_string("uid"));
-    Name = record.get_string("name");
+    Name = intern::get (record.get_string("name"));
     Length = record.get_uint16("length");
     Width = record.get_uint16("width");
 }
@@ -56,7 +56,7 @@ MdlConnectorTemplate::MdlConnectorTemplate(base::flat & record)
 void MdlConnectorTemplate::save (base::flat & record) const
 {
     record.put_string ("uid", uid::as_string(Uid));
-    record.put_string ("name", Name);
+    record.put_string ("name", name());
     record.put_uint16 ("length", Length);
     record.put_uint16 ("width", Width);
 }
@@ -32,6 +32,8 @@
 #include <adonthell/base/hash_map.h>
 #include <adonthell/base/flat.h>
 
+#include "intern.h"
+
 /**
  * Common connector attributes, possibly shared by
  * different connectors.
@@ -53,13 +55,19 @@ public:
      * Get connector name.
      * @return a unique id for a connector.
      */
-    std::string name () const { return Name; }
+    const std::string & name () const { return intern::str (Name); }
+
+    /**
+     * Get id of the connector name, for quick comparison.
+     * @return interned connector name.
+     */
+    u_int32 name_id () const { return Name; }
 
     /**
      * Set connector name.
      * @param name a unique id for a connector.
      */
-    void set_name (const std::string & name) { Name = name; }
+    void set_name (const std::string & name) { Name = intern::get (name); }
 
     /**
      * Get connector length.
@@ -114,8 +122,8 @@ private:
     //@{
     /// unique id for the connector
     u_int32 Uid;
-    /// connector name
-    std::string Name;
+    /// connector name, interned
+    u_int32 Name;
     /// size when used on horizontal edge
     u_int16 Length;
     /// size when used on vertical edge
@@ -158,7 +166,13 @@ public:
      * Get connector name.
      * @return human readable name of connector.
      */
-    std::string name () const { return Template->name(); }
+    const std::string & name () const { return Template->name(); }
+
+    /**
+     * Get id of the connector name, for quick comparison.
+     * @return interned connector name.
+     */
+    u_int32 name_id () const { return Template->name_id(); }
 
     /**
      * Get connector length.
@@ -25,8 +25,9 @@
  */
 
 #include <math.h>
-#include <iostream>
+#include <cstdlib>
 #include "dlg_arrow.h"
+#include "dlg_loader.h"
 #include "dlg_module.h"
 #include "gui_resources.h"
 
@@ -248,7 +249,7 @@ bool DlgArrow::operator== (DlgPoint &point)
 }
 
 // load an arrow
-bool DlgArrow::load (DlgNode *m)
+bool DlgArrow::load (DlgLoader &loader, DlgNode *m)
 {
     DlgModule *module = (DlgModule *) m;
     DlgModule *owner = module;
@@ -261,7 +262,7 @@ bool DlgArrow::load (DlgNode *m)
     while (1)
     {
         // look what we find in the file
-        switch (parse_dlgfile (str, n))
+        switch (loader.next (str, n))
         {
             // EOF or finished
             case 0:
@@ -280,19 +281,15 @@ bool DlgArrow::load (DlgNode *m)
             // Module node belongs to
             case LOAD_MODULE:
             {
-                if (parse_dlgfile (str, n) == LOAD_NUM)
+                // the loader returns what follows "Module" as string
+                if (loader.next (str, n) == LOAD_STR)
                 {
                     // get the module the node belongs to
-                    owner = toplevel->getModule (n);
+                    owner = toplevel->getModule (atoi (str.c_str ()));
                     
-                    // failed
-                    if (!owner || owner->type () != MODULE)
-                    {
-                        std::cout << "DlgArrow::load: failed to getModule (" 
-                             << n << ")!" << std::endl;
-                        
-                        return false;
-                    }
+                    // ids of modules no longer part of the dialogue
+                    // refer to the module the arrow belongs to
+                    if (owner == NULL) owner = module;
                 }
                  
                 break;
@@ -301,10 +298,11 @@ bool DlgArrow::load (DlgNode *m)
             // Node prior to arrow
             case LOAD_PREV:
             {
-                if (parse_dlgfile (str, n) == LOAD_NUM)
+                if (loader.next (str, n) == LOAD_NUM)
                 {
                     // get the id of the previous circle
                     circle = owner->getNode (n);
+                    if (circle == NULL && owner != module) circle = module->getNode (n);
                         
                     // failed
                     if (circle == NULL) return false;
@@ -322,10 +320,11 @@ bool DlgArrow::load (DlgNode *m)
             // Node following arrow
             case LOAD_NEXT:
             {
-                if (parse_dlgfile (str, n) == LOAD_NUM)
+                if (loader.next (str, n) == LOAD_NUM)
                 {
                     // get the id of the previous circle
                     circle = owner->getNode (n);
+                    if (circle == NULL && owner != module) circle = module->getNode (n);
                         
                     // failed
                     if (circle == NULL) return false;
@@ -343,7 +342,7 @@ bool DlgArrow::load (DlgNode *m)
             // Nodes linked to the arrow (obsolete -> convert to normal arrow)
             case LOAD_LINK:
             {
-                if (parse_dlgfile (str, n) == LOAD_NUM)
+                if (loader.next (str, n) == LOAD_NUM)
                 {
                     circle = module->getNode (n);
                     if (circle == NULL) break;
@@ -67,13 +67,13 @@ public:
     void draw (cairo_surface_t *surface, DlgPoint &offset, GtkWidget *widget);
 
     /**
-     * Init the Arrow from a file.  The file to load from is a global 
-     * variable, as loading is handled by a scanner generated with flex.
+     * Init the Arrow from a file.
+     * @param loader the dialogue source being read.
      * @param module The dialogue this arrow belongs to.
      * @return <b>true</b> if loading was successful, <b>false</b>
      *         otherwise.
      */
-    bool load (DlgNode *module);
+    bool load (DlgLoader &loader, DlgNode *module);
 
     /**
      * save an Arrow to a file
@@ -0,0 +1,301 @@
+/*
+   Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+   Part of the Adonthell Project http://adonthell.linuxgames.com
+
+   Dlgedit is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   Dlgedit is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Dlgedit; if not, write to the Free Software 
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/** 
+ * @file dlg_batch.cc
+ *
+ * @author Kai Sterker
+ * @brief Compiling dialogues from the command line.
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <adonthell/base/base.h>
+#include "dlg_batch.h"
+#include "dlg_cache.h"
+#include "dlg_cmdline.h"
+#include "dlg_compiler.h"
+#include "dlg_layout.h"
+#include "dlg_loader.h"
+#include "gui_dlgedit.h"
+
+/// name of the compile cache, stored in the project directory
+#define DLG_MANIFEST "dlgedit.manifest"
+
+// compile all dialogues
+int DlgBatch::run (char *files[], const int & count, const int & jobs)
+{
+    bool result = true;
+    
+    // the cache is kept with the project
+    DlgCache cache;
+    bool use_cache = (DlgCmdline::project != "none");
+    if (use_cache) cache.load (base::Paths().game_data_dir () + DLG_MANIFEST);
+    
+    // compile in this process
+    if (jobs <= 1)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (use_cache && !DlgCmdline::force && !DlgCmdline::arrange && cache.isCurrent (files[i])) continue;
+            
+            std::string script;
+            std::vector<std::string> deps;
+            if (!compile (files[i], script, deps)) result = false;
+            else if (use_cache) cache.update (files[i], script, deps);
+        }
+        
+        if (use_cache) cache.save ();
+        return result ? 0 : 1;
+    }
+    
+    std::deque<job> running;
+    int next = 0;
+    
+    while (next < count || !running.empty ())
+    {
+        // keep the given number of dialogues in progress
+        while (next < count && (int) running.size () < jobs)
+        {
+            if (use_cache && !DlgCmdline::force && !DlgCmdline::arrange && cache.isCurrent (files[next]))
+            {
+                next++;
+                continue;
+            }
+            
+            job j;
+            j.Filename = files[next++];
+            j.Pid = spawn (j.Filename, j.Fd);
+            if (j.Pid == -1)
+            {
+                fprintf (stderr, "*** DlgBatch::run: cannot compile '%s'\n", j.Filename.c_str ());
+                result = false;
+                continue;
+            }
+            
+            running.push_back (j);
+        }
+        
+        // print output in the order dialogues were given
+        if (!running.empty ())
+        {
+            std::string script;
+            std::vector<std::string> deps;
+            if (!collect (running.front (), script, deps)) result = false;
+            else if (use_cache) cache.update (running.front ().Filename, script, deps);
+            running.pop_front ();
+        }
+    }
+    
+    if (use_cache) cache.save ();
+    return result ? 0 : 1;
+}
+
+// compile a single dialogue
+bool DlgBatch::compile (const std::string & fname, std::string & script, std::vector<std::string> & deps)
+{
+    // check whether the file is a valid dialoge
+    if (!GuiDlgedit::checkDialogue (fname))
+    {
+        std::cout << "Loading of '" << fname << "' failed\n";
+        return false;
+    }
+    
+    // arrange the nodes first, if requested
+    if (DlgCmdline::arrange && !arrange (fname)) return false;
+    
+    DlgModule *module = new DlgModule ("", fname, "-1", "");
+    bool result = false;
+    
+    // try to load from file
+    DlgLoader loader;
+    if (!loader.open (fname) || !module->load (loader))
+    {
+        std::cout << "Loading of '" << fname << "' failed\n";
+    }
+    else
+    {
+        std::cout << "Compiling '" << fname << "' ...\n";
+        
+        // try to compile the dialogue
+        DlgCompiler compiler (module);
+        result = compiler.run ();
+        
+        // what the script depends on
+        script = DlgCompiler::scriptName (module);
+        deps.push_back (fname);
+        DlgCache::dependencies (module, deps);
+    }
+    
+    delete module;
+    return result;
+}
+
+// arrange the nodes of a single dialogue
+bool DlgBatch::arrange (const std::string & fname)
+{
+    // the dialogue is saved back to where it was loaded from
+    gchar *dir = g_path_get_dirname (fname.c_str ());
+    gchar *base = g_path_get_basename (fname.c_str ());
+    std::string path (dir);
+    std::string name (base);
+    g_free (dir);
+    g_free (base);
+    
+    // remove file extension
+    unsigned long pos = name.rfind (FILE_EXT);
+    if (pos == name.npos || pos + strlen (FILE_EXT) != name.length ())
+    {
+        std::cout << "Cannot arrange '" << fname << "', as it is no " << FILE_EXT << " file\n";
+        return false;
+    }
+    name.erase (pos);
+    
+    DlgModule module (path, name, "-1", "");
+    bool result = false;
+    
+    DlgLoader loader;
+    if (!loader.open (fname) || !module.load (loader))
+    {
+        std::cout << "Loading of '" << fname << "' failed\n";
+    }
+    else
+    {
+        std::cout << "Arranging '" << fname << "' ...\n";
+        
+        DlgLayout layout (&module);
+        layout.arrange ();
+        
+        result = module.save (path, name);
+        if (!result) std::cout << "Saving of '" << fname << "' failed\n";
+    }
+    
+    return result;
+}
+
+// compile dialogue in child process
+int DlgBatch::spawn (const std::string & fname, int & fd)
+{
+    int fds[2];
+    if (pipe (fds) == -1) return -1;
+    
+    // do not let the child print what is still buffered
+    std::cout.flush ();
+    fflush (stdout);
+    fflush (stderr);
+    
+    pid_t pid = fork ();
+    if (pid == -1)
+    {
+        close (fds[0]);
+        close (fds[1]);
+        return -1;
+    }
+    
+    if (pid == 0)
+    {
+        close (fds[0]);
+        
+        // the compiler prints to stdout, so send that to the parent
+        if (dup2 (fds[1], STDOUT_FILENO) == -1) _exit (1);
+        close (fds[1]);
+        
+        std::string script;
+        std::vector<std::string> deps;
+        bool result = compile (fname, script, deps);
+        
+        // followed by what the script depends on
+        std::cout << '\0' << script << '\n';
+        for (std::vector<std::string>::const_iterator i = deps.begin (); i != deps.end (); i++)
+            std::cout << *i << '\n';
+        
+        std::cout.flush ();
+        fflush (stdout);
+        
+        // Python was set up by the parent, leave cleanup to it
+        _exit (result ? 0 : 1);
+    }
+    
+    close (fds[1]);
+    fd = fds[0];
+    return pid;
+}
+
+// print output of child process
+bool DlgBatch::collect (const job & j, std::string & script, std::vector<std::string> & deps)
+{
+    char buffer[4096];
+    ssize_t size;
+    std::string trailer;
+    bool output = true;
+    
+    while ((size = read (j.Fd, buffer, sizeof (buffer))) != 0)
+    {
+        if (size == -1)
+        {
+            if (errno == EINTR) continue;
+            break;
+        }
+        
+        // output of the compiler ends with a '\0'
+        ssize_t length = size;
+        if (output)
+        {
+            const char *end = (const char *) memchr (buffer, '\0', size);
+            if (end != NULL)
+            {
+                length = end - buffer;
+                trailer.append (end + 1, size - length - 1);
+                output = false;
+            }
+            
+            fwrite (buffer, 1, length, stdout);
+        }
+        else trailer.append (buffer, size);
+    }
+    close (j.Fd);
+    
+    // the script and the files it depends on, one per line
+    std::string::size_type pos = 0, eol;
+    while ((eol = trailer.find ('\n', pos)) != std::string::npos)
+    {
+        if (pos == 0) script = trailer.substr (0, eol);
+        else deps.push_back (trailer.substr (pos, eol - pos));
+        pos = eol + 1;
+    }
+    
+    int status;
+    while (waitpid (j.Pid, &status, 0) == -1)
+    {
+        if (errno != EINTR) return false;
+    }
+    
+    if (!WIFEXITED (status))
+    {
+        fprintf (stderr, "*** DlgBatch::collect: compiling '%s' failed\n", j.Filename.c_str ());
+        return false;
+    }
+    
+    return WEXITSTATUS (status) == 0;
+}
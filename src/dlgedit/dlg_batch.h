@@ -0,0 +1,109 @@
+/*
+   Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+   Part of the Adonthell Project http://adonthell.linuxgames.com
+
+   Dlgedit is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   Dlgedit is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Dlgedit; if not, write to the Free Software 
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/** 
+ * @file dlg_batch.h
+ *
+ * @author Kai Sterker
+ * @brief Compiling dialogues from the command line.
+ */
+
+#ifndef DLG_BATCH_H
+#define DLG_BATCH_H
+
+#include <string>
+#include <vector>
+
+/**
+ * Compiles the dialogues given on the command line without opening
+ * the editor. The output of the compiler is printed for each dialogue
+ * in turn, no matter how many dialogues are compiled at the same time.
+ *
+ * Dialogues that did not change since they were last compiled for
+ * the project are skipped, unless compiling is forced or the nodes
+ * of the dialogues are to be arranged first.
+ *
+ * Each dialogue is compiled in a process of its own, forked once
+ * Python has been initialized. This keeps apart the project data
+ * loaded along with each dialogue and the state of the compiler, so
+ * several dialogues can be compiled at the same time.
+ */
+class DlgBatch
+{
+public:
+    /**
+     * Compile the given dialogues.
+     * @param files the dialogue sources.
+     * @param count number of dialogues.
+     * @param jobs number of dialogues to compile at the same time.
+     * @return 0 if all dialogues compiled without errors, 1 otherwise.
+     */
+    static int run (char *files[], const int & count, const int & jobs);
+    
+private:
+    /**
+     * Load and compile a single dialogue, printing the output
+     * of the compiler.
+     * @param fname the dialogue source.
+     * @param script receives the name of the Python script.
+     * @param deps receives the files the dialogue was loaded from.
+     * @return <b>true</b> on success, <b>false</b> otherwise.
+     */
+    static bool compile (const std::string & fname, std::string & script, std::vector<std::string> & deps);
+    
+    /**
+     * Arrange the nodes of a single dialogue and save it.
+     * @param fname the dialogue source.
+     * @return <b>true</b> on success, <b>false</b> otherwise.
+     */
+    static bool arrange (const std::string & fname);
+    
+    /**
+     * Compile a dialogue in a child process.
+     * @param fname the dialogue source.
+     * @param fd receives the end of the pipe the output is written to.
+     * @return id of the child or -1 on error.
+     */
+    static int spawn (const std::string & fname, int & fd);
+    
+    /**
+     * A dialogue being compiled in a child process.
+     */
+    struct job
+    {
+        /// the dialogue source
+        std::string Filename;
+        /// id of the child
+        int Pid;
+        /// the pipe the output is written to
+        int Fd;
+    };
+    
+    /**
+     * Print the output of a child process and wait for it to exit.
+     * @param j the dialogue being compiled.
+     * @param script receives the name of the Python script.
+     * @param deps receives the files the dialogue was loaded from.
+     * @return <b>true</b> if the dialogue compiled without errors,
+     *      <b>false</b> otherwise.
+     */
+    static bool collect (const job & j, std::string & script, std::vector<std::string> & deps);
+};
+
+#endif // DLG_BATCH_H
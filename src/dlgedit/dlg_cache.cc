@@ -0,0 +1,225 @@
+/*
+   Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+   Part of the Adonthell Project http://adonthell.linuxgames.com
+
+   Dlgedit is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   Dlgedit is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Dlgedit; if not, write to the Free Software 
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/** 
+ * @file dlg_cache.cc
+ *
+ * @author Kai Sterker
+ * @brief Keeps track of dialogues that need no compiling.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <glib.h>
+#include "uid.h"
+#include "dlg_cache.h"
+#include "dlg_cmdline.h"
+#include "dlg_compiler.h"
+
+/// increase whenever the manifest layout changes
+#define DLG_CACHE_VERSION 1
+
+// ctor
+DlgCache::DlgCache ()
+{
+    Changed = false;
+}
+
+// read manifest
+bool DlgCache::load (const std::string & filename)
+{
+    Filename = filename;
+    Entries.clear ();
+    Changed = false;
+    
+    std::ifstream in (filename.c_str ());
+    if (!in.is_open ()) return true;
+    
+    std::string line;
+    std::getline (in, line);
+    
+    gchar *header = g_strdup_printf ("DlgCache %i", DLG_CACHE_VERSION);
+    bool outdated = (line != header);
+    g_free (header);
+    
+    if (outdated)
+    {
+        // outdated manifest, start from scratch
+        Changed = true;
+        return true;
+    }
+    
+    entry *current = NULL;
+    while (std::getline (in, line))
+    {
+        // Dialogue <key> <source>
+        if (line.compare (0, 9, "Dialogue ") == 0 && line.length () > 18)
+        {
+            current = &Entries[line.substr (18)];
+            current->Key = uid::from_string (line.substr (9, 8));
+        }
+        // Script <script>
+        else if (line.compare (0, 7, "Script ") == 0 && current != NULL)
+        {
+            current->Script = line.substr (7);
+        }
+        // File <hash> <file>
+        else if (line.compare (0, 5, "File ") == 0 && line.length () > 14 && current != NULL)
+        {
+            current->Files.push_back (std::make_pair (line.substr (14), uid::from_string (line.substr (5, 8))));
+        }
+        else
+        {
+            fprintf (stderr, "*** DlgCache::load: '%s' is corrupt\n", filename.c_str ());
+            Entries.clear ();
+            Changed = true;
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+// write manifest
+bool DlgCache::save ()
+{
+    if (!Changed) return true;
+    
+    std::ofstream out (Filename.c_str ());
+    if (!out.is_open ())
+    {
+        fprintf (stderr, "*** DlgCache::save: cannot write '%s'\n", Filename.c_str ());
+        return false;
+    }
+    
+    out << "DlgCache " << DLG_CACHE_VERSION << "\n";
+    for (std::map<std::string, entry>::const_iterator i = Entries.begin (); i != Entries.end (); i++)
+    {
+        out << "Dialogue " << uid::as_string (i->second.Key) << " " << i->first << "\n";
+        out << "Script " << i->second.Script << "\n";
+        
+        std::vector<std::pair<std::string, u_int32> >::const_iterator f;
+        for (f = i->second.Files.begin (); f != i->second.Files.end (); f++)
+        {
+            out << "File " << uid::as_string (f->second) << " " << f->first << "\n";
+        }
+    }
+    
+    out.close ();
+    if (out.fail ())
+    {
+        fprintf (stderr, "*** DlgCache::save: cannot write '%s'\n", Filename.c_str ());
+        return false;
+    }
+    
+    Changed = false;
+    return true;
+}
+
+// check whether dialogue is up to date
+bool DlgCache::isCurrent (const std::string & source)
+{
+    std::map<std::string, entry>::const_iterator i = Entries.find (source);
+    if (i == Entries.end ()) return false;
+    
+    // script must not have been removed
+    if (!g_file_test (i->second.Script.c_str (), G_FILE_TEST_IS_REGULAR)) return false;
+    
+    // files must have the same contents
+    std::vector<std::pair<std::string, u_int32> > files;
+    std::vector<std::pair<std::string, u_int32> >::const_iterator f;
+    for (f = i->second.Files.begin (); f != i->second.Files.end (); f++)
+    {
+        u_int32 hash;
+        if (!hashFile (f->first, hash) || hash != f->second) return false;
+        files.push_back (std::make_pair (f->first, hash));
+    }
+    
+    // compiler or project must be the same
+    return key (files) == i->second.Key;
+}
+
+// remember compiled dialogue
+void DlgCache::update (const std::string & source, const std::string & script, const std::vector<std::string> & files)
+{
+    entry e;
+    e.Script = script;
+    
+    for (std::vector<std::string>::const_iterator f = files.begin (); f != files.end (); f++)
+    {
+        u_int32 hash;
+        if (!hashFile (*f, hash))
+        {
+            // try again next time
+            Changed |= Entries.erase (source) > 0;
+            return;
+        }
+        
+        e.Files.push_back (std::make_pair (*f, hash));
+    }
+    
+    e.Key = key (e.Files);
+    Entries[source] = e;
+    Changed = true;
+}
+
+// sub-dialogues of a dialogue
+void DlgCache::dependencies (DlgModule *module, std::vector<std::string> & files)
+{
+    std::vector<DlgNode*> &nodes = module->getNodes ();
+    for (std::vector<DlgNode*>::iterator i = nodes.begin (); i != nodes.end (); i++)
+    {
+        if ((*i)->type () != MODULE) continue;
+        
+        DlgModule *subdlg = (DlgModule *) *i;
+        files.push_back (subdlg->fullName ());
+        dependencies (subdlg, files);
+    }
+}
+
+// hash file contents
+bool DlgCache::hashFile (const std::string & file, u_int32 & hash)
+{
+    gchar *contents;
+    gsize length;
+    
+    if (!g_file_get_contents (file.c_str (), &contents, &length, NULL))
+        return false;
+    
+    hash = uid::hash (std::string (contents, length));
+    g_free (contents);
+    
+    return true;
+}
+
+// key of dialogue
+u_int32 DlgCache::key (const std::vector<std::pair<std::string, u_int32> > & files)
+{
+    gchar *compiler = g_strdup_printf ("%s-%i", _VERSION_, DLG_COMPILER_VERSION);
+    std::string data = std::string (compiler) + "\n" + DlgCmdline::project + "\n";
+    g_free (compiler);
+    
+    std::vector<std::pair<std::string, u_int32> >::const_iterator f;
+    for (f = files.begin (); f != files.end (); f++)
+    {
+        data += f->first + "\n" + uid::as_string (f->second) + "\n";
+    }
+    
+    return uid::hash (data);
+}
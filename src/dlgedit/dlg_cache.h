@@ -0,0 +1,133 @@
+/*
+   Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+   Part of the Adonthell Project http://adonthell.linuxgames.com
+
+   Dlgedit is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   Dlgedit is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Dlgedit; if not, write to the Free Software 
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/** 
+ * @file dlg_cache.h
+ *
+ * @author Kai Sterker
+ * @brief Keeps track of dialogues that need no compiling.
+ */
+
+#ifndef DLG_CACHE_H
+#define DLG_CACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <adonthell/base/types.h>
+
+class DlgModule;
+
+/**
+ * Remembers for each dialogue compiled from the command line the
+ * files it was loaded from: the dialogue itself, including its custom
+ * code, and all sub-dialogues it contains. These are stored along with
+ * a hash of their contents in a manifest file in the project directory.
+ * As long as none of the files changed, neither did the result, so
+ * the dialogue need not be compiled again.
+ *
+ * The key of each dialogue also covers the version of the compiler
+ * and the project it was compiled for, so changing either will cause
+ * all dialogues to be compiled once more.
+ */
+class DlgCache
+{
+public:
+    /**
+     * Create an empty cache.
+     */
+    DlgCache ();
+    
+    /**
+     * Read the manifest from the given file. Silently starts with an
+     * empty cache if the file is missing or of a different version.
+     * @param filename full path of the manifest file.
+     * @return <b>true</b> on success, <b>false</b> otherwise.
+     */
+    bool load (const std::string & filename);
+    
+    /**
+     * Write the manifest back to disk, if anything changed.
+     * @return <b>true</b> on success, <b>false</b> otherwise.
+     */
+    bool save ();
+    
+    /**
+     * Check whether a dialogue needs to be compiled. That is the case
+     * if it has not been compiled before, if its script is missing or
+     * if any of the files it was loaded from changed.
+     * @param source the dialogue source.
+     * @return <b>true</b> if it is up to date, <b>false</b> otherwise.
+     */
+    bool isCurrent (const std::string & source);
+    
+    /**
+     * Remember a dialogue that compiled without errors.
+     * @param source the dialogue source.
+     * @param script the Python script created from the dialogue.
+     * @param files the files the dialogue was loaded from.
+     */
+    void update (const std::string & source, const std::string & script, const std::vector<std::string> & files);
+    
+    /**
+     * Get the files a dialogue was loaded from, i.e. the sources
+     * of all sub-dialogues it contains, in the order they appear.
+     * @param module a dialogue loaded from file.
+     * @param files receives the source of each sub-dialogue.
+     */
+    static void dependencies (DlgModule *module, std::vector<std::string> & files);
+    
+private:
+    /**
+     * Cached data of a single dialogue.
+     */
+    struct entry
+    {
+        /// hash over everything the compiled script depends on
+        u_int32 Key;
+        /// the Python script created from the dialogue
+        std::string Script;
+        /// files the dialogue was loaded from with hash of their contents
+        std::vector<std::pair<std::string, u_int32> > Files;
+    };
+    
+    /**
+     * Compute the hash of a file's contents.
+     * @param file the file to hash.
+     * @param hash receives the hash.
+     * @return <b>false</b> if the file could not be read.
+     */
+    static bool hashFile (const std::string & file, u_int32 & hash);
+    
+    /**
+     * Compute the key of a dialogue.
+     * @param files the files the dialogue was loaded from.
+     * @return hash over the files and the compiler version.
+     */
+    static u_int32 key (const std::vector<std::pair<std::string, u_int32> > & files);
+    
+    /// name of the manifest file
+    std::string Filename;
+    /// cached data, indexed by dialogue source
+    std::map<std::string, entry> Entries;
+    /// whether the manifest needs saving
+    bool Changed;
+};
+
+#endif // DLG_CACHE_H
@@ -25,6 +25,7 @@
  */
 
 #include "dlg_circle.h"
+#include "dlg_loader.h"
 #include "gui_resources.h"
 
 // Constructor
@@ -99,18 +100,13 @@ void DlgCircle::draw (cairo_surface_t *surface, DlgPoint &os, GtkWidget *widget)
     // Indicate whether node contains additional code
     if (hasCode () || entry_->loop ())
     {
-        GString *code = g_string_sized_new (2);
+        std::string code;
         
-        if (hasCode ()) g_string_append_c (code, '!');
-        if (entry_->loop ()) g_string_append_c (code, 'o');
+        if (hasCode ()) code += '!';
+        if (entry_->loop ()) code += 'o';
         
-        // get the font to use
-        const PangoFontDescription *desc = pango_layout_get_font_description (GuiResources::font ());
-
-        // create pango cairo compatible layout
-        PangoLayout *font = pango_cairo_create_layout(cr);
-        pango_layout_set_font_description (font, desc);
-        pango_layout_set_text (font, code->str, -1);
+        // get the text laid out with the font to use
+        PangoLayout *font = label (cr, code);
 
         // place text in circles center
         int w, h;
@@ -121,14 +117,10 @@ void DlgCircle::draw (cairo_surface_t *surface, DlgPoint &os, GtkWidget *widget)
 
         // set font color and position
         gdk_cairo_set_source_color(cr, gc);
-        pango_cairo_update_layout (cr, font);
         cairo_move_to(cr, x, y);
 
         // draw text
         pango_cairo_show_layout (cr, font);
-        g_object_unref(font);
-
-        g_string_free (code, TRUE);
     }
     
     // Update the drawing area
@@ -138,7 +130,7 @@ void DlgCircle::draw (cairo_surface_t *surface, DlgPoint &os, GtkWidget *widget)
 }
 
 // load a circle from a file
-bool DlgCircle::load ()
+bool DlgCircle::load (DlgLoader &loader)
 {
     entry_ = new DlgCircleEntry;
     std::string str;
@@ -148,7 +140,7 @@ bool DlgCircle::load ()
     while (1)
     {
         // look what we find in the file
-        switch (parse_dlgfile (str, n))
+        switch (loader.next (str, n))
         {
             // EOF or finished
             case 0:
@@ -157,21 +149,21 @@ bool DlgCircle::load ()
             // Type of node
             case LOAD_TYPE:
             {
-                if (parse_dlgfile (str, n) == LOAD_NUM) type_ = (node_type) n;
+                if (loader.next (str, n) == LOAD_NUM) type_ = (node_type) n;
                 break;
             }
             
             // Loop
             case LOAD_LOOP:
             {
-                if (parse_dlgfile (str, n) == LOAD_NUM) entry_->setLoop (n);
+                if (loader.next (str, n) == LOAD_NUM) entry_->setLoop (n);
                 break;
             }
             
             // Module and Node id of Circle
             case LOAD_ID:
             {
-                if (parse_dlgfile (str, n) == LOAD_NUM) nid_ = n;
+                if (loader.next (str, n) == LOAD_NUM) nid_ = n;
                 
                 break;
             }
@@ -180,8 +172,8 @@ bool DlgCircle::load ()
             case LOAD_POS:
             {
                 int px, py;
-                if (parse_dlgfile (str, n) == LOAD_NUM) px = n;
-                if (parse_dlgfile (str, n) == LOAD_NUM) py = n;
+                if (loader.next (str, n) == LOAD_NUM) px = n;
+                if (loader.next (str, n) == LOAD_NUM) py = n;
 
                 // Align Circle to the (imaginary) grid
                 top_left = DlgPoint (px - (px % CIRCLE_DIAMETER), py - (py % CIRCLE_DIAMETER));
@@ -193,35 +185,35 @@ bool DlgCircle::load ()
             // The Circle's Text
             case LOAD_TEXT:
             {
-                if (parse_dlgfile (str, n) == LOAD_STR) entry_->setText (str);
+                if (loader.next (str, n) == LOAD_STR) entry_->setText (str);
                 break;
             }
 
             // The Circle's Annotations
             case LOAD_NOTE:
             {
-                if (parse_dlgfile (str, n) == LOAD_STR) entry_->setAnnotation (str);
+                if (loader.next (str, n) == LOAD_STR) entry_->setAnnotation (str);
                 break;
             }
 
             // The Circle's Character
             case LOAD_NPC:
             {
-                if (parse_dlgfile (str, n) == LOAD_STR) entry_->setNpc (str);
+                if (loader.next (str, n) == LOAD_STR) entry_->setNpc (str);
                 break;
             }
 
             // The Circle's Conditions
             case LOAD_COND:
             {
-                if (parse_dlgfile (str, n) == LOAD_STR) entry_->setCondition (str);
+                if (loader.next (str, n) == LOAD_STR) entry_->setCondition (str);
                 break;
             }
 
             // The Circle's Variables
             case LOAD_VARS:
             {
-                if (parse_dlgfile (str, n) == LOAD_STR) entry_->setCode (str);
+                if (loader.next (str, n) == LOAD_STR) entry_->setCode (str);
                 break;
             }
 
@@ -93,11 +93,11 @@ public:
     //@}
 
     /**
-     * load circle from a file. The file to load from is a global variable, 
-     * as loading is handled by a scanner generated with flex.
+     * load circle from a file.
+     * @param loader the dialogue source being read.
      * @return <b>true</b> on success, <b>false</b> otherwise.
      */
-    bool load ();
+    bool load (DlgLoader &loader);
     
     /**
      * save a circle to a file
@@ -27,6 +27,7 @@
  */
  
 #include <iostream> 
+#include <cstdlib>
 #include <dirent.h>
 #include <unistd.h>
 #include "dlg_cmdline.h"
@@ -34,6 +35,15 @@
 // flag indicating whether to compile the given scripts
 bool DlgCmdline::compile = false;
 
+// number of dialogues to compile at once
+int DlgCmdline::jobs = 1;
+
+// flag indicating whether to compile unchanged scripts
+bool DlgCmdline::force = false;
+
+// flag indicating whether to arrange the given scripts
+bool DlgCmdline::arrange = false;
+
 // the directory to look for project files
 std::string DlgCmdline::datadir = DATA_DIR"/games";
 
@@ -49,7 +59,7 @@ bool DlgCmdline::parse (int argc, char* argv[])
     int c;
     
     // Check for options
-    while ((c = getopt (argc, argv, "cdhvg:p:")) != -1)
+    while ((c = getopt (argc, argv, "cdfhlvg:j:p:")) != -1)
     {
         switch (c)
         {
@@ -71,6 +81,30 @@ bool DlgCmdline::parse (int argc, char* argv[])
                 break;
             }
             
+            case 'f':
+            {
+                force = true;
+                break;
+            }
+            
+            case 'l':
+            {
+                arrange = true;
+                break;
+            }
+            
+            case 'j':
+            {
+                jobs = atoi (optarg);
+                if (jobs <= 0)
+                {
+                    std::cerr << "Invalid number of jobs " << optarg << "!" << std::endl;
+                    return false;
+                }
+                
+                break;
+            }
+            
             case 'p':
             {
                 project = optarg;
@@ -120,6 +154,9 @@ void DlgCmdline::help (const std::string &program)
     std::cout << "-d         print the project directory and exit" << std::endl; 
     std::cout << "-v         print version and exit" << std::endl; 
     std::cout << "-c         compile all SOURCES and exit" << std::endl;
+    std::cout << "-f         compile SOURCES even if they did not change" << std::endl;
     std::cout << "-g dir     specify a custom project directory" << std::endl;
+    std::cout << "-j n       compile n SOURCES at the same time" << std::endl;
+    std::cout << "-l         arrange the nodes of SOURCES before compiling" << std::endl;
     std::cout << "-p project specify a default project" << std::endl;
 }
@@ -66,6 +66,24 @@ public:
      */
     static bool compile;
     
+    /**
+     * Number of dialogues to compile at the same time. The default
+     * is 1.
+     */
+    static int jobs;
+    
+    /**
+     * This is set to <b>true</b> to compile all given sourcefiles, even
+     * those that did not change since they were last compiled.
+     */
+    static bool force;
+    
+    /**
+     * This is set to <b>true</b> to arrange the nodes of all given
+     * sourcefiles and save them, before they are compiled.
+     */
+    static bool arrange;
+    
     /**
      * The index in the argument vector pointing to the first non-option.
      * With a bit of luck, this is one or more dialogue sources.
@@ -33,8 +33,6 @@
 #include "dlg_arrow.h"
 #include "gui_error.h"
 
-#define _DEBUG_ 1
-
 // Operators that may appear in Python code
 std::string DlgCompiler::operators[NUM_OPS] = { "==", "!=", "<", "<=", ">", 
     ">=", "=", ".", ":", "if", "elif", "else", "pass", "return", "and", "or", 
@@ -45,6 +43,13 @@ std::string DlgCompiler::operators[NUM_OPS] = { "==", "!=", "<", "<=", ">",
 std::string DlgCompiler::fixed[NUM_FXD] = { "self", "quests", "the_npc", 
     "the_player", "characters"};
 
+// operators by their first character, in the order of the table above
+int DlgCompiler::firstOperator[256];
+int DlgCompiler::nextOperator[NUM_OPS];
+
+// set up before main, so parallel compilers never see half-linked tables
+bool DlgCompiler::operatorsLinked = DlgCompiler::linkOperators ();
+
 
 DlgCompiler::DlgCompiler (DlgModule *module)
 {
@@ -52,32 +57,19 @@ DlgCompiler::DlgCompiler (DlgModule *module)
     dialogue = module;
     errors = 0;
     
-    int length = module->getNodes ().size () + 1;
-    
     // create our lookup tables    
-    codeTable = new int[length];
-    conditionTable = new int[length];
-    operationTable = new int[length];
-    
-    // initialize them with something sensible
-    memset (codeTable, 255, length * sizeof (int));
-    memset (conditionTable, 255, length * sizeof (int));
-    memset (operationTable, 0, length * sizeof (int));
+    growTables (module->getNodes ().size () + 1);
 }
 
 // dtor
 DlgCompiler::~DlgCompiler ()
 {
-    delete[] codeTable;
-    delete[] conditionTable;
-    delete[] operationTable;
-    
     for (DlgNode *next = start.next (FIRST); next != NULL; next = start.next (FIRST))
         delete (DlgArrow *) next;
 }
 
 // compile the dialogue into Python script
-void DlgCompiler::run ()
+bool DlgCompiler::run ()
 {
     if (DlgCmdline::compile == false)
     {
@@ -89,19 +81,12 @@ void DlgCompiler::run ()
     }
     
     // try to open the file
-    std::string full_name = dialogue->fullName ();
-
-    // replace '-' by '_' as python doesn't like it
-    std::replace (full_name.begin(), full_name.end(), '-', '_');
-    
-    // remove the file extension
-    unsigned long pos = full_name.rfind (FILE_EXT);
-    if (pos != full_name.npos) full_name.erase (pos);
-    
-    // try to open the file
-    file.open ((full_name + ".py").c_str ());
-    if (file.eof ()) return;
+    std::string script = scriptName (dialogue);
+    file.open (script.c_str ());
+    if (file.eof ()) return false;
     
+    // the name of the class, without the file extension
+    std::string full_name = script.substr (0, script.length () - 3);
     gchar *fname = g_path_get_basename (full_name.c_str ());
 
     // write the script header
@@ -133,6 +118,23 @@ void DlgCompiler::run ()
         GuiError::console->display ();
 
     g_free(fname);
+    
+    return errors == 0;
+}
+
+// name of the script the module compiles into
+std::string DlgCompiler::scriptName (DlgModule *module)
+{
+    std::string full_name = module->fullName ();
+
+    // replace '-' by '_' as python doesn't like it
+    std::replace (full_name.begin(), full_name.end(), '-', '_');
+    
+    // remove the file extension
+    unsigned long pos = full_name.rfind (FILE_EXT);
+    if (pos != full_name.npos) full_name.erase (pos);
+    
+    return full_name + ".py";
 }
 
 // write the topmost part of the dialogue 
@@ -179,6 +181,7 @@ void DlgCompiler::writeText ()
                 
         // set index of this node for later use
         (*i)->setIndex (++j);
+        growTables (j + 1);
 
         // build condition vector
         if (entry->condition () != "")
@@ -334,7 +337,7 @@ std::string DlgCompiler::inflateCode (std::string code)
 
     while (pos != code.npos)
     {
-        if (pos < 5 || strncmp (code.substr (pos-5, pos).c_str(), "self.", 5))
+        if (pos < 5 || code.compare (pos-5, 5, "self.") != 0)
         {
             code.insert (pos, "self.");
             pos += 5;
@@ -347,7 +350,7 @@ std::string DlgCompiler::inflateCode (std::string code)
 
     while (pos != code.npos)
     {
-        if (pos < 5 || strncmp (code.substr (pos-5, pos).c_str(), "self.", 5))
+        if (pos < 5 || code.compare (pos-5, 5, "self.") != 0)
         {
             code.insert (pos, "self.");
             pos += 5;
@@ -358,157 +361,163 @@ std::string DlgCompiler::inflateCode (std::string code)
 
     // scan the string from left to right
     for (pos = 0; pos < code.length (); pos++)
-        for (i = 0; i < NUM_OPS; i++)
-            // search for the leftmost operator from the current position
-            if (!strncmp (code.substr (pos).c_str (), operators[i].c_str (),
-                operators[i].length ()) || (i == NUM_OPS-1 && pos == code.length()-1))
-            {
-                // takes care of the rare situation when the last token
-                // of the string is a variable in need of expanding
-                if (pos == code.length()-1 && i == NUM_OPS-1) pos++;
+    {
+        // search for the leftmost operator from the current position
+        i = matchOperator (code, pos);
+        if (i == NUM_OPS)
+        {
+            if (pos != code.length()-1) continue;
 
-                token = code.substr (begin, pos-begin);
+            // takes care of the rare situation when the last token
+            // of the string is a variable in need of expanding
+            i = NUM_OPS-1;
+        }
+        if (pos == code.length()-1 && i == NUM_OPS-1) pos++;
 
-                // strip leading and trailing whitespace
-                for (prefix = 0; prefix < token.length() && token[prefix] == ' '; prefix++);
-                for (suffix = token.length()-1; suffix >= 0 && token[suffix] == ' '; suffix--);
-                stripped = token.substr (prefix, suffix-prefix+1);
-                
-                // have to be careful with textual operators and keywords
-                if (i == BAND || i == BOR || i == NOT || i == RETURN ||
-                    i == PASS || i == IF || i == ELIF || i == ELSE)
-                {
-                    if (pos > 0 && isalpha (code[pos-1]))
-                        break;
-                    if (pos < code.length()-operators[i].length()-1 &&
-                        isalpha (code[pos+operators[i].length()]))
-                        break;
-                }
+        token = code.substr (begin, pos-begin);
+
+        // strip leading and trailing whitespace
+        for (prefix = 0; prefix < token.length() && token[prefix] == ' '; prefix++);
+        for (suffix = token.length(); suffix > prefix && token[suffix-1] == ' '; suffix--);
+        stripped = token.substr (prefix, suffix-prefix);
+        
+        // have to be careful with textual operators and keywords
+        if (i == BAND || i == BOR || i == NOT || i == RETURN ||
+            i == PASS || i == IF || i == ELIF || i == ELSE)
+        {
+            if (pos > 0 && isalpha (code[pos-1]))
+                continue;
+            if (pos < code.length()-operators[i].length()-1 &&
+                isalpha (code[pos+operators[i].length()]))
+                continue;
+        }
 
 #ifdef _DEBUG_
-                std::cout << "token = '" << stripped << "', operator = '" <<
-                    operators[i] << "'\n" << std::flush;
+        std::cout << "token = '" << stripped << "', operator = '" <<
+            operators[i] << "'\n" << std::flush;
 #endif
 
-                // skip functions and arrays
-                if (i == LBRACKET || i == LBRACE)
+        // skip functions and arrays
+        if (i == LBRACKET || i == LBRACE)
+        {
+            begin = pos + 1;
+            continue;
+        }
+
+        // see whether we've got a variable and act accordingly
+        switch (getToken (stripped))
+        {
+            // token is 'self'
+            case LOCAL_VAR:
+            {
+                is_local = true;
+                break;
+            }
+            // token is a character name
+            case CHARACTER:
+            {
+                code.insert (begin+prefix+stripped.length(), "\")");
+                code.insert (begin+prefix, "rpg.character.get_character(\"");
+
+                is_local = false;
+                pos += 31;
+            
+                break;
+            }
+            // token is a quest
+            case QUEST:
+            {
+                // find end of quest
+                
+                break;
+            }
+            // token type cannot be determined
+            case UNKNOWN:
+            {
+                break;
+            }
+            // all the rest
+            default:
+            {
+                break;
+            }
+        }
+        
+        if (getToken (stripped) == VARIABLE)
+        {
+            // make sure we don't have a local variable
+            if (!is_local)
+            {
+                // assignment
+                if (i == ASSIGN)
+                {
+                    code[pos] = ',';
+                    code.insert (begin+suffix, "\"");
+                    code.insert (begin+prefix, "set_val (\"");
+                    code.append (")");
+                    pos += 11;
+                }
+                else
                 {
-                    begin = pos + 1;
-                    break;
+                    code.insert (begin+suffix, "\")");
+                    code.insert (begin+prefix, "get_val (\"");
+                    pos += 12;
                 }
+            }
 
-                // see whether we've got a variable and act accordingly
-                switch (getToken (stripped))
+            // variable left of '.', '==', '!=' or '=' might be a quest
+            if (i == ACCESS || i == EQ || i == NEQ || i == ASSIGN)
+            {
+                // check whether we access the quest- or character array
+                if (dialogue->entry ()->isQuest (stripped))
                 {
-                    // token is 'self'
-                    case LOCAL_VAR:
-                    {
-                        is_local = true;
-                        break;
-                    }
-                    // token is a character name
-                    case CHARACTER:
-                    {
-                        code.insert (begin+prefix+stripped.length(), "\")");
-                        code.insert (begin+prefix, "rpg.character.get_character(\"");
-
-                        is_local = false;
-                        pos += 31;
                     
-                        break;
-                    }
-                    // token is a quest
-                    case QUEST:
-                    {
-                        // find end of quest
-                        
-                        break;
-                    }
-                    // token type cannot be determined
-                    case UNKNOWN:
-                    {
-                        break;
-                    }
-                    // all the rest
-                    default:
-                    {
-                        break;
-                    }
+                    code.insert (begin+prefix+stripped.length(), "\")");
+                    code.insert (begin+prefix, "adonthell.gamedata_get_quest(\"");
+                    pos += 32;
+                    is_local = false;
                 }
-                
-                if (getToken (stripped) == VARIABLE)
+
+                if (dialogue->entry ()->isCharacter (stripped))
                 {
-                    // make sure we don't have a local variable
-                    if (!is_local)
-                    {
-                        // assignment
-                        if (i == ASSIGN)
-                        {
-                            code[pos] = ',';
-                            code.insert (begin+suffix+1, "\"");
-                            code.insert (begin+prefix, "set_val (\"");
-                            code.append (")");
-                            pos += 11;
-                        }
-                        else
-                        {
-                            code.insert (begin+suffix+1, "\")");
-                            code.insert (begin+prefix, "get_val (\"");
-                            pos += 12;
-                        }
-                    }
-
-                    // variable left of '.', '==', '!=' or '=' might be a quest
-                    if (i == ACCESS || i == EQ || i == NEQ || i == ASSIGN)
-                    {
-                        // check whether we access the quest- or character array
-                        if (dialogue->entry ()->isQuest (stripped))
-                        {
-                            
-                            code.insert (begin+prefix+stripped.length(), "\")");
-                            code.insert (begin+prefix, "adonthell.gamedata_get_quest(\"");
-                            pos += 32;
-                            is_local = false;
-                        }
-
-                        if (dialogue->entry ()->isCharacter (stripped))
-                        {
-                            code.insert (begin+prefix+stripped.length(), "\")");
-                            code.insert (begin+prefix, "rpg.character.get_character(\"");
-                            pos += 31;
-                            is_local = false;
-                        }
-                    }
-                    else is_local = true;
+                    code.insert (begin+prefix+stripped.length(), "\")");
+                    code.insert (begin+prefix, "rpg.character.get_character(\"");
+                    pos += 31;
+                    is_local = false;
                 }
+            }
+            else is_local = true;
+        }
 
-                // these are shortcuts for access to the character array, so
-                // we handle them similar
-                if (stripped == the_npc || stripped == the_player)
-                    is_local = false;
+        // these are shortcuts for access to the character array, so
+        // we handle them similar
+        if (stripped == the_npc || stripped == the_player)
+            is_local = false;
 
-                // a trailing comma operator ends an expression
-                if (i == COMMA)
-                    is_local = true;
+        // a trailing comma operator ends an expression
+        if (i == COMMA)
+            is_local = true;
 
-                // skip strings
-                if (i == QUOT || i == SQUOT)
-                    pos = code.find (operators[i], pos+1) - 1;
+        // skip strings, up to the end of the line if unterminated
+        if (i == QUOT || i == SQUOT)
+        {
+            pos = code.find (operators[i], pos+1);
+            pos = (pos == code.npos ? code.length () : pos) - 1;
+        }
 
-                // skip comments
-                if (i == COMMENT)
-                    pos = code.length ();
+        // skip comments
+        if (i == COMMENT)
+            pos = code.length ();
 
-                last_op = operators[i];
-                pos += operators[i].length ();
-                begin = pos;
+        last_op = operators[i];
+        pos += operators[i].length ();
+        begin = pos;
 #ifdef _DEBUG_
-                std::cout << code << std::endl;
-                for (unsigned int j = 0; j < begin; j++) std::cout << " ";
-                std::cout << "^\n";
+        std::cout << code << std::endl;
+        for (unsigned int j = 0; j < begin; j++) std::cout << " ";
+        std::cout << "^\n";
 #endif
-                break;
-            }
+    }
 
 #ifdef _DEBUG_
     std::cout << "<<< " << code << "\n\n";
@@ -516,6 +525,35 @@ std::string DlgCompiler::inflateCode (std::string code)
     return code;
 }
 
+// find the first operator of the table at the given position
+unsigned int DlgCompiler::matchOperator (const std::string &code, const unsigned long &pos)
+{
+    unsigned char c = code[pos];
+
+    // only try operators starting with the character at pos
+    for (int i = firstOperator[c]; i != -1; i = nextOperator[i])
+        if (code.compare (pos, operators[i].length (), operators[i]) == 0)
+            return i;
+
+    return NUM_OPS;
+}
+
+// chain operators by their first character
+bool DlgCompiler::linkOperators ()
+{
+    std::fill (firstOperator, firstOperator + 256, -1);
+
+    // link backwards, so each chain is in the order of the table
+    for (int i = NUM_OPS - 1; i >= 0; i--)
+    {
+        unsigned char c = operators[i][0];
+        nextOperator[i] = firstOperator[c];
+        firstOperator[c] = i;
+    }
+
+    return true;
+}
+
 // write the start of the dialogue
 void DlgCompiler::writeStart ()
 {
@@ -660,7 +698,7 @@ bool DlgCompiler::addCondition (DlgCircle *circle, int idx)
     }
     
     // now get rid of the colon at the end of the condition
-    if (condition[condition.size () - 1] == ':')
+    if (!condition.empty () && condition[condition.size () - 1] == ':')
         condition.erase (condition.size () - 1);
     // if there is none, that's not too tragical, but report it anyway
     else
@@ -677,17 +715,12 @@ bool DlgCompiler::addCondition (DlgCircle *circle, int idx)
         retval = false;
     }
     
-    // now the condition is ready for addition to the condition vector
-    for (std::vector<std::string>::iterator i = conditions.begin (); i != conditions.end (); i++)
-        if (strcmp ((*i).c_str (), condition.c_str ()) == 0)
-        {
-            conditionTable[idx] = distance (conditions.begin (), i);
-            return retval;
-        }
+    // surrounding whitespace makes no difference in a condition
+    unsigned long first = condition.find_first_not_of (" \t\n");
+    condition.erase (0, first == condition.npos ? condition.length () : first);
     
-    // the condition isn't in the table so far, so add it
-    conditionTable[idx] = conditions.size ();
-    conditions.push_back (condition);
+    // now the condition is ready for addition to the condition vector
+    conditionTable[idx] = addSnippet (conditions, conditionIndex, condition);
     
     return retval;
 }
@@ -695,17 +728,35 @@ bool DlgCompiler::addCondition (DlgCircle *circle, int idx)
 // add arbitrary code to the list of code
 void DlgCompiler::addCode (const std::string &cde, int idx)
 {
+    codeTable[idx] = addSnippet (code, codeIndex, cde);
+}
+
+// add code or condition, unless it already exists
+int DlgCompiler::addSnippet (std::vector<std::string> &snippets, 
+    std::hash_map<std::string, int> &index, const std::string &snippet)
+{
+    // trailing whitespace makes no difference either
+    std::string key (snippet, 0, snippet.find_last_not_of (" \t\n") + 1);
+    
     // see if code like this already exists
-    for (std::vector<std::string>::iterator i = code.begin (); i != code.end (); i++)
-        if (strcmp ((*i).c_str (), cde.c_str ()) == 0)
-        {
-            codeTable[idx] = distance (code.begin (), i);
-            return;
-        }
+    std::hash_map<std::string, int>::const_iterator i = index.find (key);
+    if (i != index.end ()) return i->second;
     
     // the code isn't in the table so far, so add it
-    codeTable[idx] = code.size ();
-    code.push_back (cde);
+    index[key] = snippets.size ();
+    snippets.push_back (key);
+    
+    return snippets.size () - 1;
+}
+
+// make room for nodes up to the given index
+void DlgCompiler::growTables (unsigned int size)
+{
+    if (size <= codeTable.size ()) return;
+    
+    codeTable.resize (size, -1);
+    conditionTable.resize (size, -1);
+    operationTable.resize (size, 0);
 }
 
 // check whether PLAYER or NPC/NARRATOR nodes follow the given node
@@ -29,11 +29,15 @@
 #ifndef DLG_COMPILER_H
 #define DLG_COMPILER_H
 
+#include <adonthell/base/hash_map.h>
 #include "dlg_module.h"
 #include "dlg_circle.h"
 
 #define NUM_OPS 33
 #define NUM_FXD 5
+
+/// increase whenever the scripts created by the compiler change
+#define DLG_COMPILER_VERSION 2
     
 /**
  * It transforms the dialogue into the Python script needed by
@@ -52,6 +56,8 @@
  */
 class DlgCompiler
 {
+    friend class DlgCompilerTest;
+
 public:
 	/**
 	 * Python tokens
@@ -113,8 +119,17 @@ public:
     
     /**
      * Compile the module passed to DlgCompiler
+     * @return <b>true</b> if the dialogue compiled without errors,
+     *      <b>false</b> otherwise.
+     */
+    bool run ();
+    
+    /**
+     * Get the name of the Python script a module compiles into.
+     * @param module a dialogue.
+     * @return full path of the script.
      */
-    void run ();
+    static std::string scriptName (DlgModule *module);
     
 private:
     void writeHeader (const std::string &theClass);
@@ -130,6 +145,9 @@ private:
     void addStart (DlgNode *node);
     void addCode (const std::string &cde, int index);
     bool addCondition (DlgCircle *circle, int index);
+    int addSnippet (std::vector<std::string> &snippets, 
+        std::hash_map<std::string, int> &index, const std::string &snippet);
+    void growTables (unsigned int size);
     
     int checkFollowers (DlgCircle *node);
     bool checkConditions (DlgCircle* node);
@@ -137,6 +155,8 @@ private:
     std::string escapeCode (std::string code);
     std::string splitCode (std::string code, int space = 0);
     std::string inflateCode (std::string code);
+    unsigned int matchOperator (const std::string &code, const unsigned long &pos);
+    static bool linkOperators ();
     
     token getKeyword (const std::string &statement);
     token getToken (const std::string &statement);
@@ -147,15 +167,21 @@ private:
     DlgCircle start;                // Start node of the dialogue
     std::vector<std::string> code;  // Temporary storage for all code
     std::vector<std::string> conditions; // Temporary storage for all conditions
+    std::hash_map<std::string, int> codeIndex;      // Position of code in the above
+    std::hash_map<std::string, int> conditionIndex; // Position of conditions in the above
     std::vector<int> loop;          // nodes that are allowed to looped
     int errors;                     // number of errors in dialogue
     
-    int *codeTable;                 // Mapping between nodes and code
-    int *conditionTable;            // Mapping between nodes and conditions
-    int *operationTable;            // Mapping between nodes and condition type
+    std::vector<int> codeTable;     // Mapping between nodes and code
+    std::vector<int> conditionTable;// Mapping between nodes and conditions
+    std::vector<int> operationTable;// Mapping between nodes and condition type
 
     static std::string operators[NUM_OPS];
     static std::string fixed[NUM_FXD];
+    
+    static int firstOperator[256];  // First operator starting with a character
+    static int nextOperator[NUM_OPS]; // Next operator with same first character
+    static bool operatorsLinked;    // Whether the two tables above are set up
 };
 
 #endif // DLG_COMPILER_H
@@ -0,0 +1,624 @@
+/*
+   Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+   Part of the Adonthell Project http://adonthell.linuxgames.com
+
+   Dlgedit is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   Dlgedit is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Dlgedit; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ * @file dlg_layout.cc
+ *
+ * @author Kai Sterker
+ * @brief Arranges the nodes of a dialogue.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include "dlg_arrow.h"
+#include "dlg_layout.h"
+
+/// how often rows are sorted at most to reduce crossing arrows
+#define DLG_LAYOUT_SWEEPS 8
+/// how often rows are moved towards their neighbours
+#define DLG_LAYOUT_PASSES 4
+/// space between two vertices of a row, in multiples of CIRCLE_DIAMETER
+#define DLG_LAYOUT_GAP 1
+/// space between two rows, in multiples of CIRCLE_DIAMETER
+#define DLG_LAYOUT_ROW_GAP 2
+
+// sort the arrows of a circle by the position of the circles they link to
+static void sortArrows (DlgNode *node)
+{
+    std::vector<DlgNode*> arrows;
+
+    for (DlgNode *a = node->next (FIRST); a != NULL; a = node->next (NEXT))
+        arrows.push_back (a);
+    for (std::vector<DlgNode*>::iterator i = arrows.begin (); i != arrows.end (); i++)
+        node->removeNext (*i);
+    for (std::vector<DlgNode*>::iterator i = arrows.begin (); i != arrows.end (); i++)
+        node->addNext (*i);
+
+    arrows.clear ();
+
+    for (DlgNode *a = node->prev (FIRST); a != NULL; a = node->prev (NEXT))
+        arrows.push_back (a);
+    for (std::vector<DlgNode*>::iterator i = arrows.begin (); i != arrows.end (); i++)
+        node->removePrev (*i);
+    for (std::vector<DlgNode*>::iterator i = arrows.begin (); i != arrows.end (); i++)
+        node->addPrev (*i);
+}
+
+// ctor
+DlgLayout::DlgLayout (DlgModule *module)
+{
+    Module = module;
+}
+
+// arrange all nodes or those following start
+bool DlgLayout::arrange (DlgNode *start)
+{
+    if (Module == NULL) return false;
+
+    // arrows are arranged along with their circles
+    if (start != NULL && start->type () == LINK) start = start->next (FIRST);
+
+    collect (start);
+    if (Nodes.empty ()) return false;
+
+    breakCycles ();
+    assignLayers ();
+    buildLayers ();
+    orderLayers ();
+    assignCoordinates ();
+    apply (start);
+
+    return true;
+}
+
+// collect circles and arrows between them
+void DlgLayout::collect (DlgNode *start)
+{
+    Nodes.clear ();
+    Index.clear ();
+
+    if (start == NULL)
+    {
+        std::vector<DlgNode*> &nodes = Module->getNodes ();
+        for (std::vector<DlgNode*>::iterator i = nodes.begin (); i != nodes.end (); i++)
+        {
+            if ((*i)->type () == LINK) continue;
+
+            Index[*i] = Nodes.size ();
+            Nodes.push_back (*i);
+        }
+    }
+    else
+    {
+        // the start node and everything that follows it
+        Index[start] = 0;
+        Nodes.push_back (start);
+
+        for (unsigned int i = 0; i < Nodes.size (); i++)
+        {
+            DlgNode *node = Nodes[i];
+            for (DlgNode *a = node->next (FIRST); a != NULL; a = node->next (NEXT))
+            {
+                DlgNode *child = a->next (FIRST);
+                if (child == NULL || Index.find (child) != Index.end ()) continue;
+
+                Index[child] = Nodes.size ();
+                Nodes.push_back (child);
+            }
+        }
+    }
+
+    // children of each circle, in the order of its arrows
+    int count = Nodes.size ();
+    std::vector<int> seen (count, -1);
+
+    Children.assign (count, std::vector<int> ());
+    for (int i = 0; i < count; i++)
+    {
+        DlgNode *node = Nodes[i];
+        for (DlgNode *a = node->next (FIRST); a != NULL; a = node->next (NEXT))
+        {
+            std::map<DlgNode*, int>::iterator child = Index.find (a->next (FIRST));
+            if (child == Index.end ()) continue;
+
+            // skip circles linked to themselves or linked twice
+            int j = child->second;
+            if (j == i || seen[j] == i) continue;
+
+            seen[j] = i;
+            Children[i].push_back (j);
+        }
+    }
+}
+
+// turn around arrows leading back
+void DlgLayout::breakCycles ()
+{
+    int count = Nodes.size ();
+    std::vector<int> parents (count, 0);
+
+    for (int i = 0; i < count; i++)
+        for (std::vector<int>::iterator c = Children[i].begin (); c != Children[i].end (); c++)
+            parents[*c]++;
+
+    // start with circles nothing leads to, then with those in loops
+    std::vector<int> roots;
+    for (int i = 0; i < count; i++)
+        if (parents[i] == 0) roots.push_back (i);
+    for (int i = 0; i < count; i++)
+        if (parents[i] != 0) roots.push_back (i);
+
+    // 0 = not visited yet, 1 = on the current path, 2 = done
+    std::vector<int> state (count, 0);
+    std::vector<std::vector<int> > result (count);
+    std::vector<std::pair<int, unsigned int> > path;
+
+    for (std::vector<int>::iterator r = roots.begin (); r != roots.end (); r++)
+    {
+        if (state[*r] != 0) continue;
+
+        state[*r] = 1;
+        path.push_back (std::make_pair (*r, 0u));
+
+        while (!path.empty ())
+        {
+            int v = path.back ().first;
+            if (path.back ().second == Children[v].size ())
+            {
+                state[v] = 2;
+                path.pop_back ();
+                continue;
+            }
+
+            int c = Children[v][path.back ().second++];
+
+            // an arrow back to a circle on the current path closes a loop
+            if (state[c] == 1)
+            {
+                result[c].push_back (v);
+                continue;
+            }
+
+            result[v].push_back (c);
+            if (state[c] == 0)
+            {
+                state[c] = 1;
+                path.push_back (std::make_pair (c, 0u));
+            }
+        }
+    }
+
+    // circles linked both ways are now linked twice
+    std::vector<int> seen (count, -1);
+    for (int i = 0; i < count; i++)
+    {
+        std::vector<int> &children = result[i];
+        std::vector<int>::iterator last = children.begin ();
+
+        for (std::vector<int>::iterator c = children.begin (); c != children.end (); c++)
+        {
+            if (seen[*c] == i) continue;
+            seen[*c] = i;
+            *last++ = *c;
+        }
+
+        children.erase (last, children.end ());
+    }
+
+    Children.swap (result);
+}
+
+// put each circle below its parents
+void DlgLayout::assignLayers ()
+{
+    int count = Nodes.size ();
+    std::vector<int> parents (count, 0);
+
+    for (int i = 0; i < count; i++)
+        for (std::vector<int>::iterator c = Children[i].begin (); c != Children[i].end (); c++)
+            parents[*c]++;
+
+    // a circle is placed once all its parents are
+    std::vector<int> ready;
+    for (int i = 0; i < count; i++)
+        if (parents[i] == 0) ready.push_back (i);
+
+    Rank.assign (count, 0);
+    for (unsigned int i = 0; i < ready.size (); i++)
+    {
+        int v = ready[i];
+        for (std::vector<int>::iterator c = Children[v].begin (); c != Children[v].end (); c++)
+        {
+            Rank[*c] = std::max (Rank[*c], Rank[v] + 1);
+            if (--parents[*c] == 0) ready.push_back (*c);
+        }
+    }
+}
+
+// create vertices and their initial order
+void DlgLayout::buildLayers ()
+{
+    int count = Nodes.size ();
+    int layers = 0;
+
+    Vertices.assign (count, vertex ());
+    for (int i = 0; i < count; i++)
+    {
+        Vertices[i].Layer = Rank[i];
+        Vertices[i].Order = 0;
+        Vertices[i].Width = std::max (1, (Nodes[i]->width () + CIRCLE_DIAMETER - 1) / CIRCLE_DIAMETER);
+        Vertices[i].X = 0.0;
+
+        layers = std::max (layers, Rank[i] + 1);
+    }
+
+    // arrows spanning several rows get a placeholder in each row they pass
+    for (int i = 0; i < count; i++)
+    {
+        for (std::vector<int>::iterator c = Children[i].begin (); c != Children[i].end (); c++)
+        {
+            int from = i;
+            for (int layer = Rank[i] + 1; layer < Rank[*c]; layer++)
+            {
+                vertex placeholder;
+                placeholder.Layer = layer;
+                placeholder.Order = 0;
+                placeholder.Width = 0;
+                placeholder.X = 0.0;
+                placeholder.Up.push_back (from);
+
+                int v = Vertices.size ();
+                Vertices.push_back (placeholder);
+                Vertices[from].Down.push_back (v);
+                from = v;
+            }
+
+            Vertices[from].Down.push_back (*c);
+            Vertices[*c].Up.push_back (from);
+        }
+    }
+
+    // start with the order in which vertices are reached from the top, so
+    // that whatever follows a circle is kept together
+    Layers.assign (layers, std::vector<int> ());
+
+    std::vector<bool> placed (Vertices.size (), false);
+    std::vector<std::pair<int, unsigned int> > path;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (Rank[i] != 0) continue;
+
+        placed[i] = true;
+        Vertices[i].Order = Layers[0].size ();
+        Layers[0].push_back (i);
+        path.push_back (std::make_pair (i, 0u));
+
+        while (!path.empty ())
+        {
+            vertex &v = Vertices[path.back ().first];
+            if (path.back ().second == v.Down.size ())
+            {
+                path.pop_back ();
+                continue;
+            }
+
+            int c = v.Down[path.back ().second++];
+            if (placed[c]) continue;
+
+            std::vector<int> &layer = Layers[Vertices[c].Layer];
+            placed[c] = true;
+            Vertices[c].Order = layer.size ();
+            layer.push_back (c);
+            path.push_back (std::make_pair (c, 0u));
+        }
+    }
+}
+
+// reduce crossing arrows
+void DlgLayout::orderLayers ()
+{
+    int layers = Layers.size ();
+    if (layers < 2) return;
+
+    unsigned long least = countCrossings ();
+    std::vector<std::vector<int> > best = Layers;
+
+    for (int i = 0; i < DLG_LAYOUT_SWEEPS && least > 0; i++)
+    {
+        for (int layer = 1; layer < layers; layer++)
+            sortLayer (layer, true);
+        for (int layer = layers - 2; layer >= 0; layer--)
+            sortLayer (layer, false);
+
+        // stop once sorting no longer helps
+        unsigned long crossings = countCrossings ();
+        if (crossings >= least) break;
+
+        least = crossings;
+        best = Layers;
+    }
+
+    // keep the order with the fewest crossings
+    Layers.swap (best);
+    for (int layer = 0; layer < layers; layer++)
+        for (unsigned int i = 0; i < Layers[layer].size (); i++)
+            Vertices[Layers[layer][i]].Order = i;
+}
+
+// sort row by the place of linked vertices
+void DlgLayout::sortLayer (const int & layer, const bool & down)
+{
+    std::vector<int> &row = Layers[layer];
+    std::vector<std::pair<double, int> > keys;
+
+    for (unsigned int i = 0; i < row.size (); i++)
+    {
+        const std::vector<int> &linked = down ? Vertices[row[i]].Up : Vertices[row[i]].Down;
+
+        // vertices not linked that way stay where they are
+        double key = i;
+        if (!linked.empty ())
+        {
+            key = 0.0;
+            for (std::vector<int>::const_iterator l = linked.begin (); l != linked.end (); l++)
+                key += Vertices[*l].Order;
+            key /= linked.size ();
+        }
+
+        // ties keep their current order
+        keys.push_back (std::make_pair (key, i));
+    }
+
+    std::sort (keys.begin (), keys.end ());
+
+    std::vector<int> sorted (row.size ());
+    for (unsigned int i = 0; i < keys.size (); i++)
+    {
+        sorted[i] = row[keys[i].second];
+        Vertices[sorted[i]].Order = i;
+    }
+
+    row.swap (sorted);
+}
+
+// count crossing arrows
+unsigned long DlgLayout::countCrossings () const
+{
+    unsigned long crossings = 0;
+    std::vector<int> ends;
+    std::vector<unsigned long> tree;
+
+    for (unsigned int layer = 0; layer + 1 < Layers.size (); layer++)
+    {
+        // ends of the arrows in the row below, sorted by where they start
+        ends.clear ();
+        for (std::vector<int>::const_iterator v = Layers[layer].begin (); v != Layers[layer].end (); v++)
+        {
+            unsigned int first = ends.size ();
+            for (std::vector<int>::const_iterator c = Vertices[*v].Down.begin (); c != Vertices[*v].Down.end (); c++)
+                ends.push_back (Vertices[*c].Order);
+
+            std::sort (ends.begin () + first, ends.end ());
+        }
+
+        // an arrow crosses all earlier arrows that end further right
+        int size = Layers[layer + 1].size ();
+        tree.assign (size + 1, 0);
+
+        for (unsigned int i = 0; i < ends.size (); i++)
+        {
+            unsigned long right = i;
+            for (int k = ends[i] + 1; k > 0; k -= k & -k)
+                right -= tree[k];
+            for (int k = ends[i] + 1; k <= size; k += k & -k)
+                tree[k]++;
+
+            crossings += right;
+        }
+    }
+
+    return crossings;
+}
+
+// move vertices towards their neighbours
+void DlgLayout::assignCoordinates ()
+{
+    int layers = Layers.size ();
+
+    // start with all rows packed to the left
+    for (int layer = 0; layer < layers; layer++)
+    {
+        int x = 0;
+        for (std::vector<int>::iterator v = Layers[layer].begin (); v != Layers[layer].end (); v++)
+        {
+            Vertices[*v].X = x;
+            x += Vertices[*v].Width + DLG_LAYOUT_GAP;
+        }
+    }
+
+    // ending with the upward pass centers parents above their children
+    for (int i = 0; i < DLG_LAYOUT_PASSES; i++)
+    {
+        for (int layer = 1; layer < layers; layer++)
+            placeLayer (layer, true);
+        for (int layer = layers - 2; layer >= 0; layer--)
+            placeLayer (layer, false);
+    }
+
+    // align to the grid, without letting vertices overlap
+    for (int layer = 0; layer < layers; layer++)
+    {
+        double min_x = 0.0;
+        for (std::vector<int>::iterator v = Layers[layer].begin (); v != Layers[layer].end (); v++)
+        {
+            vertex &vx = Vertices[*v];
+            vx.X = floor (vx.X + 0.5);
+            if (v != Layers[layer].begin () && vx.X < min_x) vx.X = min_x;
+
+            min_x = vx.X + vx.Width + DLG_LAYOUT_GAP;
+        }
+    }
+}
+
+// move row towards linked vertices
+void DlgLayout::placeLayer (const int & layer, const bool & down)
+{
+    std::vector<int> &row = Layers[layer];
+    int size = row.size ();
+
+    // distance of each vertex from the left of the packed row
+    std::vector<double> packed (size);
+    // groups of neighbouring vertices that have to be moved together
+    std::vector<double> sum;
+    std::vector<int> members;
+
+    double x = 0.0;
+    for (int i = 0; i < size; i++)
+    {
+        const vertex &v = Vertices[row[i]];
+        const std::vector<int> &linked = down ? v.Up : v.Down;
+
+        // the left edge that centers the vertex below or above those linked
+        double desired = v.X;
+        if (!linked.empty ())
+        {
+            desired = 0.0;
+            for (std::vector<int>::const_iterator l = linked.begin (); l != linked.end (); l++)
+                desired += Vertices[*l].X + Vertices[*l].Width / 2.0;
+            desired = desired / linked.size () - v.Width / 2.0;
+        }
+
+        packed[i] = x;
+        x += v.Width + DLG_LAYOUT_GAP;
+
+        // a vertex that wants to go further left than its left neighbour
+        // permits is moved together with that neighbour, to the average
+        // of the places both want to go
+        sum.push_back (desired - packed[i]);
+        members.push_back (1);
+
+        while (sum.size () > 1)
+        {
+            int last = sum.size () - 1;
+            if (sum[last - 1] * members[last] <= sum[last] * members[last - 1]) break;
+
+            sum[last - 1] += sum[last];
+            members[last - 1] += members[last];
+            sum.pop_back ();
+            members.pop_back ();
+        }
+    }
+
+    int i = 0;
+    for (unsigned int g = 0; g < sum.size (); g++)
+    {
+        double offset = sum[g] / members[g];
+        for (int j = 0; j < members[g]; j++, i++)
+            Vertices[row[i]].X = offset + packed[i];
+    }
+}
+
+// move circles to their new place
+void DlgLayout::apply (DlgNode *start)
+{
+    int count = Nodes.size ();
+    int layers = Layers.size ();
+
+    // each row starts below the tallest circle of the previous row
+    std::vector<int> top (layers, (DLG_LAYOUT_ROW_GAP + 1) * CIRCLE_DIAMETER);
+    top[0] = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        int layer = Rank[i] + 1;
+        if (layer == layers) continue;
+
+        int height = Nodes[i]->height () + (DLG_LAYOUT_ROW_GAP + 1) * CIRCLE_DIAMETER - 1;
+        top[layer] = std::max (top[layer], height - height % CIRCLE_DIAMETER);
+    }
+    for (int layer = 1; layer < layers; layer++)
+        top[layer] += top[layer - 1];
+
+    std::vector<DlgPoint> pos;
+    for (int i = 0; i < count; i++)
+        pos.push_back (DlgPoint ((int) Vertices[i].X * CIRCLE_DIAMETER, top[Rank[i]]));
+
+    // keep the start node or the upper left corner in place
+    int x, y, new_x, new_y;
+    if (start != NULL)
+    {
+        x = start->x ();
+        y = start->y ();
+        new_x = pos[0].x ();
+        new_y = pos[0].y ();
+    }
+    else
+    {
+        x = Nodes[0]->x ();
+        y = Nodes[0]->y ();
+        new_x = pos[0].x ();
+        new_y = pos[0].y ();
+
+        for (int i = 1; i < count; i++)
+        {
+            x = std::min (x, Nodes[i]->x ());
+            y = std::min (y, Nodes[i]->y ());
+            new_x = std::min (new_x, pos[i].x ());
+            new_y = std::min (new_y, pos[i].y ());
+        }
+    }
+
+    x -= x % CIRCLE_DIAMETER + new_x;
+    y -= y % CIRCLE_DIAMETER + new_y;
+
+    for (int i = 0; i < count; i++)
+    {
+        pos[i].move (x, y);
+        Nodes[i]->setPos (pos[i]);
+    }
+
+    // arrows are sorted by the place of the circles they link to
+    std::set<DlgNode*> linked (Nodes.begin (), Nodes.end ());
+    for (int i = 0; i < count; i++)
+    {
+        DlgNode *node = Nodes[i];
+        for (DlgNode *a = node->prev (FIRST); a != NULL; a = node->prev (NEXT))
+            linked.insert (a->prev (FIRST));
+        for (DlgNode *a = node->next (FIRST); a != NULL; a = node->next (NEXT))
+            linked.insert (a->next (FIRST));
+    }
+
+    for (std::set<DlgNode*>::iterator i = linked.begin (); i != linked.end (); i++)
+        if (*i != NULL) sortArrows (*i);
+
+    // and follow the circles
+    for (int i = 0; i < count; i++)
+    {
+        DlgNode *node = Nodes[i];
+        for (DlgNode *a = node->prev (FIRST); a != NULL; a = node->prev (NEXT))
+            ((DlgArrow *) a)->initShape ();
+        for (DlgNode *a = node->next (FIRST); a != NULL; a = node->next (NEXT))
+            ((DlgArrow *) a)->initShape ();
+    }
+
+    for (int i = 0; i < count; i++)
+        Module->updateNode (Nodes[i]);
+}
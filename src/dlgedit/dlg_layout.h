@@ -0,0 +1,179 @@
+/*
+   Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+   Part of the Adonthell Project http://adonthell.linuxgames.com
+
+   Dlgedit is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   Dlgedit is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Dlgedit; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ * @file dlg_layout.h
+ *
+ * @author Kai Sterker
+ * @brief Arranges the nodes of a dialogue.
+ */
+
+#ifndef DLG_LAYOUT_H
+#define DLG_LAYOUT_H
+
+#include <map>
+#include <vector>
+
+#include "dlg_module.h"
+
+/**
+ * Arranges the circles of a dialogue in rows, so that the dialogue
+ * reads from top to bottom. Each circle is placed below the circles
+ * leading to it, with as few arrows crossing each other as possible.
+ *
+ * This is done in four steps:
+ * - arrows leading back to an earlier part of the dialogue are turned
+ *   around, so that no loops are left,
+ * - each circle is assigned to the row below the lowest of the circles
+ *   leading to it,
+ * - arrows spanning several rows get a placeholder in each row they
+ *   pass, and the circles of each row are sorted by the average place
+ *   of their neighbours in the row above or below,
+ * - finally, the circles are moved as close to their neighbours as the
+ *   space in their row permits.
+ *
+ * The result only depends on the dialogue itself, so arranging the
+ * same dialogue twice yields the same layout. As no GUI is required,
+ * dialogues can be arranged from the command line as well.
+ */
+class DlgLayout
+{
+public:
+    /**
+     * Create a layout for the given dialogue.
+     * @param module the dialogue whose nodes to arrange.
+     */
+    DlgLayout (DlgModule *module);
+
+    /**
+     * Arrange the nodes of the dialogue. Either all of them, keeping
+     * the upper left corner of the dialogue in place, or only the given
+     * node and all nodes that can be reached from it, keeping the given
+     * node in place.
+     * @param start node to start from, or \b NULL to arrange all nodes.
+     * @return \b true if nodes have been arranged, \b false if there
+     *         were none.
+     */
+    bool arrange (DlgNode *start = NULL);
+
+private:
+    /**
+     * A circle of the dialogue, or a placeholder for an arrow passing
+     * through a row.
+     */
+    struct vertex
+    {
+        /// the row of the vertex
+        int Layer;
+        /// the place of the vertex within its row
+        int Order;
+        /// width of the vertex, in multiples of CIRCLE_DIAMETER
+        int Width;
+        /// left edge of the vertex, in multiples of CIRCLE_DIAMETER
+        double X;
+        /// vertices in the row above, linked to this one
+        std::vector<int> Up;
+        /// vertices in the row below, linked to this one
+        std::vector<int> Down;
+    };
+
+    /**
+     * Collect the circles to arrange and the arrows between them.
+     * @param start node to start from, or \b NULL to collect all nodes.
+     */
+    void collect (DlgNode *start);
+
+    /**
+     * Turn around arrows leading back to an earlier part of the
+     * dialogue, so that the remaining graph contains no loops.
+     */
+    void breakCycles ();
+
+    /**
+     * Assign each circle to the row below the lowest of its parents.
+     */
+    void assignLayers ();
+
+    /**
+     * Create the vertices, with placeholders where arrows span
+     * several rows, and put them in their initial order.
+     */
+    void buildLayers ();
+
+    /**
+     * Sort the vertices of each row to reduce the number of crossing
+     * arrows.
+     */
+    void orderLayers ();
+
+    /**
+     * Sort one row by the average place of the linked vertices in
+     * the row above or below.
+     * @param layer the row to sort.
+     * @param down \b true to sort by the row above, \b false to sort
+     *        by the row below.
+     */
+    void sortLayer (const int & layer, const bool & down);
+
+    /**
+     * Count the arrows crossing each other between all rows.
+     * @return the number of crossings.
+     */
+    unsigned long countCrossings () const;
+
+    /**
+     * Move the vertices of each row as close to the vertices linked
+     * to them as their neighbours in the row permit.
+     */
+    void assignCoordinates ();
+
+    /**
+     * Move the vertices of one row as close to the average place of
+     * the linked vertices in the row above or below as possible,
+     * without changing their order or letting them overlap.
+     * @param layer the row to place.
+     * @param down \b true to place by the row above, \b false to place
+     *        by the row below.
+     */
+    void placeLayer (const int & layer, const bool & down);
+
+    /**
+     * Move the circles to their new place and update the arrows.
+     * @param start the node to keep in place, or \b NULL to keep the
+     *        upper left corner of all nodes in place.
+     */
+    void apply (DlgNode *start);
+
+    /// the dialogue to arrange
+    DlgModule *Module;
+    /// the circles to arrange
+    std::vector<DlgNode*> Nodes;
+    /// index of each circle in Nodes
+    std::map<DlgNode*, int> Index;
+    /// children of each circle, with loops turned around
+    std::vector<std::vector<int> > Children;
+    /// row of each circle
+    std::vector<int> Rank;
+    /// the circles, followed by the placeholders for arrows
+    std::vector<vertex> Vertices;
+    /// the vertices in each row, from left to right
+    std::vector<std::vector<int> > Layers;
+};
+
+#endif // DLG_LAYOUT_H
@@ -0,0 +1,261 @@
+/*
+   Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+   Part of the Adonthell Project http://adonthell.linuxgames.com
+
+   Dlgedit is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   Dlgedit is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Dlgedit; if not, write to the Free Software 
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/** 
+ * @file dlg_loader.cc
+ *
+ * @author Kai Sterker
+ * @brief Reads the tokens of a dialogue source file.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "dlg_loader.h"
+#include "dlg_types.h"
+
+/// strings are enclosed in section signs (ISO-8859-1)
+#define TEXT_DELIMITER '\247'
+
+/**
+ * A keyword of the dialogue source.
+ */
+struct dlg_keyword
+{
+    /// the keyword
+    const char *Name;
+    /// length of the keyword
+    u_int32 Length;
+    /// token returned for the keyword
+    int Token;
+};
+
+/// all keywords, which need not be followed by whitespace
+static const dlg_keyword Keywords[] = {
+    { "Circle", 6, LOAD_CIRCLE },
+    { "Arrow", 5, LOAD_ARROW },
+    { "End", 3, LOAD_END },
+    { "Type", 4, LOAD_TYPE },
+    { "Prev", 4, LOAD_PREV },
+    { "Next", 4, LOAD_NEXT },
+    { "Link", 4, LOAD_LINK },
+    { "Pos", 3, LOAD_POS },
+    { "Note", 4, LOAD_NOTE },
+    { "Text", 4, LOAD_TEXT },
+    { "Cond", 4, LOAD_COND },
+    { "Vars", 4, LOAD_VARS },
+    { "Func", 4, LOAD_FUNC },
+    { "NPC", 3, LOAD_NPC },
+    { "Name", 4, LOAD_NAME },
+    { "Race", 4, LOAD_RACE },
+    { "Gender", 6, LOAD_GENDER },
+    { "Loop", 4, LOAD_LOOP },
+    { "Proj", 4, LOAD_PROJECT },
+    { "Inc", 3, LOAD_IMPORTS },
+    { "Dtor", 4, LOAD_DTOR },
+    { "Ctor", 4, LOAD_CTOR },
+    { "Id", 2, LOAD_ID },
+    { "Module", 6, LOAD_MODULE },
+    { NULL, 0, 0 }
+};
+
+// ctor
+DlgLoader::DlgLoader ()
+{
+    Data = NULL;
+    Size = 0;
+    Pos = 0;
+    Start = 0;
+    Text = NULL;
+    Length = 0;
+    Unknown = (u_int32) -1;
+    ModuleName = false;
+}
+
+// dtor
+DlgLoader::~DlgLoader ()
+{
+    close ();
+}
+
+// map file into memory
+bool DlgLoader::open (const std::string & file)
+{
+    close ();
+    
+    int fd = ::open (file.c_str (), O_RDONLY);
+    if (fd == -1) return false;
+    
+    struct stat statbuf;
+    if (fstat (fd, &statbuf) != 0 || !S_ISREG (statbuf.st_mode))
+    {
+        ::close (fd);
+        return false;
+    }
+    
+    // an empty file is fine, but cannot be mapped
+    if (statbuf.st_size > 0)
+    {
+        void *data = mmap (NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            fprintf (stderr, "*** DlgLoader::open: cannot map '%s' into memory\n", file.c_str ());
+            ::close (fd);
+            return false;
+        }
+        
+        Data = (const char *) data;
+        Size = statbuf.st_size;
+    }
+    
+    ::close (fd);
+    Filename = file;
+    return true;
+}
+
+// release file
+void DlgLoader::close ()
+{
+    if (Data != NULL) munmap ((void *) Data, Size);
+    
+    Filename = "";
+    Data = NULL;
+    Size = 0;
+    Pos = 0;
+    Start = 0;
+    Text = NULL;
+    Length = 0;
+    Unknown = (u_int32) -1;
+    ModuleName = false;
+}
+
+// get next token
+int DlgLoader::next (std::string & str, int & num)
+{
+    int token = scan (num);
+    if (token == LOAD_STR) str.assign (Text, Length);
+    
+    return token;
+}
+
+// print error with position in file
+void DlgLoader::error (const std::string & msg) const
+{
+    u_int32 line = 1, column = 1;
+    
+    for (u_int32 i = 0; i < Start && i < Size; i++)
+    {
+        if (Data[i] == '\n')
+        {
+            line++;
+            column = 1;
+        }
+        else column++;
+    }
+    
+    fprintf (stderr, "*** DlgLoader: %s:%u:%u: %s\n", Filename.c_str (), line, column, msg.c_str ());
+}
+
+// split file into tokens
+int DlgLoader::scan (int & num)
+{
+    while (Pos < Size)
+    {
+        Start = Pos;
+        char c = Data[Pos];
+        
+        if (isSpace (c))
+        {
+            Pos++;
+            continue;
+        }
+        
+        // name of a sub-dialogue, up to the next whitespace
+        if (ModuleName)
+        {
+            while (Pos < Size && !isSpace (Data[Pos])) Pos++;
+            
+            ModuleName = false;
+            Text = Data + Start;
+            Length = Pos - Start;
+            return LOAD_STR;
+        }
+        
+        // eat up comments
+        if (c == '#')
+        {
+            const char *eol = (const char *) memchr (Data + Pos, '\n', Size - Pos);
+            Pos = (eol == NULL ? Size : eol - Data + 1);
+            continue;
+        }
+        
+        // text, which may span several lines
+        if (c == TEXT_DELIMITER)
+        {
+            const char *end = (const char *) memchr (Data + Pos + 1, TEXT_DELIMITER, Size - Pos - 1);
+            if (end == NULL)
+            {
+                error ("text is never closed");
+                Pos = Size;
+                return 0;
+            }
+            
+            Text = Data + Pos + 1;
+            Length = end - Text;
+            Pos = end - Data + 1;
+            return LOAD_STR;
+        }
+        
+        // numbers, possibly negative
+        u_int32 digits = (c == '-' ? Pos + 1 : Pos);
+        if (digits < Size && Data[digits] >= '0' && Data[digits] <= '9')
+        {
+            long value = 0;
+            for (Pos = digits; Pos < Size && Data[Pos] >= '0' && Data[Pos] <= '9'; Pos++)
+                value = value * 10 + (Data[Pos] - '0');
+            
+            num = (int) (c == '-' ? -value : value);
+            return LOAD_NUM;
+        }
+        
+        // keywords
+        for (const dlg_keyword *k = Keywords; k->Name != NULL; k++)
+        {
+            if (k->Name[0] == c && Size - Pos >= k->Length && 
+                memcmp (Data + Pos, k->Name, k->Length) == 0)
+            {
+                Pos += k->Length;
+                if (k->Token == LOAD_MODULE) ModuleName = true;
+                return k->Token;
+            }
+        }
+        
+        // anything else is unknown, but only complain once per word
+        if (Start != Unknown) error (std::string ("unexpected '") + c + "'");
+        Unknown = ++Pos;
+        return LOAD_UNKNOWN;
+    }
+    
+    // end of file
+    Start = Size;
+    return 0;
+}
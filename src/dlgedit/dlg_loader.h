@@ -0,0 +1,132 @@
+/*
+   Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+   Part of the Adonthell Project http://adonthell.linuxgames.com
+
+   Dlgedit is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   Dlgedit is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Dlgedit; if not, write to the Free Software 
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/** 
+ * @file dlg_loader.h
+ *
+ * @author Kai Sterker
+ * @brief Reads the tokens of a dialogue source file.
+ */
+
+#ifndef DLG_LOADER_H
+#define DLG_LOADER_H
+
+#include <string>
+#include <adonthell/base/types.h>
+
+/**
+ * Splits a dialogue source file into the tokens defined in
+ * dlg_types.h. The file is mapped into memory and scanned in place,
+ * so strings are only copied once they are handed out.
+ *
+ * Each file gets a loader of its own and all state is kept in the
+ * loader. Sub-dialogues can thus be nested as deep as required, and
+ * files may be loaded by several threads at the same time.
+ */
+class DlgLoader
+{
+public:
+    /**
+     * Create a loader without a file.
+     */
+    DlgLoader ();
+    
+    /**
+     * Release the file, if any.
+     */
+    ~DlgLoader ();
+    
+    /**
+     * Map the given dialogue source into memory.
+     * @param file full path of the dialogue.
+     * @return <b>true</b> on success, <b>false</b> otherwise.
+     */
+    bool open (const std::string & file);
+    
+    /**
+     * Release the file opened last.
+     */
+    void close ();
+    
+    /**
+     * Read the next token from file.
+     * @param str used to return string values
+     * @param num used to return numeric values
+     * @return Type of token read as defined in dlg_types.h, 0 at the
+     *      end of the file.
+     */
+    int next (std::string & str, int & num);
+    
+    /**
+     * Print an error, along with line and column of the token
+     * read last.
+     * @param msg the error message.
+     */
+    void error (const std::string & msg) const;
+    
+    /**
+     * Get the name of the file being read.
+     * @return full path of the dialogue.
+     */
+    const std::string & filename () const { return Filename; }
+    
+private:
+    /**
+     * Forbid copy construction.
+     */
+    DlgLoader (const DlgLoader & loader);
+    
+    /**
+     * Read the next token, leaving strings in the file.
+     * @param num used to return numeric values
+     * @return Type of token read.
+     */
+    int scan (int & num);
+    
+    /**
+     * Check whether the given character ends a token.
+     * @param c a character.
+     * @return <b>true</b> for whitespace, <b>false</b> otherwise.
+     */
+    static bool isSpace (const char & c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+    
+    /// full path of the dialogue
+    std::string Filename;
+    /// contents of the file
+    const char *Data;
+    /// size of the file
+    u_int32 Size;
+    /// position of the next token
+    u_int32 Pos;
+    /// position of the token read last
+    u_int32 Start;
+    /// the string read last, inside the file
+    const char *Text;
+    /// length of the string read last
+    u_int32 Length;
+    /// position after the unknown character read last
+    u_int32 Unknown;
+    /// whether a module name is expected next
+    bool ModuleName;
+};
+
+#endif // DLG_LOADER_H
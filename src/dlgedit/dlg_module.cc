@@ -27,9 +27,17 @@
 #include <algorithm>
 #include "dlg_module.h"
 #include "dlg_arrow.h"
+#include "dlg_loader.h"
 #include "gui_dlgedit.h"
 #include "gui_resources.h"
 
+// remove id from the index, unless it refers to a different node
+template<class T> static void unindex (std::hash_map<int, T*> &index, int id, T *node)
+{
+    typename std::hash_map<int, T*>::iterator i = index.find (id);
+    if (i != index.end () && i->second == node) index.erase (i);
+}
+
 // ctor
 DlgModule::DlgModule (std::string p, std::string n, std::string u, std::string d)
 {
@@ -44,7 +52,8 @@ DlgModule::DlgModule (std::string p, std::string n, std::string u, std::string d
 // dtor
 DlgModule::~DlgModule ()
 {
-    GuiDlgedit::window->tree ()->removeModule (this);
+    // there is no main window when compiling from the command line
+    if (GuiDlgedit::window) GuiDlgedit::window->tree ()->removeModule (this);
 }
 
 // initialize a newly constructed DlgModule
@@ -59,14 +68,36 @@ void DlgModule::init ()
     changed_ = false;
     displayed_ = false;
     nid_ = 0;
+    mid_ = 0;
     serial_ = 1;
 }
 
 // reset dialogue to initial state
 void DlgModule::clear ()
 {
-    // delete all nodes
-    while (!nodes.empty ()) deleteNode (nodes.front ());
+    std::vector<DlgNode*>::iterator i;
+    
+    // delete all arrows first, as they detach from their circles ...
+    for (i = nodes.begin (); i != nodes.end (); i++)
+        if ((*i)->type () == LINK) 
+        {
+            delete *i;
+            *i = NULL;
+        }
+    
+    // ... then all other nodes
+    for (i = nodes.begin (); i != nodes.end (); i++)
+        if (*i != NULL) 
+        {
+            if ((*i)->type () == MODULE) indexModule ((DlgModule *) *i, false);
+            delete *i;
+        }
+    
+    nodes.clear ();
+    grid_.clear ();
+    circles_.clear ();
+    modules_.clear ();
+    traverse_.clear ();
     
     // clear custom code and such
     entry_.clear ();
@@ -96,11 +127,8 @@ void DlgModule::initShape (const DlgPoint &center)
 // select a given node
 bool DlgModule::selectNode (DlgNode *node)
 {
-    // try to find the given node in our array of nodes
-    std::vector<DlgNode*>::iterator i = find (nodes.begin(), nodes.end(), node);
-    
-    // if it is not there, return
-    if (i == nodes.end ()) return false;
+    // if the node is not part of the dialogue, return
+    if (!grid_.has (node)) return false;
     
     // see if a node is already selected
     if (selected_ != NULL) return false;
@@ -140,13 +168,14 @@ bool DlgModule::selectRoot ()
 // get the node at the given postion
 DlgNode* DlgModule::getNode (DlgPoint &position)
 {
-    // find the node with the given pos in our array of nodes
-    std::vector<DlgNode*>::iterator i;
-    
-    for (i = nodes.begin (); i != nodes.end (); i++)
-        if (*(*i) == position) return *i;
-    
-    return NULL;
+    // only look at the nodes close to the given pos
+    return grid_.nodeAt (position);
+}
+
+// get the nodes within the given area
+void DlgModule::getNodes (DlgRect &area, std::vector<DlgNode*> &result)
+{
+    grid_.nodesIn (area, result);
 }
 
 // get the node with the given module and node ids
@@ -164,12 +193,8 @@ DlgNode* DlgModule::getNode (int mid, int nid)
 // get node with the given node id
 DlgNode* DlgModule::getNode (int id)
 {
-    // find the node with the given pos in our array of nodes
-    std::vector<DlgNode*>::iterator i;
-    
-    for (i = nodes.begin (); i != nodes.end (); i++)
-        if ((*i)->node_id () == id && (*i)->type () != MODULE) 
-            return *i;
+    std::hash_map<int, DlgNode*>::const_iterator i = circles_.find (id);
+    if (i != circles_.end ()) return i->second;
     
     return NULL;
 }
@@ -179,25 +204,75 @@ DlgModule* DlgModule::getModule (int id)
 {
     if (id == nid_) return this;
     
-    std::vector<DlgNode*>::iterator i;
-    DlgModule *module;
-    
-    for (i = nodes.begin (); i != nodes.end (); i++)
-        if ((*i)->type () == MODULE) 
-        {
-        	// FIXME shouldn't this be (*i)->getModule(id) ???
-            module = getModule (id);
-            if (module) return module;
-        }
+    // sub-modules of any depth are known by id
+    std::hash_map<int, DlgModule*>::const_iterator i = modules_.find (id);
+    if (i != modules_.end ()) return i->second;
     
     // nothing found
     return NULL;    
 }
 
+// add or remove sub-module to or from the index of all parents
+void DlgModule::indexModule (DlgModule *module, bool add)
+{
+    std::hash_map<int, DlgModule*>::const_iterator i;
+    
+    for (DlgModule *m = this; m != NULL; m = m->parent ())
+    {
+        if (add)
+        {
+            // ids need not be unique, so the module found first wins
+            m->modules_.insert (std::make_pair (module->node_id (), module));
+            for (i = module->modules_.begin (); i != module->modules_.end (); i++)
+                m->modules_.insert (*i);
+        }
+        else
+        {
+            unindex (m->modules_, module->node_id (), module);
+            for (i = module->modules_.begin (); i != module->modules_.end (); i++)
+                unindex (m->modules_, i->first, i->second);
+        }
+    }
+}
+
 // add a node to the dialogue
 void DlgModule::addNode (DlgNode *node)
 {
     nodes.push_back (node);    
+    grid_.add (node);
+    
+    // keep track of the node's id
+    switch (node->type ())
+    {
+        case LINK: break;
+        case MODULE:
+        {
+            indexModule ((DlgModule *) node, true);
+            break;
+        }
+        default:
+        {
+            circles_.insert (std::make_pair (node->node_id (), node));
+            break;
+        }
+    }
+}
+
+// update position of a node
+void DlgModule::updateNode (DlgNode *node)
+{
+    if (node == NULL) return;
+    grid_.update (node);
+
+    // arrows attached to a circle change their shape as well
+    if (node->type () != LINK)
+    {
+        for (DlgNode *a = node->prev (FIRST); a != NULL; a = node->prev (NEXT))
+            grid_.update (a);
+
+        for (DlgNode *a = node->next (FIRST); a != NULL; a = node->next (NEXT))
+            grid_.update (a);
+    }
 }
 
 // delete a node from the dialogue
@@ -218,6 +293,8 @@ bool DlgModule::deleteNode ()
 // delete the given node
 void DlgModule::deleteNode (DlgNode *node)
 {
+    std::vector<DlgNode*> removed;
+    
     // if the node is a circle, also delete the attached arrows
     if (node->type () != LINK)
     {
@@ -227,7 +304,8 @@ void DlgModule::deleteNode (DlgNode *node)
         // delete all preceding arrows
         for (DlgNode *i = node->prev (FIRST); i != NULL; i = node->prev (FIRST))
         {
-            nodes.erase (remove (nodes.begin (), nodes.end (), i), nodes.end ());       
+            removed.push_back (i);
+            grid_.remove (i);
             if (highlighted_ == i) highlighted_ = NULL;
             delete i;
         }
@@ -235,14 +313,26 @@ void DlgModule::deleteNode (DlgNode *node)
         // delete all following arrows
         for (DlgNode *i = node->next (FIRST); i != NULL; i = node->next (FIRST))
         {
-            nodes.erase (remove (nodes.begin (), nodes.end (), i), nodes.end ());     
+            removed.push_back (i);
+            grid_.remove (i);
             if (highlighted_ == i) highlighted_ = NULL;
             delete i;
         }
+        
+        // forget the node's id
+        if (node->type () == MODULE) indexModule ((DlgModule *) node, false);
+        else unindex (circles_, node->node_id (), node);
     }
 
-    // remove the node itself from the vector
-    nodes.erase (remove (nodes.begin (), nodes.end (), node), nodes.end ());       
+    // remove the node and its arrows from the vector in one go
+    removed.push_back (node);
+    std::vector<DlgNode*>::iterator last = nodes.begin ();
+    for (std::vector<DlgNode*>::iterator i = nodes.begin (); i != nodes.end (); i++)
+        if (find (removed.begin (), removed.end (), *i) == removed.end ())
+            *last++ = *i;
+    nodes.erase (last, nodes.end ());
+    
+    grid_.remove (node);
     if (highlighted_ == node) highlighted_ = NULL;
     delete node;
 }
@@ -294,13 +384,8 @@ void DlgModule::draw (cairo_surface_t *surface, DlgPoint &offset, GtkWidget *wid
     drawRectangle (cr, GuiResources::getColor (GC_WHITE), TRUE, position.x (), position.y (), width (), height ());
     drawRectangle (cr, gc, FALSE, position.x (), position.y (), width (), height ());
 
-    // get the font to draw name
-    const PangoFontDescription *desc = pango_layout_get_font_description (GuiResources::font ());
-
-    // create pango cairo compatible layout
-    PangoLayout *font = pango_cairo_create_layout(cr);
-    pango_layout_set_font_description (font, desc);
-    pango_layout_set_text (font, name().c_str(), -1);
+    // get the name laid out with the font to use
+    PangoLayout *font = label (cr, name ());
     
     // place text in module's center
     int h;
@@ -311,12 +396,10 @@ void DlgModule::draw (cairo_surface_t *surface, DlgPoint &offset, GtkWidget *wid
 
     // set font color and position
     gdk_cairo_set_source_color(cr, gc);
-    pango_cairo_update_layout (cr, font);
     cairo_move_to(cr, x, y);
 
     // draw text
     pango_cairo_show_layout (cr, font);
-    g_object_unref(font);
 
     // Update the drawing area
     update (widget, area);
@@ -352,7 +435,7 @@ void DlgModule::extension (int &min_x, int &max_x, int &y)
 }
 
 // load a dialogue from file
-bool DlgModule::load ()
+bool DlgModule::load (DlgLoader &loader)
 {
     int i = 1, id = 0, n;
     DlgCircle *circle;
@@ -362,15 +445,15 @@ bool DlgModule::load ()
     // load all nodes and toplevel items
     while (i)
     {
-        switch (i = parse_dlgfile (s, n))
+        switch (i = loader.next (s, n))
         {
             // load text node
             case LOAD_CIRCLE:
             {
                 circle = new DlgCircle (nid_, id++);
-                circle->load ();
+                circle->load (loader);
                 
-                nodes.push_back (circle);
+                addNode (circle);
 
                 break;
             }
@@ -380,8 +463,8 @@ bool DlgModule::load ()
             {
                 arrow = new DlgArrow;
 
-                if (arrow->load (this))
-                    nodes.push_back (arrow);
+                if (arrow->load (loader, this))
+                    addNode (arrow);
 
                 break;
             }
@@ -389,23 +472,31 @@ bool DlgModule::load ()
             // load submodule node
             case LOAD_MODULE:
             {
-                if (parse_dlgfile (s, n) == LOAD_STR)
+                if (loader.next (s, n) == LOAD_STR)
                 {
                     // get filename of submodule
                     std::string file = path_ + s;
 
                     // try to create the subdialogue
-                    DlgModule *subdlg = GuiDlgedit::window->loadSubdialogue (file);
+                    DlgModule *subdlg = GuiDlgedit::loadSubdialogue (file);
 
                     // if succeeded, read the final bits
                     if (subdlg)
                     {
-                        subdlg->loadSubdialogue ();
+                        subdlg->loadSubdialogue (loader);
                         subdlg->setParent (this);
                         
-                        nodes.push_back (subdlg);
+                        addNode (subdlg);
+                    }
+                    // otherwise skip them
+                    else
+                    {
+                        loader.error ("cannot load sub-dialogue '" + file + "'");
+                        
+                        int token;
+                        do token = loader.next (s, n);
+                        while (token != LOAD_END && token != 0);
                     }
-                    
                 }
                                 
                 break;
@@ -413,61 +504,61 @@ bool DlgModule::load ()
             
             case LOAD_PROJECT:
             {
-                if (parse_dlgfile (s, n) == LOAD_STR) entry_.setProject (s);
+                if (loader.next (s, n) == LOAD_STR) entry_.setProject (s);
                 break;                
             }
 
             case LOAD_NOTE:
             {
-                if (parse_dlgfile (s, n) == LOAD_STR) entry_.setDescription (s);
+                if (loader.next (s, n) == LOAD_STR) entry_.setDescription (s);
                 break;
             }
 
             case LOAD_FUNC:
             {
-                if (parse_dlgfile (s, n) == LOAD_STR) entry_.setMethods (s);
+                if (loader.next (s, n) == LOAD_STR) entry_.setMethods (s);
                 break;
             }
             
             case LOAD_CTOR:
             {
-                if (parse_dlgfile (s, n) == LOAD_STR) entry_.setCtor (s);
+                if (loader.next (s, n) == LOAD_STR) entry_.setCtor (s);
                 break;
             }
             
             case LOAD_DTOR:
             {
-                if (parse_dlgfile (s, n) == LOAD_STR) entry_.setDtor (s);
+                if (loader.next (s, n) == LOAD_STR) entry_.setDtor (s);
                 break;
             }
             
             case LOAD_IMPORTS:
             {
-                if (parse_dlgfile (s, n) == LOAD_STR) entry_.setImports (s);
+                if (loader.next (s, n) == LOAD_STR) entry_.setImports (s);
                 break;
             }
 
             case LOAD_RACE:
             {
-                if (parse_dlgfile (s, n) == LOAD_NUM); //->myplayer->set_val ("race", n);
+                if (loader.next (s, n) == LOAD_NUM); //->myplayer->set_val ("race", n);
                 break;
             }
 
             case LOAD_GENDER:
             {
-                if (parse_dlgfile (s, n) == LOAD_NUM); //->myplayer->set_val ("gender", n);
+                if (loader.next (s, n) == LOAD_NUM); //->myplayer->set_val ("gender", n);
                 break;
             }
 
             case LOAD_NPC:
             {
-                if (parse_dlgfile (s, n) == LOAD_STR);
+                if (loader.next (s, n) == LOAD_STR);
                 break;
             }
 
             case LOAD_ID:
             {
-                if (parse_dlgfile (s, n) == LOAD_NUM) serial_ = n;
+                if (loader.next (s, n) == LOAD_NUM) serial_ = n;
                 break;
             }
             
@@ -482,14 +573,14 @@ bool DlgModule::load ()
 }
 
 // load sub-dialogue
-void DlgModule::loadSubdialogue ()
+void DlgModule::loadSubdialogue (DlgLoader &loader)
 {
     int i = 1, n;
     std::string s;
 
     while (i)
     {
-        switch (i = parse_dlgfile (s, n))
+        switch (i = loader.next (s, n))
         {
             // module loaded or EOF
             case LOAD_END:
@@ -498,7 +589,7 @@ void DlgModule::loadSubdialogue ()
             // get id of submodule
             case LOAD_ID:
             {
-                if (parse_dlgfile (s, n) == LOAD_NUM) nid_ = n;
+                if (loader.next (s, n) == LOAD_NUM) nid_ = n;
                 break;
             }
 
@@ -506,14 +597,18 @@ void DlgModule::loadSubdialogue ()
             case LOAD_POS:
             {
                 int x, y;
-                int width;
+                int width = 0;
                 
+                // no font without the main window
                 PangoLayout *font = GuiResources::font ();
-                pango_layout_set_text (font, name().c_str(), -1);
-                pango_layout_get_pixel_size (font, &width, NULL);
+                if (font != NULL)
+                {
+                    pango_layout_set_text (font, name().c_str(), -1);
+                    pango_layout_get_pixel_size (font, &width, NULL);
+                }
                 
-                if (parse_dlgfile (s, n) == LOAD_NUM) x = n;
-                if (parse_dlgfile (s, n) == LOAD_NUM) y = n;
+                if (loader.next (s, n) == LOAD_NUM) x = n;
+                if (loader.next (s, n) == LOAD_NUM) y = n;
 
                 top_left = DlgPoint (x, y);
                 bottom_right = DlgPoint (x + width + 10, y + 20);
@@ -29,7 +29,10 @@
 #ifndef DLG_MODULE_H
 #define DLG_MODULE_H
 
+#include <adonthell/base/hash_map.h>
+
 #include "dlg_module_entry.h"
+#include "dlg_node_grid.h"
 #include "kb_traverse.h"
 
 /**
@@ -122,6 +125,13 @@ public:
      */
     void deleteNode (DlgNode *node);
     
+    /**
+     * Let the dialogue know that the given node has been moved. Also
+     * takes care of the arrows attached to the node.
+     * @param node The DlgNode that has been moved.
+     */
+    void updateNode (DlgNode *node);
+    
     /**
      * Select a node from the list of nodes.
      * @param node The DlgNode to select.
@@ -155,6 +165,14 @@ public:
      * @return the DlgNode at the positon, or \b NULL if there is none.
      */
     DlgNode* getNode (DlgPoint &point);
+
+    /**
+     * Get the nodes that are (partly) within the given area, for
+     * example those in view.
+     * @param area The area to search.
+     * @param result Receives the nodes, in the order they were added.
+     */
+    void getNodes (DlgRect &area, std::vector<DlgNode*> &result);
                
     /**
      * Get the node that is currently selected.
@@ -183,7 +201,8 @@ public:
      */
     DlgNode* getNode (int id);
     /**
-     * Get the (sub-)module with the given node id in the current module.
+     * Get the (sub-)module with the given node id in the current module
+     * or any of its sub-modules.
      * @param nid The node id of the node to retrieve.
      * @return the DlgNode with that id, or \b NULL if there is none.
      */
@@ -211,14 +230,17 @@ public:
     //@{
     /**
      * Init the Dialogue from a file
+     * @param loader the dialogue source being read.
      * @return \b true if loading was successful, \b false otherwise.
      */
-    bool load ();
+    bool load (DlgLoader &loader);
     
     /**
      * Init a sub-dialogue from a file.
+     * @param loader the source of the dialogue containing the
+     *      sub-dialogue.
      */
-    void loadSubdialogue ();
+    void loadSubdialogue (DlgLoader &loader);
     
     /**
      * Save the Dialogue to a file
@@ -369,6 +391,9 @@ public:
     
 protected:
     std::vector<DlgNode*> nodes;// all the nodes in this dialogue
+    DlgNodeGrid grid_;          // the nodes sorted by position
+    std::hash_map<int, DlgNode*> circles_;   // the circles by node id
+    std::hash_map<int, DlgModule*> modules_; // sub-modules of any depth by id
     DlgNode *selected_;         // the node currently selected
     DlgNode *highlighted_;      // the node currently under the cursor
     DlgModule *parent_;         // parent of sub-dialogue
@@ -390,6 +415,10 @@ protected:
     
 private:
     void init ();               // initialize a newly constructed DlgModule
+    
+    // add or remove a sub-module to or from the index of this module 
+    // and all its parents
+    void indexModule (DlgModule *module, bool add);
 };
 
 #endif // DLG_MODULE_H
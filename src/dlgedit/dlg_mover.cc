@@ -143,3 +143,14 @@ void DlgMover::drop (DlgNode *node)
     
     return;
 }
+
+// get the arrow being dragged
+DlgNode *DlgMover::arrow ()
+{
+    switch (moving)
+    {
+        case TIP: return prev_.front ();
+        case TAIL: return next_.front ();
+        default: return NULL;
+    }
+}
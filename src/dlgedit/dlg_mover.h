@@ -63,6 +63,12 @@ public:
      */
     void drop (DlgNode *node);
     
+    /**
+     * Get the arrow attached to this mover.
+     * @return the arrow being dragged, or <b>NULL</b> if none is attached.
+     */
+    DlgNode *arrow ();
+    
 private:
     int moving;                 // is arrow dragged by it's tip or tail?
     DlgNode *oldCircle;         // the node the arrow was attached to before
@@ -33,18 +33,7 @@
 #include <fstream>
 #include "dlg_node_gfx.h"
 
-/*
- * Function to read the next token from dialogue source file
- * @param str used to return string values
- * @param i used to return numeric values
- * @return Type of token read as defined in dlg_types.h
- */
-extern int parse_dlgfile (std::string &str, int &i);
-
-/**
- * File pointer for dialogue source files being parsed.
- */
-extern FILE *loadlgin;
+class DlgLoader;
 
 
 /**
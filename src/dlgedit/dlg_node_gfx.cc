@@ -25,6 +25,13 @@
  */
 
 #include "dlg_node_gfx.h"
+#include "gui_resources.h"
+
+// dtor
+DlgNodeGfx::~DlgNodeGfx ()
+{
+    if (label_) g_object_unref (label_);
+}
 
 // blit part of widget to the screen
 void DlgNodeGfx::update (GtkWidget *widget, DlgRect &area)
@@ -35,3 +42,36 @@ void DlgNodeGfx::update (GtkWidget *widget, DlgRect &area)
         gdk_window_invalidate_rect (gtk_widget_get_window(widget), &rect, FALSE);
     }
 }
+
+// get layout of the given text
+PangoLayout *DlgNodeGfx::label (cairo_t *cr, const std::string &text)
+{
+    // the font changed since the text was laid out
+    if (label_ != NULL && labelFont_ != GuiResources::revision ())
+    {
+        g_object_unref (label_);
+        label_ = NULL;
+    }
+    
+    if (label_ == NULL)
+    {
+        // create pango cairo compatible layout with the font to use
+        label_ = pango_cairo_create_layout (cr);
+        pango_layout_set_font_description (label_, pango_layout_get_font_description (GuiResources::font ()));
+        pango_layout_set_text (label_, text.c_str (), -1);
+        
+        labelText_ = text;
+        labelFont_ = GuiResources::revision ();
+    }
+    // only shape the text again if it changed
+    else if (text != labelText_)
+    {
+        pango_layout_set_text (label_, text.c_str (), -1);
+        labelText_ = text;
+    }
+    
+    // adapt to the context drawn to
+    pango_cairo_update_layout (cr, label_);
+    
+    return label_;
+}
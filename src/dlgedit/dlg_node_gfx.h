@@ -27,6 +27,7 @@
 #ifndef DLG_NODE_GFX_H
 #define DLG_NODE_GFX_H
 
+#include <string>
 #include <gtk/gtk.h>
 #include "dlg_rect.h"
 #include "dlg_types.h"
@@ -40,9 +41,9 @@
 class DlgNodeGfx : public DlgRect
 {
 public:
-    DlgNodeGfx () { }
+    DlgNodeGfx () { label_ = NULL; }
     DlgNodeGfx (DlgPoint &position);
-    virtual ~DlgNodeGfx () { }
+    virtual ~DlgNodeGfx ();
     
     /** 
      * Change the mode of a node.
@@ -89,7 +90,22 @@ public:
     virtual bool operator== (DlgPoint &point) { return contains (point); }
     
 protected:
+    /**
+     * Get a layout of the given text for drawing it with cairo. The
+     * layout is kept with the node, so the text only needs to be
+     * shaped again after it or the font changed.
+     * @param cr the cairo context the text will be drawn to
+     * @param text the text to draw
+     * @return a PangoLayout of the text.
+     */
+    PangoLayout *label (cairo_t *cr, const std::string &text);
+
     mode_type mode_;        // This nodes mode (NONE, HILIGHTED, SELECTED)
+    
+private:
+    PangoLayout *label_;    // layout of the text last drawn
+    std::string labelText_; // the text last drawn
+    int labelFont_;         // revision of the font the text was drawn with
 };
 
 #endif // DLG_NODE_GFX_H
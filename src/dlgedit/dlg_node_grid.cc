@@ -0,0 +1,164 @@
+/*
+   Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+   Part of the Adonthell Project http://adonthell.linuxgames.com
+
+   Dlgedit is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   Dlgedit is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Dlgedit; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ * @file dlg_node_grid.cc
+ *
+ * @author Kai Sterker
+ * @brief Finds the nodes of a dialogue by position.
+ */
+
+#include <algorithm>
+#include "dlg_node_grid.h"
+
+// ctor
+DlgNodeGrid::DlgNodeGrid ()
+{
+    Serial = 0;
+}
+
+// add node to the cells it covers
+void DlgNodeGrid::add (DlgNode *node)
+{
+    if (node == NULL || Entries.find (node) != Entries.end ()) return;
+
+    entry & e = Entries[node];
+    footprint (node, e);
+    e.Serial = Serial++;
+
+    mark (node, e, true);
+}
+
+// remove node from the cells it covers
+void DlgNodeGrid::remove (DlgNode *node)
+{
+    entry_map::iterator i = Entries.find (node);
+    if (i == Entries.end ()) return;
+
+    mark (node, i->second, false);
+    Entries.erase (i);
+}
+
+// move node to the cells it covers now
+void DlgNodeGrid::update (DlgNode *node)
+{
+    entry_map::iterator i = Entries.find (node);
+    if (i == Entries.end ()) return;
+
+    entry e;
+    footprint (node, e);
+    e.Serial = i->second.Serial;
+
+    // node still covers the same cells
+    if (e.MinX == i->second.MinX && e.MinY == i->second.MinY &&
+        e.MaxX == i->second.MaxX && e.MaxY == i->second.MaxY) return;
+
+    mark (node, i->second, false);
+    mark (node, e, true);
+    i->second = e;
+}
+
+// forget all nodes
+void DlgNodeGrid::clear ()
+{
+    Cells.clear ();
+    Entries.clear ();
+}
+
+// get the node at the given position
+DlgNode *DlgNodeGrid::nodeAt (DlgPoint &point)
+{
+    cell c = { point.x () >> DLG_GRID_SHIFT, point.y () >> DLG_GRID_SHIFT };
+
+    cell_map::const_iterator i = Cells.find (c);
+    if (i == Cells.end ()) return NULL;
+
+    // of several nodes at that position, the one added first wins
+    const item *found = NULL;
+    for (std::vector<item>::const_iterator j = i->second.begin (); j != i->second.end (); j++)
+    {
+        if ((found == NULL || j->first < found->first) && *(j->second) == point)
+            found = &(*j);
+    }
+
+    return found ? found->second : NULL;
+}
+
+// get the nodes overlapping the given area
+void DlgNodeGrid::nodesIn (DlgRect &area, std::vector<DlgNode*> &result)
+{
+    std::vector<item> found;
+    cell c;
+
+    s_int32 min_x = area.x () >> DLG_GRID_SHIFT;
+    s_int32 max_x = area.bottomRight ().x () >> DLG_GRID_SHIFT;
+    s_int32 max_y = area.bottomRight ().y () >> DLG_GRID_SHIFT;
+
+    for (c.Y = area.y () >> DLG_GRID_SHIFT; c.Y <= max_y; c.Y++)
+    {
+        for (c.X = min_x; c.X <= max_x; c.X++)
+        {
+            cell_map::const_iterator i = Cells.find (c);
+            if (i != Cells.end ())
+                found.insert (found.end (), i->second.begin (), i->second.end ());
+        }
+    }
+
+    // nodes covering several cells are found more than once
+    std::sort (found.begin (), found.end ());
+    found.erase (std::unique (found.begin (), found.end ()), found.end ());
+
+    for (std::vector<item>::const_iterator i = found.begin (); i != found.end (); i++)
+    {
+        if (i->second->contains (area)) result.push_back (i->second);
+    }
+}
+
+// cells covered by a node
+void DlgNodeGrid::footprint (DlgNode *node, entry & e)
+{
+    e.MinX = node->x () >> DLG_GRID_SHIFT;
+    e.MinY = node->y () >> DLG_GRID_SHIFT;
+    e.MaxX = node->bottomRight ().x () >> DLG_GRID_SHIFT;
+    e.MaxY = node->bottomRight ().y () >> DLG_GRID_SHIFT;
+}
+
+// add or remove node to or from its cells
+void DlgNodeGrid::mark (DlgNode *node, const entry & e, const bool & add)
+{
+    cell c;
+    for (c.Y = e.MinY; c.Y <= e.MaxY; c.Y++)
+    {
+        for (c.X = e.MinX; c.X <= e.MaxX; c.X++)
+        {
+            if (add)
+            {
+                Cells[c].push_back (item (e.Serial, node));
+                continue;
+            }
+
+            cell_map::iterator i = Cells.find (c);
+            if (i == Cells.end ()) continue;
+
+            std::vector<item> & nodes = i->second;
+            nodes.erase (std::remove (nodes.begin (), nodes.end (), item (e.Serial, node)), nodes.end ());
+            if (nodes.empty ()) Cells.erase (i);
+        }
+    }
+}
@@ -0,0 +1,168 @@
+/*
+   Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+   Part of the Adonthell Project http://adonthell.linuxgames.com
+
+   Dlgedit is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   Dlgedit is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Dlgedit; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ * @file dlg_node_grid.h
+ *
+ * @author Kai Sterker
+ * @brief Finds the nodes of a dialogue by position.
+ */
+
+#ifndef DLG_NODE_GRID_H
+#define DLG_NODE_GRID_H
+
+#include <map>
+#include <vector>
+#include <adonthell/base/types.h>
+
+#include "dlg_node.h"
+
+/// nodes are sorted into cells of 2^DLG_GRID_SHIFT pixels
+#define DLG_GRID_SHIFT 7
+
+/**
+ * Sorts the nodes of a dialogue into a grid of square cells, by the
+ * area they cover. Finding the node under the cursor or the nodes in
+ * view then only needs to look at the nodes in a few cells, instead
+ * of all the nodes of the dialogue.
+ *
+ * Nodes are kept in the order they were added. Where several nodes
+ * overlap, the one added first is found, same as when searching the
+ * list of nodes from its start.
+ */
+class DlgNodeGrid
+{
+public:
+    /**
+     * Create an empty grid.
+     */
+    DlgNodeGrid ();
+
+    /**
+     * Add a node to the grid.
+     * @param node the DlgNode to add.
+     */
+    void add (DlgNode *node);
+
+    /**
+     * Remove a node from the grid.
+     * @param node the DlgNode to remove.
+     */
+    void remove (DlgNode *node);
+
+    /**
+     * Sort a node into the cells it covers now, after it has been
+     * moved or changed its shape. Nodes not in the grid are ignored.
+     * @param node the DlgNode that changed.
+     */
+    void update (DlgNode *node);
+
+    /**
+     * Check whether a node has been added to the grid.
+     * @param node the DlgNode.
+     * @return true if that is the case, false otherwise.
+     */
+    bool has (DlgNode *node) const { return Entries.find (node) != Entries.end (); }
+
+    /**
+     * Remove all nodes from the grid.
+     */
+    void clear ();
+
+    /**
+     * Get the node at the given position.
+     * @param point the position.
+     * @return the DlgNode at the position, or \b NULL if there is none.
+     */
+    DlgNode *nodeAt (DlgPoint &point);
+
+    /**
+     * Get the nodes overlapping the given area, in the order they
+     * were added.
+     * @param area the area.
+     * @param result receives the nodes.
+     */
+    void nodesIn (DlgRect &area, std::vector<DlgNode*> &result);
+
+private:
+    /**
+     * A cell of the grid.
+     */
+    struct cell
+    {
+        /// column of the cell
+        s_int32 X;
+        /// row of the cell
+        s_int32 Y;
+
+        bool operator < (const cell & c) const
+        {
+            if (Y != c.Y) return Y < c.Y;
+            return X < c.X;
+        }
+    };
+
+    /**
+     * Cells covered by a node.
+     */
+    struct entry
+    {
+        /// first column
+        s_int32 MinX;
+        /// first row
+        s_int32 MinY;
+        /// last column
+        s_int32 MaxX;
+        /// last row
+        s_int32 MaxY;
+        /// when the node was added
+        u_int32 Serial;
+    };
+
+    /// a node and when it was added
+    typedef std::pair<u_int32, DlgNode*> item;
+    /// nodes within each cell
+    typedef std::map<cell, std::vector<item> > cell_map;
+    /// cells covered by each node
+    typedef std::map<DlgNode*, entry> entry_map;
+
+    /**
+     * Compute the cells covered by a node.
+     * @param node the DlgNode.
+     * @param e receives the cells covered.
+     */
+    static void footprint (DlgNode *node, entry & e);
+
+    /**
+     * Add or remove a node to or from the cells it covers.
+     * @param node the DlgNode.
+     * @param e cells covered by the node.
+     * @param add true to add the node, false to remove it.
+     */
+    void mark (DlgNode *node, const entry & e, const bool & add);
+
+    /// nodes within each cell
+    cell_map Cells;
+    /// cells covered by each node
+    entry_map Entries;
+    /// incremented whenever a node is added
+    u_int32 Serial;
+};
+
+#endif // DLG_NODE_GRID_H
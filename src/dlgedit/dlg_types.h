@@ -99,7 +99,8 @@ enum menu_item
     PREVIEW         = 6,
     RUN             = 7,
     REVERT          = 8,
-    MAX_ITEM        = 9
+    ARRANGE         = 9,
+    MAX_ITEM        = 10
 };
 
 /**
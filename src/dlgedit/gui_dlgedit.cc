@@ -50,25 +50,14 @@
 #include "cfg_data.h"
 #include "dlg_cmdline.h"
 #include "dlg_compiler.h"
+#include "dlg_layout.h"
+#include "dlg_loader.h"
 #include "gui_code.h"
 #include "gui_settings.h"
 #include "gui_resources.h"
 #include "gui_dlgedit.h"
 #include "gui_dlgedit_events.h"
 
-/**
- * Point parser to another file to load sub-dialogue.
- * Defined in loadlg.l
- */
-extern void parser_switch_input ();
-
-/**
- * Return to previous input file after loading sub-dialogue - or 
- * after failing to do so.
- * Defined in loadlg.l
- */
-extern void parser_restore_input ();
-
 /**
  * Global pointer to the main window
  */
@@ -236,6 +225,17 @@ GuiDlgedit::GuiDlgedit ()
     g_signal_connect (G_OBJECT (menuitem), "activate", G_CALLBACK (on_dialogue_functions_activate), (gpointer) this);
     menuItem[FUNCTIONS] = menuitem;
 
+    // Arrange Nodes
+    menuitem = gtk_image_menu_item_new_with_mnemonic ("_Arrange Nodes");
+    gtk_image_menu_item_set_image (GTK_IMAGE_MENU_ITEM (menuitem), gtk_image_new_from_stock ("gtk-sort-ascending", GTK_ICON_SIZE_MENU));
+    gtk_container_add (GTK_CONTAINER (submenu), menuitem);
+    gtk_widget_add_accelerator (menuitem, "activate", accel_group, GDK_KEY_l, GDK_CONTROL_MASK, GTK_ACCEL_VISIBLE);
+    g_object_set_data (G_OBJECT (menuitem), "help-id", GINT_TO_POINTER (15));
+    g_signal_connect (G_OBJECT (menuitem), "enter-notify-event", G_CALLBACK (on_display_help), message);
+    g_signal_connect (G_OBJECT (menuitem), "leave-notify-event", G_CALLBACK (on_clear_help), message);
+    g_signal_connect (G_OBJECT (menuitem), "activate", G_CALLBACK (on_dialogue_arrange_activate), (gpointer) NULL);
+    menuItem[ARRANGE] = menuitem;
+
     // Seperator
     menuitem = gtk_menu_item_new ();
     gtk_menu_shell_append (GTK_MENU_SHELL (submenu), menuitem);
@@ -426,7 +426,8 @@ void GuiDlgedit::loadDialogue (const std::string &f)
     DlgModule *module = initDialogue (filename);
 
     // try to load from file
-    if (!module->load ())
+    DlgLoader loader;
+    if (!loader.open (file) || !module->load (loader))
     {
         message->display (-3, filename.c_str ());
         closeDialogue ();
@@ -451,8 +452,10 @@ DlgModule* GuiDlgedit::loadSubdialogue (const std::string &file)
     // test if we have a valid dialogue
     if (!checkDialogue (file)) return NULL;
 
-    // remember the current directory for later use
-    directory_ = g_dirname (file.c_str ());
+    // directory of the sub-dialogue
+    gchar *dname = g_path_get_dirname (file.c_str ());
+    std::string dirname (dname);
+    g_free (dname);
 
     // get the name to use for the dialogue
     gchar *fname = g_path_get_basename (file.c_str ());
@@ -464,16 +467,13 @@ DlgModule* GuiDlgedit::loadSubdialogue (const std::string &file)
     if (pos != filename.npos) filename.erase (pos);
 
     // the sub-dialogue
-    DlgModule *module = new DlgModule (directory_, filename, "", "");
-
-    // parser needs to read from sub-dialogue source file
-    parser_switch_input ();
+    DlgModule *module = new DlgModule (dirname, filename, "", "");
 
     // try to load from file
-    if (!module->load ())
+    DlgLoader loader;
+    if (!loader.open (file) || !module->load (loader))
     {
         delete module;
-        parser_restore_input ();
         return NULL;
     }
 
@@ -499,7 +499,8 @@ void GuiDlgedit::revertDialogue ()
     module->clear ();
     
     // reload
-    if (!module->load ())
+    DlgLoader loader;
+    if (!loader.open (module->fullName ()) || !module->load (loader))
     {
         message->display (-3, module->name ().c_str ());
         closeDialogue ();
@@ -631,6 +632,23 @@ void GuiDlgedit::compileDialogue ()
     message->display (212);
 }
 
+// arrange the nodes of the dialogue in view
+void GuiDlgedit::arrangeDialogue ()
+{
+    DlgModule *module = graph_->getAttached ();
+    if (module == NULL) return;
+
+    // arrange whatever follows the selected node, or everything
+    DlgLayout layout (module);
+    if (!layout.arrange (module->selected ())) return;
+
+    module->setChanged ();
+    graph_->draw ();
+
+    // report success
+    message->display (213);
+}
+
 // edit the genral dialogu settings
 void GuiDlgedit::settings ()
 {
@@ -823,7 +841,7 @@ bool GuiDlgedit::checkDialogue (const std::string &file)
         return false;
     }
     
-    loadlgin = test;
+    fclose (test);
     return true;
 }
 
@@ -850,6 +868,7 @@ DlgModule *GuiDlgedit::initDialogue (std::string name)
     gtk_widget_set_sensitive (menuItem[CLOSE], TRUE);
     gtk_widget_set_sensitive (menuItem[SETTINGS], TRUE);
     gtk_widget_set_sensitive (menuItem[FUNCTIONS], TRUE);
+    gtk_widget_set_sensitive (menuItem[ARRANGE], TRUE);
     gtk_widget_set_sensitive (menuItem[COMPILE], TRUE);
 #ifdef ENABLE_NLS
     gtk_widget_set_sensitive (menuItem[PREVIEW], TRUE);
@@ -923,6 +942,7 @@ void GuiDlgedit::clear ()
     gtk_widget_set_sensitive (menuItem[CLOSE], FALSE);
     gtk_widget_set_sensitive (menuItem[SETTINGS], FALSE);
     gtk_widget_set_sensitive (menuItem[FUNCTIONS], FALSE);
+    gtk_widget_set_sensitive (menuItem[ARRANGE], FALSE);
     gtk_widget_set_sensitive (menuItem[COMPILE], FALSE);
 #ifdef ENABLE_NLS
     gtk_widget_set_sensitive (menuItem[PREVIEW], FALSE);
@@ -113,11 +113,12 @@ public:
     /**
      * Load a sub-dialogue from a file. Sub-dialogues are not
      * directly available for editing; instead they become part
-     * of a (top level) dialogue.
+     * of a (top level) dialogue. This also works without the main
+     * window, when dialogues are compiled from the command line.
      * @param file Filename (and path) of the dialogue to load.
      * @return the sub-dialogue, or \b NULL if loading failed.
      */
-    DlgModule* loadSubdialogue (const std::string &file);
+    static DlgModule* loadSubdialogue (const std::string &file);
     /**
      * Save a dialogue to file
      * @param file Filename (and path) of the dialogue to load.
@@ -142,6 +143,12 @@ public:
      * Compile a dialogue
      */
     void compileDialogue ();
+    /**
+     * Arrange the nodes of the dialogue in view. Only the selected
+     * node and the nodes following it are arranged, if a node is
+     * selected.
+     */
+    void arrangeDialogue ();
     /**
      * Test whether the given filename points to a valid dialogue
      * @param file path of the dialogue
@@ -116,6 +116,12 @@ void on_dialogue_compile_activate (GtkMenuItem * menuitem, gpointer user_data)
     GuiDlgedit::window->compileDialogue ();    
 }
 
+// Dialogue Menu: Arrange
+void on_dialogue_arrange_activate (GtkMenuItem * menuitem, gpointer user_data)
+{
+    GuiDlgedit::window->arrangeDialogue ();
+}
+
 // Dialogue Menu: Settings
 void on_dialogue_player_activate (GtkMenuItem * menuitem, gpointer user_data)
 {
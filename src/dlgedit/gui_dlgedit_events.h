@@ -39,6 +39,7 @@ void on_file_save_as_activate (GtkMenuItem *, gpointer);
 void on_file_revert_activate (GtkMenuItem *, gpointer);
 void on_file_close_activate (GtkMenuItem *, gpointer);
 void on_dialogue_compile_activate (GtkMenuItem *, gpointer);
+void on_dialogue_arrange_activate (GtkMenuItem *, gpointer);
 void on_dialogue_run_activate (GtkMenuItem *, gpointer);
 void on_dialogue_preview_activate (GtkMenuItem *, gpointer);
 void on_dialogue_functions_activate (GtkMenuItem *, gpointer);
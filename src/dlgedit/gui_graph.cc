@@ -40,7 +40,10 @@ GuiGraph::GuiGraph (GtkWidget *paned) : Scrollable ()
     module = NULL;
     offset = NULL;
     surface = NULL;
-    tooltip = NULL;
+    background = NULL;
+    
+    // a single tooltip is shown for whatever node is under the cursor
+    tooltip = new GuiTooltip ();
     
     // create drawing area for the graph
     graph = gtk_drawing_area_new ();
@@ -64,6 +67,8 @@ GuiGraph::GuiGraph (GtkWidget *paned) : Scrollable ()
 // dtor
 GuiGraph::~GuiGraph()
 {
+    delete tooltip;
+    if (background) cairo_surface_destroy (background);
     cairo_surface_destroy(surface);
 }
 
@@ -112,11 +117,7 @@ void GuiGraph::detachModule ()
     GuiDlgedit::window->setMode (IDLE);
 
     // remove the tooltip if it is open
-    if (tooltip)
-    {
-        delete tooltip;
-        tooltip = NULL;
-    }
+    tooltip->hide ();
 }
 
 // display a different module
@@ -253,7 +254,7 @@ bool GuiGraph::newModule (DlgPoint &point)
 
     if (fs.run ())
     {
-        DlgModule *subdlg = GuiDlgedit::window->loadSubdialogue (fs.getSelection());
+        DlgModule *subdlg = GuiDlgedit::loadSubdialogue (fs.getSelection());
 
         if (subdlg == NULL) return false;
 
@@ -296,11 +297,7 @@ bool GuiGraph::deleteNode ()
         GuiDlgedit::window->list ()->clear ();
 
         // remove tooltip if it is open        
-        if (tooltip) 
-        {
-            delete tooltip;
-            tooltip = NULL;
-        }
+        tooltip->hide ();
 
         // redraw the dialogue
         draw ();
@@ -597,11 +594,7 @@ bool GuiGraph::prepareDragging (DlgPoint &point)
         mover = node;
         
         // remove any tooltip, as it only gets in the way
-        if (tooltip)
-        {
-            delete tooltip;
-            tooltip = NULL;
-        }
+        tooltip->hide ();
     }
     else
     {
@@ -632,14 +625,23 @@ bool GuiGraph::prepareDragging (DlgPoint &point)
 // drag a node around
 void GuiGraph::drag (DlgPoint &point)
 {
-    static int redraw = 0;
-    
     // if there is no module assigned to the view, there is nothing to do
     if (module == NULL) return;
 
     // calculate absolute position of the point
     point.move (-offset->x (), -offset->y ());
     
+    // the graph without the dragged node, unless the view changed
+    if (background == NULL)
+    {
+        background = cairo_surface_create_similar (surface, CAIRO_CONTENT_COLOR, 
+            drawing_area.width (), drawing_area.height ());
+        drawNodes (background, mover);
+    }
+    
+    // area covered by dragged node and arrows at their old position ...
+    GdkRectangle dirty = dragArea ();
+    
     // move node
     mover->setPos (DlgPoint (point.x () - (point.x () % CIRCLE_DIAMETER), 
                              point.y () - (point.y () % CIRCLE_DIAMETER)));
@@ -651,26 +653,58 @@ void GuiGraph::drag (DlgPoint &point)
     for (DlgNode *a = mover->next (FIRST); a != NULL; a = mover->next (NEXT))
         ((DlgArrow *) a)->initShape ();
     
-    // update view
-    switch (redraw) 
+    // keep track of the new positions
+    module->updateNode (mover);
+    
+    // ... and at the new one
+    GdkRectangle area = dragArea ();
+    gdk_rectangle_union (&dirty, &area, &dirty);
+    
+    // restore that area from the graph without the dragged node ...
+    cairo_t *cr = cairo_create (surface);
+    gdk_cairo_rectangle (cr, &dirty);
+    cairo_clip (cr);
+    cairo_set_source_surface (cr, background, 0, 0);
+    cairo_paint (cr);
+    cairo_destroy (cr);
+    
+    // ... and draw the dragged node on top
+    mover->draw (surface, *offset, NULL);
+
+    for (DlgNode *a = mover->prev (FIRST); a != NULL; a = mover->prev (NEXT))
+        a->draw (surface, *offset, NULL);
+
+    for (DlgNode *a = mover->next (FIRST); a != NULL; a = mover->next (NEXT))
+        a->draw (surface, *offset, NULL);
+    
+    // only update the part of the screen that changed
+    gdk_window_invalidate_rect (gtk_widget_get_window (graph), &dirty, FALSE);
+}
+
+// area covered by dragged node and its arrows
+GdkRectangle GuiGraph::dragArea ()
+{
+    // arrows are drawn up to 10 pixels outside their shape
+    GdkRectangle area = (GdkRectangle) mover->inflate (10, 10);
+    GdkRectangle shape;
+    
+    for (DlgNode *a = mover->prev (FIRST); a != NULL; a = mover->prev (NEXT))
     {
-        case 0:
-        {
-            draw ();
-            redraw++;
-            break;
-        }
-        case 7:
-        {
-            redraw = 0;
-            break;
-        }
-        default:
-        {
-            redraw++;
-            break;
-        }
+        shape = (GdkRectangle) a->inflate (10, 10);
+        gdk_rectangle_union (&area, &shape, &area);
+    }
+    
+    for (DlgNode *a = mover->next (FIRST); a != NULL; a = mover->next (NEXT))
+    {
+        shape = (GdkRectangle) a->inflate (10, 10);
+        gdk_rectangle_union (&area, &shape, &area);
     }
+    
+    // relative to the view
+    area.x += offset->x ();
+    area.y += offset->y ();
+    
+    return area;
 }
 
 // stop dragging node
@@ -690,6 +724,7 @@ void GuiGraph::stopDragging (DlgPoint &point)
         
         // drop the mover onto the node
         ((DlgMover *) mover)->drop (node);
+        module->updateNode (((DlgMover *) mover)->arrow ());
         
         // cleanup
         delete mover;
@@ -723,6 +758,8 @@ void GuiGraph::stopDragging (DlgPoint &point)
             a->next (FIRST)->addPrev (a);
             ((DlgArrow *) a)->initShape ();
         }
+        
+        module->updateNode (mover);
     }    
     // update everything
     if (mover->type() == MODULE)
@@ -750,6 +787,13 @@ void GuiGraph::resizeSurface (GtkWidget *widget)
     // delete the old surface
     if (surface) cairo_surface_destroy (surface);
     
+    // the graph without dragged nodes needs the new size as well
+    if (background)
+    {
+        cairo_surface_destroy (background);
+        background = NULL;
+    }
+    
     // create a new one with the proper size
     surface = gdk_window_create_similar_surface (gtk_widget_get_window(widget), CAIRO_CONTENT_COLOR, allocation.width, allocation.height);
 
@@ -788,9 +832,32 @@ void GuiGraph::draw ()
     // nothing to draw
     if (module == NULL) return;
             
+    GdkRectangle t;
+    
+    // anything drawn for dragging nodes is outdated
+    if (background)
+    {
+        cairo_surface_destroy (background);
+        background = NULL;
+    }
+    
+    drawNodes (surface, NULL);
+
+    // draw backing image to screen
+    t.x = 0;
+    t.y = 0;
+    t.width = drawing_area.width ();
+    t.height = drawing_area.height ();
+
+    gdk_window_invalidate_rect (gtk_widget_get_window (graph), &t, FALSE);
+}
+
+// draw the nodes in view
+void GuiGraph::drawNodes (cairo_surface_t *target, DlgNode *dragged)
+{
     GdkRectangle t;
     std::vector<DlgNode*>::reverse_iterator i;
-    std::vector<DlgNode*> nodes = module->getNodes ();
+    std::vector<DlgNode*> nodes;
     
     // get visible part of graph
     t.x = -offset->x ();
@@ -801,24 +868,23 @@ void GuiGraph::draw ()
     DlgRect rect (t);
 
     // Clear graph
-    cairo_t *cr = cairo_create (surface);
+    cairo_t *cr = cairo_create (target);
     gdk_cairo_set_source_color(cr, GuiResources::getColor (GC_WHITE));
     cairo_rectangle(cr, 0, 0, t.width, t.height);
     cairo_fill(cr);
     cairo_destroy(cr);
 
-    // normalize rect
-    t.x = 0;
-    t.y = 0;
-
-    // check for each node, wether it is visible
+    // only the nodes in view need to be drawn
+    module->getNodes (rect, nodes);
     for (i = nodes.rbegin (); i != nodes.rend (); i++)
-        // draw nodes and arrows
-        if ((*i)->contains (rect))
-            (*i)->draw (surface, *offset, NULL);
-
-    // draw backing image to screen
-    gdk_window_invalidate_rect (gtk_widget_get_window (graph), &t, FALSE);
+    {
+        // leave out the dragged node and its arrows
+        if (dragged != NULL && (*i == dragged || ((*i)->type () == LINK &&
+            ((*i)->prev (FIRST) == dragged || (*i)->next (FIRST) == dragged))))
+            continue;
+        
+        (*i)->draw (target, *offset, NULL);
+    }
 }
 
 // the mouse has been moved
@@ -840,23 +906,17 @@ void GuiGraph::mouseMoved (DlgPoint &point)
     if (prev != node)
     {
         // clear old if necessary
-        if (prev != NULL)
-        {
-            prev->draw (surface, *offset, graph);
-            if (tooltip) 
-            {
-                delete tooltip;
-                tooltip = NULL;
-            }
-        }
+        if (prev != NULL) prev->draw (surface, *offset, graph);
         
         // then highlight the new one
         if (node != NULL && gtk_window_is_active(GTK_WINDOW(gtk_widget_get_toplevel(graph))))
         {
             node->draw (surface, *offset, graph, NODE_HILIGHTED);
-            tooltip = new GuiTooltip (node);
-            tooltip->draw (graph, *offset);
+            tooltip->draw (node, graph, *offset);
         }
+        
+        // the tooltip is moved to the next node rather than closed
+        else tooltip->hide ();
     }
     
     return;
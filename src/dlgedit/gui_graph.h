@@ -277,11 +277,26 @@ public:
     //@}
     
 private:
+    /**
+     * Draw the nodes in view to the given surface.
+     * @param target the surface to draw to.
+     * @param dragged a node to leave out together with its arrows,
+     *      or \b NULL to draw all nodes.
+     */
+    void drawNodes (cairo_surface_t *target, DlgNode *dragged);
+    /**
+     * Get the part of the view covered by the node being dragged and
+     * the arrows attached to it.
+     * @return area covered, relative to the view.
+     */
+    GdkRectangle dragArea ();
+    
     DlgNode *mover;         // The node currently dragged
     DlgModule *module;      // Module assigned to the graph view
     DlgPoint *offset;       // Module's relative position to the origin
     GtkWidget *graph;       // Drawing Area
     cairo_surface_t *surface;   // Drawing surface
+    cairo_surface_t *background;// Graph without the dragged node
     DlgRect drawing_area;   // Size of the Drawing Area
     GuiTooltip *tooltip;    // Tooltip for displaying node-text
 };
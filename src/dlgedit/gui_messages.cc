@@ -47,6 +47,7 @@ GuiMessages::GuiMessages (GtkWidget *sb)
     messages[12]    = " Transform the current dialogue into a Python script, as required by the dialogue engine";
     messages[13]    = " Preview a translation of the current dialogue";
     messages[14]    = " Start the dialogue engine with the current dialogue";
+    messages[15]    = " Arrange the selected node and all nodes following it, or the whole dialogue if nothing is selected";
     
     messages[20]    = " Switch the view to this dialogue";
     
@@ -72,6 +73,7 @@ GuiMessages::GuiMessages (GtkWidget *sb)
     messages[210]   = " Settings updated";
     messages[211]   = " Custom code updated";
     messages[212]   = " Dialogue compiled successfully";
+    messages[213]   = " Dialogue arranged";
     
     // Welcome Message
     messages[1000]  = " Welcome to the Adonthell Dialogue Editor";
@@ -31,6 +31,11 @@
  */
 PangoLayout *GuiResources::Font;
 
+/**
+ * Revision of the font.
+ */
+int GuiResources::Revision = 0;
+
 /**
  * Some pens for line drawing.
  */
@@ -41,6 +46,7 @@ void GuiResources::init (GtkWidget *widget)
 {
     // font to use on the drawing area
     Font = gtk_widget_create_pango_layout (widget, NULL);
+    Revision++;
     
     GdkColor *c;
   
@@ -72,9 +72,16 @@ public:
      * @return a PangoLayout.
      */
     static PangoLayout *font ()         { return Font; }
+    /**
+     * Get a number that changes whenever the font is created anew.
+     * Allows to keep text laid out with the font.
+     * @return current revision of the font.
+     */
+    static int revision ()              { return Revision; }
 
 private:
     static PangoLayout *Font;       // font for text-output
+    static int Revision;            // incremented whenever Font changes
     static GdkColor Color[MAX_GC];  // custom colors
 };
 
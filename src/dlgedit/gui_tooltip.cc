@@ -28,11 +28,8 @@
 #include "gui_tooltip.h"
 
 // constructor
-GuiTooltip::GuiTooltip (DlgNode *n)
+GuiTooltip::GuiTooltip ()
 {
-    GtkWidget *tip;
-    std::string text;
-
     // the actual tooltip
     tooltip = gtk_window_new (GTK_WINDOW_POPUP);
     gtk_window_set_keep_above (GTK_WINDOW (tooltip), FALSE);
@@ -44,49 +41,54 @@ GuiTooltip::GuiTooltip (DlgNode *n)
     g_object_set_data (G_OBJECT (tooltip), "tip_window", tooltip);
     gtk_window_set_resizable (GTK_WINDOW (tooltip), FALSE);
 
+    // label with the text
+    label = gtk_label_new (NULL);
+    g_object_ref (label);
+    g_object_set_data_full (G_OBJECT (tooltip), "tip", label, (GDestroyNotify)  g_object_unref);
+    gtk_widget_show (label);
+
+    gtk_container_add (GTK_CONTAINER (tooltip), label);
+    gtk_label_set_justify (GTK_LABEL (label), GTK_JUSTIFY_LEFT);
+    gtk_label_set_line_wrap (GTK_LABEL (label), TRUE);
+    gtk_misc_set_padding (GTK_MISC (label), 4, 1);
+}
+
+// destructor
+GuiTooltip::~GuiTooltip ()
+{
+    gtk_widget_destroy (tooltip);
+}
+
+// draw the tooltip
+void GuiTooltip::draw (DlgNode *node, GtkWidget *graph, DlgPoint &offset)
+{
+    std::string text;
+
     // get the text
-    switch (n->type ())
+    switch (node->type ())
     {
         case NPC:
         case PLAYER:
         case NARRATOR:
         {
-            text = ((DlgCircle *) n)->tooltip ();
+            text = ((DlgCircle *) node)->tooltip ();
             break;            
         }
         case MODULE:
         {
-            text = ((DlgModule *) n)->entry ()->description ();
+            text = ((DlgModule *) node)->entry ()->description ();
             break;            
         }
-        default: break;
+        default: 
+        {
+            hide ();
+            return;
+        }
     }
     
-    // label with the text
-    tip = gtk_label_new (text.c_str ());
-    g_object_ref (tip);
-    g_object_set_data_full (G_OBJECT (tooltip), "tip", tip, (GDestroyNotify)  g_object_unref);
-    gtk_widget_show (tip);
-
-    gtk_container_add (GTK_CONTAINER (tooltip), tip);
-    gtk_label_set_justify (GTK_LABEL (tip), GTK_JUSTIFY_LEFT);
-    gtk_label_set_line_wrap (GTK_LABEL (tip), TRUE);
-    gtk_misc_set_padding (GTK_MISC (tip), 4, 1);
-    
-    // keep a pointer to the node
-    node = n;    
-}
-
-// destructor
-GuiTooltip::~GuiTooltip ()
-{
-    gtk_widget_destroy (tooltip);
-}
-
-// draw the tooltip
-void GuiTooltip::draw (GtkWidget *graph, DlgPoint &offset)
-{
-    if (node->type () == LINK) return;
+    // only lay out the label again if the text changed
+    if (text != gtk_label_get_text (GTK_LABEL (label)))
+        gtk_label_set_text (GTK_LABEL (label), text.c_str ());
 
     // get position and extension of dlgedit window    
     int x, y;
@@ -95,8 +97,6 @@ void GuiTooltip::draw (GtkWidget *graph, DlgPoint &offset)
     gdk_window_get_origin (window, &x, &y);
     int width = gdk_window_get_width(window);
     
-    gtk_widget_realize (tooltip);
-
     GtkAllocation allocation;
     gtk_widget_get_allocation (graph, &allocation);
     
@@ -108,8 +108,10 @@ void GuiTooltip::draw (GtkWidget *graph, DlgPoint &offset)
     }
     else
     {
-        gtk_widget_get_allocation (tooltip, &allocation);
-        x += node->x () - allocation.width;
+        // the size the tooltip will have with the new text
+        GtkRequisition requisition;
+        gtk_widget_size_request (tooltip, &requisition);
+        x += node->x () - requisition.width;
     }
     y += node->y () + node->height ();
     
@@ -117,3 +119,9 @@ void GuiTooltip::draw (GtkWidget *graph, DlgPoint &offset)
     gtk_window_move (GTK_WINDOW(tooltip), x + offset.x (), y + offset.y ());
     gtk_widget_show (tooltip);
 }
+
+// hide the tooltip
+void GuiTooltip::hide ()
+{
+    gtk_widget_hide (tooltip);
+}
@@ -34,18 +34,31 @@
 /**
  * A widget similar to the GtkTooltip that is used to display a
  * DlgCircle's text as long as the mouse hovers over the circle.
+ * The same window is used for every node, moved and filled with
+ * the text of the node currently under the cursor.
  */
 class GuiTooltip
 {
 public:
-    GuiTooltip (DlgNode *node);
+    GuiTooltip ();
     ~GuiTooltip ();
 
-    void draw (GtkWidget *parent, DlgPoint &offset);
+    /**
+     * Display the text of the given node next to it.
+     * @param node the node under the cursor.
+     * @param parent the graph view the node is drawn to.
+     * @param offset the offset of the graph view.
+     */
+    void draw (DlgNode *node, GtkWidget *parent, DlgPoint &offset);
+    
+    /**
+     * Hide the tooltip until it is drawn for another node.
+     */
+    void hide ();
     
 private:
-    DlgNode *node;
     GtkWidget *tooltip;
+    GtkWidget *label;
 };
 
 #endif // GUI_TOOLTIP_H
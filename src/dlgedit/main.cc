@@ -35,8 +35,8 @@
 #include <locale.h>
 #include "gettext.h"
 #include "cfg_io.h"
+#include "dlg_batch.h"
 #include "dlg_cmdline.h"
-#include "dlg_compiler.h"
 #include "gui_dlgedit.h"
 #include <adonthell/base/base.h>
 
@@ -91,40 +91,7 @@ int main (int argc, char *argv[])
     // just compile what we're given and exit
     else
     {
-        DlgModule *module;
-        std::string dialogue;
-        
-        while (DlgCmdline::sources < argc)
-        {
-            dialogue = argv[DlgCmdline::sources++];
-            
-            // check whether the file is a valid dialoge
-            if (!GuiDlgedit::checkDialogue (dialogue))
-            {
-                std::cout << "Loading of '" << dialogue << "' failed\n";
-                continue;
-            }
-            
-            module = new DlgModule ("", dialogue, "-1", "");
-            
-            // try to load from file
-            if (!module->load ())
-            {
-                std::cout << "Loading of '" << dialogue << "' failed\n";
-            }
-            else
-            {            
-                std::cout << "Compiling '" << dialogue << "' ...\n";
-            
-                // try to compile the dialogue
-                DlgCompiler compiler (module);
-    
-                // compile
-                compiler.run ();
-            }
-            
-            delete module;
-        }
+        return DlgBatch::run (argv + DlgCmdline::sources, argc - DlgCmdline::sources, DlgCmdline::jobs);
     }
     
     // good bye
@@ -26,6 +26,7 @@
 
 #include <adonthell/world/character.h>
 
+#include "common/intern.h"
 #include "common/util.h"
 #include "common/uid.h"
 
@@ -35,6 +36,9 @@
 #include "gui_entity_dialog.h"
 #include "gui_entity_list.h"
 #include "gui_script_selector.h"
+#include "map_command.h"
+#include "map_data.h"
+#include "map_mgr.h"
 
 // Ui definition
 static char edit_entity_ui[] =
@@ -182,6 +186,10 @@ GuiEntityDialog::GuiEntityDialog (MapEntity *entity, const GuiEntityDialog::Mode
     Ui = gtk_builder_new();
     Entity = entity;
     
+    // locations shown by the dialog must stay on the map while it is open
+    Map = (MapData*) MapMgr::get_map();
+    if (Map != NULL) Map->regions()->hold ();
+    
     // set defaults
     EntityType = 'A';
     EntityState = "";
@@ -290,14 +298,14 @@ GuiEntityDialog::GuiEntityDialog (MapEntity *entity, const GuiEntityDialog::Mode
     GtkTreeModel *state_list = gtk_combo_box_get_model (GTK_COMBO_BOX(widget));
     gtk_list_store_clear (GTK_LIST_STORE (state_list));
 
-    std::hash_set<std::string> states = entity->get_object_states();
-    for (std::hash_set<std::string>::const_iterator i = states.begin(); i != states.end(); i++)
+    u_int32 cur_state = intern::get (entity->object()->state());
+    std::hash_set<u_int32> states = entity->get_object_states();
+    for (std::hash_set<u_int32>::const_iterator i = states.begin(); i != states.end(); i++)
     {
-        gchar *val = g_strdup (i->c_str());
         gtk_list_store_append (GTK_LIST_STORE (state_list), &iter);
-        gtk_list_store_set (GTK_LIST_STORE (state_list), &iter, 0, val, -1);
+        gtk_list_store_set (GTK_LIST_STORE (state_list), &iter, 0, intern::str (*i).c_str(), -1);
         
-        if (*i == entity->object()->state())
+        if (*i == cur_state)
         {
             gtk_combo_box_set_active_iter (GTK_COMBO_BOX(widget), &iter);
         }
@@ -381,6 +389,8 @@ GuiEntityDialog::~GuiEntityDialog()
 {
     // cleanup
     g_object_unref (Ui);
+
+    if (Map != NULL) Map->regions()->release ();
 }
 
 // "make it so!"
@@ -430,7 +440,14 @@ void GuiEntityDialog::applyChanges()
         else
         {
             // entity name has possibly changed
-            objToUpdate->rename (id);
+            gchar *old_id = objToUpdate->get_id ();
+            if (old_id != NULL && id != std::string (old_id) && objToUpdate->rename (id))
+            {
+                // allow undoing the rename
+                MapData *map = (MapData*)(&objToUpdate->object()->map());
+                map->journal()->add (new MapRenameCommand (objToUpdate, old_id, id));
+            }
+            g_free (old_id);
         }
         
         g_free(currentType);
@@ -675,6 +692,9 @@ void GuiEntityDialog::init_locations ()
     {
         MapData *map = (MapData*) &(Entity->object()->map());    
 
+        // list locations in parts of the map not loaded as well
+        map->regions()->load_entity (ety);
+
         const std::list<world::chunk_info*> locations = map->getEntityLocations (ety);
         for (std::list<world::chunk_info*>::const_iterator i = locations.begin(); i != locations.end(); i++)
         {
@@ -36,6 +36,7 @@ namespace world
 }
 
 class GuiScriptSelector;
+class MapData;
 
 /**
  * A dialog to display and edit map entity properties.
@@ -140,6 +141,8 @@ protected:
     Mode DlgMode;
     /// the object being displayed or edited
     MapEntity *Entity;
+    /// the map the entity belongs to
+    MapData *Map;
     /// the entity state
     std::string EntityState;
     /// the object type
@@ -42,6 +42,11 @@
 #include "gui_entity_list.h"
 #include "gui_entity_dialog.h"
 #include "gui_filter_dialog.h"
+#include "map_manifest.h"
+#include "map_model_watcher.h"
+
+/// name of the model cache, stored in the project directory
+#define MODEL_MANIFEST "mapedit.manifest"
 
 enum
 {
@@ -184,7 +189,7 @@ static void entity_list_get_value (GtkTreeModel *self, GtkTreeIter *iter, int co
         }
         case TOOLTIP_COLUMN:
         {
-            std::string path = obj->object()->modelfile();
+            std::string path = obj->modelFile();
             gchar* dir = g_path_get_dirname (path.c_str());
             gchar* set = g_path_get_basename (dir);
 
@@ -228,6 +233,13 @@ static void selected_event (GtkTreeSelection *selection, gpointer user_data)
         gtk_tree_model_filter_convert_iter_to_child_iter (GTK_TREE_MODEL_FILTER(filterModel), &iter, &filterIter);
         MapEntity *obj = (MapEntity*) entity_list_get_object (ENTITY_LIST (model), &iter);
 
+        // cached model might be broken or gone from disk
+        if (obj->object () == NULL)
+        {
+            map_view->releaseObject();
+            return;
+        }
+
         // check if object needs to be added to map
         if (!obj->isOnMap ())
         {
@@ -288,7 +300,7 @@ static gint sort_by_path (GtkTreeModel *model, GtkTreeIter *a, GtkTreeIter *b, g
     MapEntity *obj_b = (MapEntity*) entity_list_get_object (ENTITY_LIST (model), b);
 
     // compare the two
-    return strcmp (obj_a->object()->modelfile().c_str(), obj_b->object()->modelfile().c_str());
+    return strcmp (obj_a->modelFile().c_str(), obj_b->modelFile().c_str());
 }
 
 // ctor
@@ -354,6 +366,10 @@ GuiEntityList::GuiEntityList ()
     // set custom sorting by path name
     gtk_tree_sortable_set_default_sort_func(GTK_TREE_SORTABLE (model), sort_by_path, NULL, NULL);
     gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE (model), GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID, GTK_SORT_ASCENDING);
+
+    // keep track of models changing on disk
+    Watcher = new MapModelWatcher (this);
+    Manifest = new MapManifest ();
 }
 
 // return mapedit wrapper around given entity
@@ -384,6 +400,93 @@ MapEntity *GuiEntityList::findEntity (const world::entity *etyToFind) const
     return NULL;
 }
 
+// reset location of all entities
+void GuiEntityList::clearLocations ()
+{
+    GtkTreeIter iter;
+
+    // iterate over all entities in model
+    GtkTreeModelFilter *filterModel = GTK_TREE_MODEL_FILTER (gtk_tree_view_get_model (TreeView));
+    GtkTreeModel *model = gtk_tree_model_filter_get_model(filterModel);
+
+    if (gtk_tree_model_get_iter_first (model, &iter))
+    {
+        do
+        {
+            entity_list_get_object (ENTITY_LIST(model), &iter)->setLocation (NULL);
+        }
+        while (gtk_tree_model_iter_next (model, &iter));
+    }
+}
+
+// find or create entity referenced by an edit
+MapEntity *GuiEntityList::resolveEntity (const std::string & model_file, const char & entity_type, const std::string & id)
+{
+    GtkTreeIter iter;
+    MapEntity *unused = NULL;
+    MapEntity *other = NULL;
+
+    GtkTreeModelFilter *filterModel = GTK_TREE_MODEL_FILTER (gtk_tree_view_get_model (TreeView));
+    GtkTreeModel *model = gtk_tree_model_filter_get_model(filterModel);
+
+    if (gtk_tree_model_get_iter_first (model, &iter))
+    {
+        do
+        {
+            MapEntity *ety = entity_list_get_object (ENTITY_LIST(model), &iter);
+            if (ety->modelFile() != model_file) continue;
+
+            // model not yet placed on the map
+            if (ety->entity() == NULL)
+            {
+                if (unused == NULL) unused = ety;
+                continue;
+            }
+
+            gchar *type = ety->get_entity_type ();
+            gchar *ety_id = ety->get_id ();
+            bool found = type[0] == entity_type && (ety_id == NULL ? id.empty() : id == ety_id);
+            g_free (ety_id);
+            g_free (type);
+
+            if (found) return ety;
+            if (other == NULL) other = ety;
+        }
+        while (gtk_tree_model_iter_next (model, &iter));
+    }
+
+    // entity was created in the session being replayed
+    MapEntity *ety = unused;
+    if (ety == NULL && other != NULL)
+    {
+        ety = new MapEntity (other->entity());
+        ety->loadMetaData ();
+    }
+
+    if (ety == NULL || ety->object() == NULL || !ety->update_entity (ety->object()->type(), entity_type, id))
+    {
+        if (ety != unused) delete ety;
+        return NULL;
+    }
+
+    // same as adding the entity through the entity dialog
+    std::string *hash = (std::string*)(&ety->object()->hash());
+    u_int32 int_hash = uid::hash (ety->object()->modelfile() + id);
+    std::string new_hash = uid::as_string (int_hash);
+    while (Map->findDuplicateHash (new_hash))
+    {
+        new_hash = uid::as_string (++int_hash);
+    }
+    hash->replace (hash->begin(), hash->end(), new_hash);
+
+    if (ety != unused)
+    {
+        addEntity (ety);
+    }
+
+    return ety;
+}
+
 // add given entity
 void GuiEntityList::addEntity (MapEntity *ety)
 {
@@ -631,11 +734,27 @@ void GuiEntityList::setDataDir (const std::string & datadir)
     // avoid tree updates while adding rows
     gtk_tree_view_set_model (TreeView, (GtkTreeModel*) NULL);
 
+    // the model cache lives in the project directory
+    std::string project_dir = datadir;
+    if (project_dir.length() > MapCmdline::modeldir.length() &&
+        project_dir.compare (project_dir.length() - MapCmdline::modeldir.length(), 
+            MapCmdline::modeldir.length(), MapCmdline::modeldir) == 0)
+    {
+        project_dir.erase (project_dir.length() - MapCmdline::modeldir.length() - 1);
+    }
+    Manifest->load (project_dir + "/" + MODEL_MANIFEST);
+
     // add models contained under directory
     scanDir (datadir, model);
     
+    // remember models for next time
+    Manifest->save (true);
+
     // set the model again 
     gtk_tree_view_set_model (TreeView, (GtkTreeModel*) filter);
+
+    // pick up models modified while mapedit is running
+    Watcher->watch (datadir);
 }
 
 // recursively scan given directory for models
@@ -646,6 +765,10 @@ void GuiEntityList::scanDir (const std::string & datadir, GtkListStore *model)
     struct dirent *dirent;
     struct stat statbuf;
     
+    // models and meta data found in this directory
+    std::vector<std::pair<std::string, struct stat> > models;
+    std::hash_map<std::string, struct stat> meta_data;
+
     // open directory
     if ((dir = opendir (datadir.c_str ())) != NULL)
     {
@@ -663,58 +786,274 @@ void GuiEntityList::scanDir (const std::string & datadir, GtkListStore *model)
                 // recurse
                 if (S_ISDIR (statbuf.st_mode)) scanDir (filepath, model);
                 
+                if (!S_ISREG (statbuf.st_mode) || filepath.length() < 5) continue;
+
                 // models are .xml or .amdl files
-                if (S_ISREG (statbuf.st_mode) && (
-                        filepath.compare (filepath.length() - 4, 4, ".xml") == 0 ||
-                        filepath.compare (filepath.length() - 4, 4, "amdl") == 0))
+                if (filepath.compare (filepath.length() - 4, 4, ".xml") == 0 ||
+                    filepath.compare (filepath.length() - 4, 4, "amdl") == 0)
                 {
-                    // check if this file is already part of the map
-                    if (isPresentOnMap (MK_UNIX_PATH(filepath))) continue;
-                    
-                    // not present on map, so add it to the list
-                    
-                    // try to create a relative sprite path
-                    std::string model_path = util::get_relative_path (filepath, MapCmdline::modeldir + "/");
-                    if (g_path_is_absolute (model_path.c_str()))
-                    {
-                        // FIXME: display error in status bar
-                        printf ("*** warning: cannot create model path relative to data directory!\n");
-                    }
-                    
-                    // note: we load it as an object, as we do not yet
-                    // know which type it will have later.
-
-                    // the objects created here are not yet part of the map, so the hash
-                    // is preliminary. It may be changed for named entities and will be
-                    // checked for uniqueness when placing the object on the map.
-                    world::object *obj = new world::object(*Map, uid::as_string(uid::hash(model_path)));
-                    if (obj->load_model (model_path))
-                    {
-                        // set default state
-                        obj->set_state ("");
-                        
-                        // create meta data object
-                        MapEntity *ety = new MapEntity (obj);
-                        
-                        // update tags of new entity
-                        ety->loadMetaData();
-
-                        // get new row
-                        gtk_list_store_append (model, &iter);
-                        
-                        // set our data
-                        gtk_list_store_set (model, &iter, 0, ety, -1);                        
-                    }
-                    else
-                    {
-                        printf ("*** warning: cannot load model '%s'!\n", model_path.c_str());
-                    }
+                    models.push_back (std::make_pair (filepath, statbuf));
+                }
+                // their meta data is kept in .xtra files
+                else if (MapModelWatcher::isMetaData (filepath))
+                {
+                    meta_data[filepath.substr (0, filepath.length() - 5)] = statbuf;
                 }
             }
         }
 
         closedir (dir);
     }
+
+    if (models.empty()) return;
+
+    // all models in this directory share the same relative path
+    std::string model_dir = util::get_relative_path (datadir + "/", MapCmdline::modeldir + "/");
+    if (model_dir.length() > 0 && model_dir[model_dir.length() - 1] != '/') model_dir += "/";
+
+    for (std::vector<std::pair<std::string, struct stat> >::const_iterator i = models.begin(); i != models.end(); i++)
+    {
+        const std::string & filepath = i->first;
+        std::string model_path = model_dir + filepath.substr (datadir.length() + 1);
+
+        // check if this file is already part of the map
+        if (isPresentOnMap (MK_UNIX_PATH(filepath)))
+        {
+            Manifest->keep (model_path);
+            continue;
+        }
+
+        // meta data belonging to the model, if any
+        const struct stat *meta = NULL;
+        std::hash_map<std::string, struct stat>::const_iterator m = meta_data.find (filepath.substr (0, filepath.rfind ('.')));
+        if (m != meta_data.end()) meta = &m->second;
+
+        // not present on map, so add it to the list. If unchanged
+        // since last time, the model itself is only loaded on demand.
+        MapEntity *ety;
+        const MapManifest::entry *cached = Manifest->find (model_path, i->second, meta);
+        if (cached != NULL)
+        {
+            ety = new MapEntity (Map, *cached, Manifest);
+        }
+        else
+        {
+            ety = loadModel (filepath);
+            if (ety != NULL) Manifest->update (i->second, meta, ety);
+        }
+
+        if (ety != NULL)
+        {
+            // get new row
+            gtk_list_store_append (model, &iter);
+            
+            // set our data
+            gtk_list_store_set (model, &iter, 0, ety, -1);                        
+        }
+    }
+}
+
+// load a model not yet present on the map
+MapEntity *GuiEntityList::loadModel (const std::string & filepath)
+{
+    // try to create a relative sprite path
+    std::string model_path = util::get_relative_path (filepath, MapCmdline::modeldir + "/");
+    if (g_path_is_absolute (model_path.c_str()))
+    {
+        // FIXME: display error in status bar
+        printf ("*** warning: cannot create model path relative to data directory!\n");
+    }
+    
+    // note: we load it as an object, as we do not yet
+    // know which type it will have later.
+
+    // the objects created here are not yet part of the map, so the hash
+    // is preliminary. It may be changed for named entities and will be
+    // checked for uniqueness when placing the object on the map.
+    world::object *obj = new world::object(*Map, uid::as_string(uid::hash(model_path)));
+    if (!obj->load_model (model_path))
+    {
+        printf ("*** warning: cannot load model '%s'!\n", model_path.c_str());
+        delete obj;
+        return NULL;
+    }
+
+    // set default state
+    obj->set_state ("");
+    
+    // create meta data object
+    MapEntity *ety = new MapEntity (obj);
+    
+    // update tags of new entity
+    ety->loadMetaData();
+
+    return ety;
+}
+
+// strip extension from a file name
+static std::string strip_extension (const std::string & filename)
+{
+    size_t idx = filename.find_last_of ('.');
+    if (idx == std::string::npos || filename.find ('/', idx) != std::string::npos)
+    {
+        return filename;
+    }
+    return filename.substr (0, idx);
+}
+
+// find row of model with given file name
+bool GuiEntityList::findModel (const std::string & model_path, GtkTreeIter *iter, const bool & ignore_ext) const
+{
+    GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (gtk_tree_view_get_model (TreeView));
+    GtkTreeModel *model = gtk_tree_model_filter_get_model (filter);
+
+    std::string path = ignore_ext ? strip_extension (model_path) : model_path;
+
+    bool valid = gtk_tree_model_get_iter_first (model, iter);
+    while (valid)
+    {
+        MapEntity *ety = entity_list_get_object (ENTITY_LIST(model), iter);
+        std::string objname = MK_UNIX_PATH (ety->modelFile());
+
+        if ((ignore_ext ? strip_extension (objname) : objname) == path)
+        {
+            return true;
+        }
+
+        valid = gtk_tree_model_iter_next (model, iter);
+    }
+
+    return false;
+}
+
+// remove entity from the list
+bool GuiEntityList::removeRow (GtkListStore *model, GtkTreeIter *iter)
+{
+    MapEntity *ety = entity_list_get_object (ENTITY_LIST(model), iter);
+
+    // make sure the entity is no longer used for drawing
+    GuiMapview *map_view = GuiMapedit::window->view();
+    if (map_view->getSelectedObject() == ety)
+    {
+        map_view->releaseObject();
+    }
+
+    // edits of the entity can no longer be undone
+    Map->journal()->forget (ety);
+
+    bool valid = gtk_list_store_remove (model, iter);
+    delete ety;
+
+    return valid;
+}
+
+// reload a single model that changed on disk
+void GuiEntityList::updateModel (const std::string & filepath)
+{
+    if (Map == NULL) return;
+
+    GtkTreeIter iter;
+    GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (gtk_tree_view_get_model (TreeView));
+    GtkListStore *model = GTK_LIST_STORE (gtk_tree_model_filter_get_model (filter));
+
+    std::string model_path = util::get_relative_path (filepath, MapCmdline::modeldir + "/");
+    bool meta_data = MapModelWatcher::isMetaData (filepath);
+
+    if (findModel (model_path, &iter, meta_data))
+    {
+        MapEntity *ety = entity_list_get_object (ENTITY_LIST(model), &iter);
+
+        // entity on the map or only meta data changed --> update meta data
+        if (meta_data || ety->getRefCount() > 0)
+        {
+            ety->loadMetaData();
+
+            if (meta_data && !ety->isOnMap())
+            {
+                const std::string & model_file = ety->modelFile();
+                cacheModel (filepath.substr (0, filepath.length() - 5) + model_file.substr (model_file.rfind ('.')), ety);
+            }
+
+            GtkTreePath *path = gtk_tree_model_get_path (GTK_TREE_MODEL(model), &iter);
+            gtk_tree_model_row_changed (GTK_TREE_MODEL(model), path, &iter);
+            gtk_tree_path_free (path);
+            return;
+        }
+
+        // otherwise replace with updated model, keeping old one on error
+        MapEntity *updated = loadModel (filepath);
+        if (updated != NULL)
+        {
+            cacheModel (filepath, updated);
+            removeRow (model, &iter);
+            gtk_list_store_append (model, &iter);
+            gtk_list_store_set (model, &iter, 0, updated, -1);
+        }
+    }
+    else if (!meta_data && !isPresentOnMap (MK_UNIX_PATH(filepath)))
+    {
+        // a new model
+        MapEntity *ety = loadModel (filepath);
+        if (ety != NULL)
+        {
+            cacheModel (filepath, ety);
+            gtk_list_store_append (model, &iter);
+            gtk_list_store_set (model, &iter, 0, ety, -1);
+        }
+    }
+}
+
+// update model cache with freshly loaded model
+void GuiEntityList::cacheModel (const std::string & filepath, const MapEntity *ety)
+{
+    struct stat model_stat;
+    struct stat meta_stat;
+
+    if (stat (filepath.c_str (), &model_stat) == -1) return;
+
+    std::string meta_file = filepath.substr (0, filepath.rfind ('.')) + ".xtra";
+    bool has_meta = stat (meta_file.c_str (), &meta_stat) != -1;
+
+    Manifest->update (model_stat, has_meta ? &meta_stat : NULL, ety);
+}
+
+// remove models that have been deleted from disk
+void GuiEntityList::removeModel (const std::string & filepath)
+{
+    if (Map == NULL) return;
+
+    GtkTreeIter iter;
+    GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (gtk_tree_view_get_model (TreeView));
+    GtkListStore *model = GTK_LIST_STORE (gtk_tree_model_filter_get_model (filter));
+
+    std::string model_path = util::get_relative_path (filepath, MapCmdline::modeldir + "/");
+
+    // only meta data got removed --> reset it
+    if (MapModelWatcher::isMetaData (filepath))
+    {
+        updateModel (filepath);
+        return;
+    }
+
+    // the file itself or anything inside a removed directory
+    std::string dir_path = model_path + "/";
+
+    bool valid = gtk_tree_model_get_iter_first (GTK_TREE_MODEL(model), &iter);
+    while (valid)
+    {
+        MapEntity *ety = entity_list_get_object (ENTITY_LIST(model), &iter);
+        std::string objname = MK_UNIX_PATH (ety->modelFile());
+
+        // keep anything that is still in use on the map
+        if (ety->getRefCount() == 0 && (objname == model_path ||
+            objname.compare (0, dir_path.length(), dir_path) == 0))
+        {
+            valid = removeRow (model, &iter);
+            continue;
+        }
+
+        valid = gtk_tree_model_iter_next (GTK_TREE_MODEL(model), &iter);
+    }
 }
 
 // rebuild the entity list
@@ -743,8 +1082,7 @@ void GuiEntityList::refresh()
         if (ety->getRefCount() == 0)
         {
             // entity not yet on map --> reload all of it
-            valid = gtk_list_store_remove (model, &iter);
-            delete ety;
+            valid = removeRow (model, &iter);
             continue;
         }
         else
@@ -759,6 +1097,9 @@ void GuiEntityList::refresh()
     // add models contained under directory
     scanDir (DataDir, model);
     
+    // remember models for next time
+    Manifest->save (true);
+
     // set the model again 
     gtk_tree_view_set_model (TreeView, (GtkTreeModel*) filter);
 }
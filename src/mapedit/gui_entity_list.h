@@ -32,6 +32,9 @@
 #include "map_data.h"
 #include "map_entity.h"
 
+class MapManifest;
+class MapModelWatcher;
+
 G_BEGIN_DECLS
 
 #define TYPE_ENTITY_LIST	(entity_list_get_type ())
@@ -63,7 +66,7 @@ G_END_DECLS
  * in the gamedata's model directory. It allows to add latter to
  * the map and to pick former for placement on the map.
  */
-class GuiEntityList
+class GuiEntityList : public MapEntityResolver
 {
 public:
     /**
@@ -99,6 +102,23 @@ public:
      * @return the editor's wrapper around the entity or NULL.
      */
     MapEntity *findEntity (const world::entity *etyToFind) const;
+
+    /**
+     * Forget the location of all entities in the list. Used when
+     * objects have been removed from the map behind their back.
+     */
+    void clearLocations ();
+
+    /**
+     * Find the entity with the given model and id, creating it if
+     * it is not yet present on the map. Used to replay edits that
+     * have not been saved.
+     * @param model_file model file of the entity.
+     * @param entity_type one of A, S or U.
+     * @param id name of shared or unique entities, empty otherwise.
+     * @return the matching entity or NULL on error.
+     */
+    MapEntity *resolveEntity (const std::string & model_file, const char & entity_type, const std::string & id);
     
     /**
      * Add a new entity to the entity list.
@@ -125,6 +145,21 @@ public:
      * have been changed on the file system.
      */
     void refresh();
+
+    /**
+     * Reload a single model (or its meta data) after it has been
+     * written to disk. Models not yet in the list will be added.
+     * @param filepath full path of the model or meta data file.
+     */
+    void updateModel (const std::string & filepath);
+
+    /**
+     * Remove a single model (or everything below a directory) after
+     * it has been deleted from disk. Models still present on the map
+     * are kept. If only the meta data was removed, it is reloaded.
+     * @param filepath full path of the deleted file or directory.
+     */
+    void removeModel (const std::string & filepath);
     
     /**
      * Notify the entity list that it needs to refilter.
@@ -153,6 +188,37 @@ protected:
      * @param model the list to add an models.
      */
     void scanDir (const std::string & datadir, GtkListStore *model);
+
+    /**
+     * Load the given model file as an object not yet present on the map.
+     * @param filepath full path of the model to load.
+     * @return the loaded model or NULL on error.
+     */
+    MapEntity *loadModel (const std::string & filepath);
+
+    /**
+     * Store data of a freshly loaded model in the model cache.
+     * @param filepath full path of the model.
+     * @param ety the loaded model.
+     */
+    void cacheModel (const std::string & filepath, const MapEntity *ety);
+
+    /**
+     * Find the row containing the model with the given file name.
+     * @param model_path path of the model, relative to the data directory.
+     * @param iter will point to the row of the model, if found.
+     * @param ignore_ext whether to compare file names without extension.
+     * @return true if found, false otherwise.
+     */
+    bool findModel (const std::string & model_path, GtkTreeIter *iter, const bool & ignore_ext = false) const;
+
+    /**
+     * Remove the entity in the given row from the list and delete it.
+     * @param model the list store containing the entity.
+     * @param iter the row to remove. Will point to the next row afterwards.
+     * @return true if iter points to a valid row, false otherwise.
+     */
+    bool removeRow (GtkListStore *model, GtkTreeIter *iter);
     
 private:
     /// the data directory containing entities
@@ -165,6 +231,10 @@ private:
     GtkWidget *Panel;
     /// tree selection changed signal handler
     gulong SelectionChanged;
+    /// monitors the data directory for changed models
+    MapModelWatcher *Watcher;
+    /// cache of model data, to speed up scanning the data directory
+    MapManifest *Manifest;
 };
 
 #endif
@@ -26,14 +26,19 @@
 
 #include <adonthell/world/area_manager.h>
 
+#include "common/intern.h"
 #include "gui_filter_dialog.h"
 #include "gui_entity_list.h"
 #include "gui_mapedit.h"
 #include "gui_mapview.h"
+#include "map_connector_index.h"
 
 // static entity filter model instance used throughout mapedit
 GtkListStore *GuiFilterDialog::FilterModel = NULL;
 
+// rows of the filter model
+std::hash_map<u_int32, GtkTreeIter> GuiFilterDialog::TagRows;
+
 // active filter function
 base::functor_1ret<const MapEntity*, bool> *GuiFilterDialog::FilterFunc = base::make_functor_ret (&GuiFilterDialog::filterByConnector);
 
@@ -43,6 +48,27 @@ GuiFilterDialog::filter_type GuiFilterDialog::ActiveFilter = GuiFilterDialog::BY
 // whether filter is active or not
 bool GuiFilterDialog::Paused = false;
 
+// entities matching the enabled tags
+MapTagIndex::bitset GuiFilterDialog::TagFilter;
+
+// tag index revision used for computing matching entities
+u_int32 GuiFilterDialog::TagFilterRevision = 0;
+
+// whether matching entities need to be computed
+bool GuiFilterDialog::TagFilterChanged = true;
+
+// whether entities need to contain all enabled tags
+bool GuiFilterDialog::MatchAll = false;
+
+// entities fitting to the selected entity
+MapTagIndex::bitset GuiFilterDialog::ConnectorFilter;
+
+// selected entity used for computing fitting entities
+const MapEntity *GuiFilterDialog::ConnectorFilterEntity = NULL;
+
+// connector index revision used for computing fitting entities
+u_int32 GuiFilterDialog::ConnectorFilterRevision = 0;
+
 // Ui definition
 static char filter_dialog_ui[] =
 #include "entity-filter.glade.h"
@@ -69,6 +95,13 @@ static void on_filtered_toggled (GtkCellRendererToggle *cell, gchar *path_str, g
     gtk_tree_path_free (path);
 
     // update entity list
+    GuiFilterDialog::tagSelectionChanged();
+    GuiMapedit::window->entityList()->filterChanged();
+}
+
+static void on_match_all_toggled (GtkToggleButton *btn, gpointer data)
+{
+    GuiFilterDialog::setMatchAll (gtk_toggle_button_get_active (btn));
     GuiMapedit::window->entityList()->filterChanged();
 }
 
@@ -121,9 +154,15 @@ GuiFilterDialog::GuiFilterDialog (GtkListStore *filter_model)
     if (ActiveFilter == BY_CONNECTOR) gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(widget), true);
     g_signal_connect (G_OBJECT(widget), "toggled", G_CALLBACK(on_filter_changed), this);
 
+    widget = gtk_builder_get_object (Ui, "cb_match_all");
+    gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON(widget), MatchAll);
+    g_signal_connect (G_OBJECT(widget), "toggled", G_CALLBACK(on_match_all_toggled), this);
+
     // only activate tag list if filtering by tag
     widget = gtk_builder_get_object (Ui, "scrolledwindow1");
     gtk_widget_set_sensitive (GTK_WIDGET (widget), ActiveFilter == BY_TAG);
+    widget = gtk_builder_get_object (Ui, "cb_match_all");
+    gtk_widget_set_sensitive (GTK_WIDGET (widget), ActiveFilter == BY_TAG);
 
     // move dialog out of the way
     int x, y;
@@ -155,6 +194,8 @@ void GuiFilterDialog::setFilter (const std::string & name)
     // only activate tag list if filtering by tag
     GObject *widget = gtk_builder_get_object (Ui, "scrolledwindow1");
     gtk_widget_set_sensitive (GTK_WIDGET (widget), name == "rb_filter_tag");
+    widget = gtk_builder_get_object (Ui, "cb_match_all");
+    gtk_widget_set_sensitive (GTK_WIDGET (widget), name == "rb_filter_tag");
 
     // set filter function, if any
     if (name == "rb_filter_tag")
@@ -212,7 +253,8 @@ bool GuiFilterDialog::isEntityFiltered (const MapEntity *entity)
 
     // some common filters
     if (entity == NULL) return true;
-    if (entity->hasTag ("template")) return true;
+    static u_int32 template_tag = intern::get ("template");
+    if (MapTagIndex::has_tag (entity->getIndex(), template_tag)) return true;
     if (entity == GuiMapedit::window->view()->getSelectedObject()) return false;
 
     if (FilterFunc != NULL) return (*FilterFunc)(entity);
@@ -242,56 +284,93 @@ void GuiFilterDialog::resumeFiltering()
 }
 
 // check for a tag in the filter's list
-bool GuiFilterDialog::findTagInFilter (const gchar *tag, GtkTreeIter *result)
+bool GuiFilterDialog::findTagInFilter (const u_int32 & tag, GtkTreeIter *result)
 {
-    GtkTreeModel *model = GTK_TREE_MODEL (getFilterModel());
-    GtkTreeIter iter;
+    std::hash_map<u_int32, GtkTreeIter>::const_iterator row = TagRows.find (tag);
+    if (row == TagRows.end()) return false;
+
+    // rows of a list store stay valid as long as they exist
+    *result = row->second;
+    return true;
+}
+
+// add tag to the filter's list
+void GuiFilterDialog::addTag (const u_int32 & tag)
+{
+    static u_int32 template_tag = intern::get ("template");
 
-    // iterate over all entities in model
-    if (gtk_tree_model_get_iter_first (model, &iter))
+    GtkTreeIter row;
+    GtkListStore *filter_model = getFilterModel();
+
+    if (findTagInFilter (tag, &row))
+    {
+        // tag already present? -> update count
+        guint count;
+        gtk_tree_model_get (GTK_TREE_MODEL(filter_model), &row, 2, &count, -1);
+        gtk_list_store_set (filter_model, &row, 2, count+1, -1);
+    }
+    else
     {
-        do
+        // otherwise insert new row
+        if (tag != template_tag)
         {
-            gchar *value = NULL;
-            gtk_tree_model_get (model, &iter, 1, &value, -1);
-
-            // found tag in model?
-            if (strcmp(tag, value) == 0)
-            {
-                *result = iter;
-                return true;
-            }
+            gtk_list_store_append (filter_model, &row);
+            gtk_list_store_set (filter_model, &row, 0, false, 1, intern::str (tag).c_str(), 2, 1, -1);
+            TagRows[tag] = row;
         }
-        while (gtk_tree_model_iter_next (model, &iter));
     }
+}
 
-    return false;
+// remove tag from the filter's list
+void GuiFilterDialog::removeTag (const u_int32 & tag)
+{
+    GtkTreeIter row;
+    GtkListStore *filter_model = getFilterModel();
+
+    if (findTagInFilter (tag, &row))
+    {
+        // decrease tag count
+        guint count;
+        gtk_tree_model_get (GTK_TREE_MODEL(filter_model), &row, 2, &count, -1);
+        gtk_list_store_set (filter_model, &row, 2, count-1, -1);
+    }
 }
 
-// show all entities containing one of the selected tags
+// show all entities containing one or all of the selected tags
 bool GuiFilterDialog::filterByTag (const MapEntity *entity)
 {
-    GtkTreeIter filterIter;
+    if (TagFilterChanged || TagFilterRevision != MapTagIndex::revision())
+    {
+        updateTagFilter ();
+    }
+
+    return !MapTagIndex::contains (TagFilter, entity->getIndex());
+}
+
+// collect all entities containing one or all of the selected tags
+void GuiFilterDialog::updateTagFilter ()
+{
     GtkTreeModel *filter = GTK_TREE_MODEL (GuiFilterDialog::getFilterModel());
+    bool first = true;
+
+    TagFilter.clear ();
 
-    if (gtk_tree_model_get_iter_first (filter, &filterIter))
+    for (std::hash_map<u_int32, GtkTreeIter>::iterator i = TagRows.begin(); i != TagRows.end(); i++)
     {
-        do
-        {
-            bool enabled = false;
-            gchar *tag = NULL;
-            gtk_tree_model_get (filter, &filterIter, 0, &enabled, 1, &tag, -1);
-
-            // found tag in model?
-            if (enabled && entity->hasTag(tag))
-            {
-                return false;
-            }
-        }
-        while (gtk_tree_model_iter_next (filter, &filterIter));
+        gboolean enabled = false;
+        gtk_tree_model_get (filter, &i->second, 0, &enabled, -1);
+
+        if (!enabled) continue;
+
+        // the first enabled tag sets the initial result in either case
+        if (MatchAll && !first) MapTagIndex::intersect (i->first, TagFilter);
+        else MapTagIndex::merge (i->first, TagFilter);
+
+        first = false;
     }
 
-    return true;
+    TagFilterRevision = MapTagIndex::revision();
+    TagFilterChanged = false;
 }
 
 // show all entities with matching connector
@@ -302,5 +381,25 @@ bool GuiFilterDialog::filterByConnector (const MapEntity *entity)
     if (curObj == NULL) return false;
 
     // now check if there is at least one matching connector
-    return !curObj->canConnectWith (entity, true);
+    if (curObj != ConnectorFilterEntity || ConnectorFilterRevision != MapConnectorIndex::revision())
+    {
+        updateConnectorFilter (curObj);
+    }
+
+    return !MapTagIndex::contains (ConnectorFilter, entity->getIndex());
+}
+
+// collect all entities with matching connector
+void GuiFilterDialog::updateConnectorFilter (const MapEntity *entity)
+{
+    ConnectorFilter.clear ();
+
+    const std::vector<MdlConnector*> & connectors = entity->get_connectors ();
+    for (std::vector<MdlConnector*>::const_iterator i = connectors.begin(); i != connectors.end(); i++)
+    {
+        MapConnectorIndex::merge_matching (*i, ConnectorFilter);
+    }
+
+    ConnectorFilterEntity = entity;
+    ConnectorFilterRevision = MapConnectorIndex::revision();
 }
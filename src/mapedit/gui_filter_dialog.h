@@ -28,9 +28,11 @@
 #define GUI_FILTER_DIALOG_H
 
 #include <adonthell/base/callback.h>
+#include <adonthell/base/hash_map.h>
 
 #include "gui_modal_dialog.h"
 #include "gui_grid.h"
+#include "map_tag_index.h"
 
 class MapEntity;
 
@@ -104,20 +106,56 @@ public:
      * Check if the given tag is already contained in the list of all tags.
      * If it is found, out parameter result is set to an iterator pointing
      * at the row that contains the tag.
-     * @param tag the tag to find
+     * @param tag the interned tag to find
      * @param result iterator pointing at tag, if found
      * @return true on success, false otherwise.
      */
-    static bool findTagInFilter (const gchar *tag, GtkTreeIter *result);
+    static bool findTagInFilter (const u_int32 & tag, GtkTreeIter *result);
+
+    /**
+     * Add the given tag to the list of all tags or increase its
+     * count if it is already present.
+     * @param tag the interned tag to add.
+     */
+    static void addTag (const u_int32 & tag);
+
+    /**
+     * Decrease the count of the given tag in the list of all tags.
+     * @param tag the interned tag to remove.
+     */
+    static void removeTag (const u_int32 & tag);
+
+    /**
+     * Notify the filter that tags have been enabled or disabled.
+     */
+    static void tagSelectionChanged () { TagFilterChanged = true; }
+
+    /**
+     * Set whether entities have to contain all enabled tags to be
+     * shown, or only one of them.
+     * @param match_all true to show only entities with all enabled tags.
+     */
+    static void setMatchAll (const bool & match_all)
+    {
+        MatchAll = match_all;
+        TagFilterChanged = true;
+    }
 
 protected:
     /**
-     * Show an entity if it contains at least one of the enabled tags.
+     * Show an entity if it contains at least one of the enabled tags,
+     * or all of them if so requested.
      * @param entity the entity to filter
      * @return true to hide entity from list, false otherwise.
      */
     static bool filterByTag (const MapEntity *entity);
 
+    /**
+     * Collect all entities containing at least one of the enabled tags,
+     * or all of them if so requested.
+     */
+    static void updateTagFilter ();
+
     /**
      * Show an entity if it shares at least one connector with the
      * entity currently selected for placing onto the map.
@@ -126,15 +164,37 @@ protected:
      */
     static bool filterByConnector (const MapEntity *entity);
 
+    /**
+     * Collect all entities sharing a connector with the given entity.
+     * @param entity the entity currently selected for placing.
+     */
+    static void updateConnectorFilter (const MapEntity *entity);
+
 private:
     /// filter model instance used throughout mapedit
     static GtkListStore *FilterModel;
+    /// rows of the filter model, indexed by interned tag
+    static std::hash_map<u_int32, GtkTreeIter> TagRows;
     /// the function used to filter the entity list
     static base::functor_1ret<const MapEntity*, bool> *FilterFunc;
     /// the currently active filter
     static filter_type ActiveFilter;
     /// whether filtering is suspended
     static bool Paused;
+    /// entities containing at least one or all of the enabled tags
+    static MapTagIndex::bitset TagFilter;
+    /// whether entities need to contain all enabled tags
+    static bool MatchAll;
+    /// revision of the tag index the tag filter has been computed from
+    static u_int32 TagFilterRevision;
+    /// whether the enabled tags changed since computing the tag filter
+    static bool TagFilterChanged;
+    /// entities sharing a connector with the selected entity
+    static MapTagIndex::bitset ConnectorFilter;
+    /// the selected entity the connector filter has been computed for
+    static const MapEntity *ConnectorFilterEntity;
+    /// revision of the connector index the connector filter has been computed from
+    static u_int32 ConnectorFilterRevision;
 
     /// the user interface
     GtkBuilder *Ui;
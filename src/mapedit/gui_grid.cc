@@ -28,10 +28,17 @@
 #include "gui_grid.h"
 #include "map_entity.h"
 
+/// minimum extension of the grid pattern
+#define MIN_PATTERN_SIZE 256
+
 // ctor
 GuiGrid::GuiGrid (gfx::surface *overlay)
 {
     Overlay = overlay;
+    Pattern = NULL;
+    PatternIx = 0;
+    PatternIy = 0;
+    PatternScale = 0;
     Changed = false;
     Visible = false;
     SnapToGrid = true;
@@ -58,6 +65,7 @@ GuiGrid::~GuiGrid ()
 {
     delete RefLocation;
     delete RefEntity;
+    delete Pattern;
 }
 
 // draw the grid
@@ -72,23 +80,71 @@ void GuiGrid::draw (const s_int32 & x, const s_int32 & y, const u_int16 & l, con
     
     if (Visible)
     {
-        int l = Overlay->length();
-        int h = Overlay->height();
+        render_pattern ();
         
-        // draw vertical lines
-        for (int i = Mx * base::Scale; i < l; i += Ix * base::Scale)
-        {
-            Overlay->fillrect (i, 0, 1, h, 0x88FFFFFF);
-        }
+        s_int32 pl = Pattern->length();
+        s_int32 ph = Pattern->height();
         
-        // draw horizontal lines
-        for (int j = My * base::Scale; j < h; j += Iy * base::Scale)
+        // set clipping rectangle
+        gfx::drawing_area da (x, y, l, h);
+        
+        // first pattern origin at or before the given area
+        s_int32 sx = Mx * base::Scale;
+        s_int32 sy = My * base::Scale;
+        sx -= ((sx - x) / pl + (sx > x ? 1 : 0)) * pl;
+        sy -= ((sy - y) / ph + (sy > y ? 1 : 0)) * ph;
+        
+        // repeat pattern across the area
+        for (s_int32 j = sy; j < y + h; j += ph)
         {
-            Overlay->fillrect (0, j, l, 1, 0x88FFFFFF);
+            for (s_int32 i = sx; i < x + l; i += pl)
+            {
+                Pattern->draw (i, j, &da, Overlay);
+            }
         }
     }
 }
 
+// render grid pattern
+void GuiGrid::render_pattern ()
+{
+    if (Pattern != NULL && PatternIx == Ix && PatternIy == Iy && PatternScale == base::Scale)
+    {
+        return;
+    }
+    
+    if (Pattern == NULL)
+    {
+        Pattern = gfx::create_surface ();
+        Pattern->set_alpha (255, true);
+    }
+    
+    PatternIx = Ix;
+    PatternIy = Iy;
+    PatternScale = base::Scale;
+    
+    // a single cell of a fine grid would need to be repeated too often
+    s_int32 cl = Ix * base::Scale;
+    s_int32 ch = Iy * base::Scale;
+    s_int32 l = cl * ((MIN_PATTERN_SIZE + cl - 1) / cl);
+    s_int32 h = ch * ((MIN_PATTERN_SIZE + ch - 1) / ch);
+    
+    Pattern->resize (l, h);
+    Pattern->fillrect (0, 0, l, h, 0);
+    
+    // draw vertical lines
+    for (s_int32 i = 0; i < l; i += cl)
+    {
+        Pattern->fillrect (i, 0, 1, h, 0x88FFFFFF);
+    }
+    
+    // draw horizontal lines
+    for (s_int32 j = 0; j < h; j += ch)
+    {
+        Pattern->fillrect (0, j, l, 1, 0x88FFFFFF);
+    }
+}
+
 // set reference to which to adjust the grid
 void GuiGrid::set_reference (const world::vector3<s_int32> & pos, MapEntity *entity)
 {
@@ -178,6 +178,12 @@ protected:
     GridMonitor *Monitor;
 
 private:
+    /**
+     * Render the grid pattern, unless it still matches
+     * the current grid interval and scale.
+     */
+    void render_pattern ();
+
     /// object selected for painting the map
     MapEntity *CurObject;
     /// object used to align the grid to
@@ -188,6 +194,14 @@ private:
     world::chunk_info *RefLocation;
     /// overlay onto which to draw grid
     gfx::surface *Overlay;
+    /// a block of grid cells, repeated to cover the overlay
+    gfx::surface *Pattern;
+    /// x interval the pattern was rendered for
+    u_int16 PatternIx;
+    /// y interval the pattern was rendered for
+    u_int16 PatternIy;
+    /// scale the pattern was rendered for
+    u_int16 PatternScale;
     /// whether grid needs to be rendered
     bool Visible;
     /// whether to align objects with grid
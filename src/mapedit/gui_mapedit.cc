@@ -38,6 +38,8 @@
 #endif
 
 #include "mapedit/map_cmdline.h"
+#include "mapedit/map_data.h"
+#include "mapedit/map_saver.h"
 #include "mapedit/gui_mapedit.h"
 #include "mapedit/gui_mapedit_events.h"
 #include "mapedit/gui_mapview.h"
@@ -182,6 +184,24 @@ GuiMapedit::GuiMapedit ()
     gtk_menu_item_set_submenu (GTK_MENU_ITEM (menuitem), submenu);
     gtk_menu_shell_append (GTK_MENU_SHELL (menu), menuitem);
 
+    // Edit menu
+    submenu = gtk_menu_new ();
+
+    // Undo
+    menuitem = gtk_image_menu_item_new_from_stock ("gtk-undo", accel_group);
+    gtk_menu_shell_append (GTK_MENU_SHELL (submenu), menuitem);
+    g_signal_connect (G_OBJECT (menuitem), "activate", G_CALLBACK (on_edit_undo), (gpointer) this);
+
+    // Redo
+    menuitem = gtk_image_menu_item_new_from_stock ("gtk-redo", accel_group);
+    gtk_menu_shell_append (GTK_MENU_SHELL (submenu), menuitem);
+    g_signal_connect (G_OBJECT (menuitem), "activate", G_CALLBACK (on_edit_redo), (gpointer) this);
+
+    // Attach Edit Menu
+    menuitem = gtk_menu_item_new_with_mnemonic ("_Edit");
+    gtk_menu_item_set_submenu (GTK_MENU_ITEM (menuitem), submenu);
+    gtk_menu_shell_append (GTK_MENU_SHELL (menu), menuitem);
+
     // View menu
     submenu = gtk_menu_new ();
 
@@ -223,6 +243,21 @@ GuiMapedit::GuiMapedit ()
     gtk_widget_add_accelerator(menuitem, "activate", accel_group, GDK_KEY_g, GDK_CONTROL_MASK, GTK_ACCEL_VISIBLE);
     g_signal_connect (G_OBJECT (menuitem), "activate", G_CALLBACK (on_goto_location), (gpointer) this);
 
+    // Separator
+    menuitem = gtk_menu_item_new ();
+    gtk_menu_shell_append (GTK_MENU_SHELL (submenu), menuitem);
+    gtk_widget_set_sensitive (menuitem, FALSE);
+
+    // Walkability
+    menuitem = gtk_check_menu_item_new_with_label ("Walkability");
+    gtk_menu_shell_append (GTK_MENU_SHELL (submenu), menuitem);
+    g_signal_connect (G_OBJECT (menuitem), "toggled", G_CALLBACK (on_view_walkability), (gpointer) this);
+
+    // Rebuild walkability
+    menuitem = gtk_menu_item_new_with_label ("Rebuild Walkability");
+    gtk_menu_shell_append (GTK_MENU_SHELL (submenu), menuitem);
+    g_signal_connect (G_OBJECT (menuitem), "activate", G_CALLBACK (on_view_rebuild_walkability), (gpointer) this);
+
     // Attach View Menu
     menuitem = gtk_menu_item_new_with_mnemonic ("_View");
     gtk_menu_item_set_submenu (GTK_MENU_ITEM (menuitem), submenu);
@@ -353,7 +388,7 @@ void GuiMapedit::OnRecentFileActivated (const std::string & file)
 void GuiMapedit::loadMap (const std::string & fname)
 {
     MapData *area = new MapData();
-    if (!area->load (fname))
+    if (!area->loadFile (fname))
     {
         // TODO: display warning
     }
@@ -370,6 +405,31 @@ void GuiMapedit::loadMap (const std::string & fname)
     ZoneList->setMap (area);
     
     EntityList->setDataDir (MapCmdline::datadir + "/" + MapCmdline::project + "/" + MapCmdline::modeldir);
+
+    // previous session ended without saving?
+    bool recover = false;
+    if (MapJournal::has_unsaved_edits (fname))
+    {
+        GtkWidget *dlg = gtk_message_dialog_new (GTK_WINDOW (Wnd), GTK_DIALOG_MODAL, 
+            GTK_MESSAGE_QUESTION, GTK_BUTTONS_YES_NO, "Unsaved changes to this map have been found. Restore them?");
+        recover = gtk_dialog_run (GTK_DIALOG (dlg)) == GTK_RESPONSE_YES;
+        gtk_widget_destroy (dlg);
+    }
+
+    if (recover)
+    {
+        if (!area->journal()->replay (fname, EntityList))
+        {
+            fprintf (stderr, "*** loadMap: some changes to '%s' could not be restored\n", fname.c_str());
+        }
+
+        ZoneList->refresh ();
+        View->refresh ();
+        initTitle (true);
+    }
+
+    // record changes from now on
+    area->journal()->open (fname, recover);
 }
 
 // save map to disk
@@ -379,13 +439,63 @@ void GuiMapedit::saveMap (const std::string & fname)
     if (ActiveMap == -1) return;
     
     MapData *area = LoadedMaps[ActiveMap];
-    if (!area->save (fname, base::diskio::XML_FILE))
+
+    // maps are written in the background
+    MapSaver::start (area, fname, on_map_saved, this);
+}
+
+// map saved in the background
+void GuiMapedit::mapSaved (MapData *map, const bool & result)
+{
+    if (!result)
+    {
+        fprintf (stderr, "*** mapSaved: saving '%s' failed\n", map->filename().c_str());
+        return;
+    }
+
+    // user might have switched to another map meanwhile
+    if (ActiveMap != -1 && LoadedMaps[ActiveMap] == map)
+    {
+        initTitle (map->journal()->modified ());
+    }
+
+    RecentFiles->registerFile(map->filename(), MIME_TYPE);
+}
+
+// revert last edit of the map
+void GuiMapedit::undo ()
+{
+    if (ActiveMap == -1) return;
+    
+    MapData *area = LoadedMaps[ActiveMap];
+    if (area->journal()->undo ())
     {
-        // error
+        updateView ();
     }
+}
 
-    initTitle ();
-    RecentFiles->registerFile(fname, MIME_TYPE);
+// repeat last reverted edit of the map
+void GuiMapedit::redo ()
+{
+    if (ActiveMap == -1) return;
+    
+    MapData *area = LoadedMaps[ActiveMap];
+    if (area->journal()->redo ())
+    {
+        updateView ();
+    }
+}
+
+// display result of undo or redo
+void GuiMapedit::updateView ()
+{
+    ZoneList->refresh ();
+    View->refresh ();
+
+    // entities might have been added or removed
+    gtk_widget_queue_draw (EntityList->getWidget ());
+
+    initTitle (true);
 }
 
 // sets the window title
@@ -98,6 +98,23 @@ public:
      * @param fname name under which to save the map.
      */
     void saveMap (const std::string & fname);
+
+    /**
+     * Update the display once a map has been saved in the background.
+     * @param map the map that has been saved.
+     * @param result true if the map was written, false on error.
+     */
+    void mapSaved (MapData *map, const bool & result);
+
+    /**
+     * Revert the last edit of the active map.
+     */
+    void undo ();
+
+    /**
+     * Repeat the last reverted edit of the active map.
+     */
+    void redo ();
     
     /**
      * Display location (of cursor) in the status bar.
@@ -134,6 +151,11 @@ private:
      * @param modified whether the map has been modified since last saving.
      */
     void initTitle (const bool & modified = false);
+
+    /**
+     * Update all widgets after undo or redo changed the map.
+     */
+    void updateView ();
     /**
      * Set the GUI back to it's initial state.
      */
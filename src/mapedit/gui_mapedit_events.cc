@@ -31,10 +31,16 @@
 #include "gui_goto_dialog.h"
 #include "gui_grid_dialog.h"
 #include "gui_file.h"
+#include "map_data.h"
+#include "map_mgr.h"
+#include "map_saver.h"
 
 // Main Window: on_widget_destroy App
 void on_widget_destroy (GtkWidget * widget, gpointer data)
 {
+    // don't quit while a map is still being written
+    MapSaver::wait ();
+
     gtk_main_quit ();
     gtk_widget_destroy (widget);
 }
@@ -53,7 +59,7 @@ void on_file_load_activate (GtkMenuItem * menuitem, gpointer user_data)
     GtkWindow *parent = GTK_WINDOW(mapedit->getWindow());
     
     GuiFile fs (parent, GTK_FILE_CHOOSER_ACTION_OPEN, "Load map", mapedit->directory ());
-    fs.add_filter ("*.amap|*.xml", "Adonthell Map");
+    fs.add_filter ("*.amap|*.bmap|*.xml", "Adonthell Map");
     fs.add_shortcut (base::Paths().user_data_dir() + "/");
 
     // File selection closed with OK
@@ -88,6 +94,7 @@ void on_file_save_as_activate (GtkMenuItem * menuitem, gpointer user_data)
 
     GuiFile fs (parent, GTK_FILE_CHOOSER_ACTION_SAVE, "Save Map", filename);
     fs.add_filter ("*.amap", "Adonthell Map");
+    fs.add_filter ("*.bmap", "Adonthell Map (binary)");
     fs.add_shortcut (base::Paths().user_data_dir() + "/");
 
     // File selection closed with OK
@@ -121,6 +128,20 @@ void on_file_close_activate (GtkMenuItem * menuitem, gpointer user_data)
 }
 */
 
+// Edit Menu: Undo
+void on_edit_undo (GtkMenuItem * menuitem, gpointer user_data)
+{
+    GuiMapedit *mapedit = (GuiMapedit *) user_data;
+    mapedit->undo ();
+}
+
+// Edit Menu: Redo
+void on_edit_redo (GtkMenuItem * menuitem, gpointer user_data)
+{
+    GuiMapedit *mapedit = (GuiMapedit *) user_data;
+    mapedit->redo ();
+}
+
 GuiGridDialog *gridCtrl = NULL;
 
 // turn grid on or off
@@ -148,6 +169,13 @@ void on_tree_switched (GtkNotebook *nb, gpointer page, guint page_num, gpointer
     view->showZones (page_num == 1);
 }
 
+// Map saved in the background
+void on_map_saved (MapData *map, const bool & result, void *user_data)
+{
+    GuiMapedit *mapedit = (GuiMapedit *) user_data;
+    mapedit->mapSaved (map, result);
+}
+
 /*
 // Display help text associated with a menuitem to the statusbar 
 gboolean on_display_help (GtkWidget *widget, GdkEventCrossing *event, gpointer user_data)
@@ -238,3 +266,24 @@ void on_goto_location (GtkMenuItem * menuitem, gpointer user_data)
     GuiGotoDialog dlg;
     dlg.run();
 }
+
+// View Menu: Walkability
+void on_view_walkability (GtkCheckMenuItem * menuitem, gpointer user_data)
+{
+    GuiMapedit *mapedit = (GuiMapedit *) user_data;
+    mapedit->view()->showWalkability (gtk_check_menu_item_get_active (menuitem));
+}
+
+// View Menu: Rebuild Walkability
+void on_view_rebuild_walkability (GtkMenuItem * menuitem, gpointer user_data)
+{
+    MapData *map = (MapData*) MapMgr::get_map();
+    if (map == NULL) return;
+
+    // objects might have changed state since they were placed
+    map->walkGrid()->rebuild (map);
+
+    GuiMapedit *mapedit = (GuiMapedit *) user_data;
+    mapedit->view()->updateOverlay ();
+    mapedit->view()->draw ();
+}
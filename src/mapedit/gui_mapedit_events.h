@@ -29,6 +29,8 @@
 #ifndef GUI_MAPEDIT_EVENTS_H
 #define GUI_MAPEDIT_EVENTS_H
 
+class MapData;
+
 void on_widget_destroy (GtkWidget *, gpointer);
 
 // File Menu Callbacks
@@ -41,15 +43,24 @@ void on_file_save_as_activate (GtkMenuItem *, gpointer);
 // void on_file_close_activate (GtkMenuItem *, gpointer);
 void on_grid_toggled (GtkToggleButton *, gpointer);
 
+// Edit Menu Callbacks
+void on_edit_undo (GtkMenuItem * menuitem, gpointer user_data);
+void on_edit_redo (GtkMenuItem * menuitem, gpointer user_data);
+
 // View Menu Callbacks
 void on_model_zoom_in (GtkMenuItem * menuitem, gpointer user_data);
 void on_model_zoom_out (GtkMenuItem * menuitem, gpointer user_data);
 void on_model_reset_zoom (GtkMenuItem * menuitem, gpointer user_data);
 void on_goto_location (GtkMenuItem * menuitem, gpointer user_data);
+void on_view_walkability (GtkCheckMenuItem * menuitem, gpointer user_data);
+void on_view_rebuild_walkability (GtkMenuItem * menuitem, gpointer user_data);
 
 // Main Window Callbacks
 void on_tree_switched (GtkNotebook *, gpointer, guint, gpointer);
 
+// Map Saver Callbacks
+void on_map_saved (MapData *map, const bool & result, void *user_data);
+
 // Statusbar callbacks
 // gboolean on_display_help (GtkWidget *widget, GdkEventCrossing *event, gpointer user_data);
 // gboolean on_clear_help (GtkWidget *widget, GdkEventCrossing *event, gpointer user_data);
@@ -33,11 +33,21 @@
 #include "gui_mapedit.h"
 #include "gui_mapview.h"
 #include "gui_mapview_events.h"
+#include "gui_walk_grid.h"
 #include "gui_zone.h"
+#include "map_command.h"
 #include "map_data.h"
 #include "map_entity.h"
 #include "map_mgr.h"
 
+// create edit for removing entity from the map
+static MapCommand *remove_command (MapEntity *ety, world::chunk_info *location)
+{
+    MapEntityCommand *cmd = new MapEntityCommand (ety);
+    cmd->remove (location->Min);
+    return cmd;
+}
+
 // ctor
 GuiMapview::GuiMapview(GtkWidget *paned)
 {
@@ -89,6 +99,7 @@ GuiMapview::GuiMapview(GtkWidget *paned)
     // create the grid
     Grid = new GuiGrid (Overlay);
     Zones = new GuiZone (Overlay);
+    WalkGrid = new GuiWalkGrid (Overlay);
     
     // Memeber intialization
     CurObj = NULL;
@@ -102,6 +113,7 @@ GuiMapview::~GuiMapview()
     delete Target;
     delete Overlay;
     delete Grid;
+    delete WalkGrid;
 }
 
 // set map to render
@@ -110,6 +122,9 @@ void GuiMapview::setMap (MapData *area)
     MapMgr::set_map (area);
     
     View->set_position (area->x(), area->y(), area->z());
+
+    // load objects in view
+    updateRegions (area);
     
     // display map coordinates of mouse pointer
     updateLocation (area);
@@ -209,6 +224,9 @@ void GuiMapview::render (const int & sx, const int & sy, const int & l, const in
         View->resize (l, h);
         View->draw (sx, sy, NULL, Target);        
     }
+
+    // objects placed or removed might have changed walkability
+    if (WalkGrid->is_outdated ()) updateOverlay ();
     
     // schedule screen update
     GdkRectangle rect = { sx * base::Scale, sy * base::Scale, l * base::Scale, h * base::Scale };
@@ -244,6 +262,8 @@ void GuiMapview::updateOverlay()
     Grid->draw();
     // redraw zones
     Zones->update();
+    // redraw blocked cells
+    WalkGrid->update();
 }
 
 // update size of the view
@@ -556,6 +576,9 @@ void GuiMapview::selectObj (MapEntity *ety)
     DrawObj = ety;
     MapData *area = (MapData*) MapMgr::get_map();
 
+    // start a new paint stroke
+    area->journal()->seal();
+
     // build a fake location
     world::placeable *obj = ety->object();
     world::named_entity e (obj, "tmp", false);
@@ -608,6 +631,9 @@ void GuiMapview::selectObj (MapEntity *ety)
     // update zones, if displayed
     Zones->update();
 
+    // update blocked cells, if displayed
+    WalkGrid->update();
+
     // update overlap indication
     highlightObject();
 
@@ -624,6 +650,10 @@ void GuiMapview::releaseObject ()
         // stop selection, if it is in progress
         CandidateObj = NULL;
 
+        // end the current paint stroke
+        MapData *area = (MapData*) MapMgr::get_map();
+        area->journal()->seal();
+
         // hide grid
         Grid->set_visible (false);
         Grid->draw ();
@@ -665,8 +695,9 @@ void GuiMapview::moveCurObject()
         // select object for drawing ...
         selectCurObj();
 
-        // ... and remove it from map
-        if (CurObj->removeAtCurLocation())
+        // ... and remove it from map, so that placing it again will complete the move
+        MapData *area = (MapData*) MapMgr::get_map();
+        if (location != NULL && area->journal()->execute (remove_command (CurObj, location)))
         {
             // on success, redraw area containing object
             Renderer.clearSelection();
@@ -732,7 +763,10 @@ void GuiMapview::placeCurObj()
         world::coordinates pos (DrawObjPos.x() + area->x(), DrawObjPos.y() + area->y() + h, area->z()); 
         
         // try adding object to map
-        if (DrawObj->addToLocation (pos))
+        MapEntityCommand *cmd = new MapEntityCommand (DrawObj);
+        cmd->place (world::vector3<s_int32> (pos.x(), pos.y(), pos.z()));
+        
+        if (area->journal()->execute (cmd))
         {
             // cannot place same object twice at this position
             indicateOverlap();
@@ -781,7 +815,8 @@ void GuiMapview::deleteCurObj ()
         world::chunk_info *location = CurObj->getLocation();
         
         // remove object from map
-        if (CurObj->removeAtCurLocation())
+        MapData *area = (MapData*) MapMgr::get_map();
+        if (location != NULL && area->journal()->execute (remove_command (CurObj, location)))
         {
             // on success, redraw area containing object
             Renderer.clearSelection();
@@ -797,6 +832,27 @@ void GuiMapview::deleteCurObj ()
     }
 }
 
+// update view after map changed through undo or redo
+void GuiMapview::refresh ()
+{
+    MapData *area = (MapData*) MapMgr::get_map();
+    if (area == NULL) return;
+    
+    // highlighted object might no longer be on the map
+    Renderer.clearSelection();
+    CurObj = NULL;
+    
+    // redraw everything
+    updateOverlay();
+    render();
+    
+    // update valid height range
+    RenderHeight->setMapExtend(area->min().z(), area->max().z());
+
+    // see if there's an object to select
+    highlightObject();
+}
+
 void GuiMapview::showZones (const bool & show)
 {
     Zones->set_visible (show);
@@ -809,6 +865,16 @@ void GuiMapview::showZones (const bool & show)
     draw();
 }
 
+// toggle display of blocked cells
+void GuiMapview::showWalkability (const bool & show)
+{
+    WalkGrid->set_visible (show);
+
+    // redraw overlay with or without blocked cells
+    updateOverlay ();
+    draw ();
+}
+
 // prepare everything for 'auto-scrolling' (TM) ;-)
 bool GuiMapview::scrollingAllowed () const
 {
@@ -825,12 +891,18 @@ void GuiMapview::scroll ()
     area->setX (area->x() - scroll_offset.x);
     area->setY (area->y() - scroll_offset.y);
 
+    // load objects that scrolled into view
+    updateRegions (area);
+
     // update grid
     Grid->scroll (scroll_offset.x, scroll_offset.y);
     
     // update zones, if displayed
     Zones->update();
 
+    // update blocked cells, if displayed
+    WalkGrid->update();
+
     // rendering the whole mapview is less performant than doing
     // gdk_window_scroll (GDK_WINDOW(gtk_widget_get_window (Screen)), scroll_offset.x, scroll_offset.y);
     // but it appears to be the only way to prevent artifacts from appearing
@@ -842,6 +914,27 @@ void GuiMapview::scroll ()
     updateLocation (area);
 }
 
+// load parts of the map in view
+void GuiMapview::updateRegions (MapData *area)
+{
+    GtkAllocation allocation;
+    gtk_widget_get_allocation (Screen, &allocation);
+
+    if (area->regions()->update (area->x(), area->y(), area->z(), allocation.width / base::Scale + 1, allocation.height / base::Scale + 1))
+    {
+        // highlighted object might no longer be on the map
+        if (CurObj != NULL)
+        {
+            CurObj->setLocation (NULL);
+            CurObj = NULL;
+        }
+        Renderer.clearSelection();
+
+        // neither might any other object whose location is known
+        GuiMapedit::window->entityList()->clearLocations ();
+    }
+}
+
 // set a new position
 void GuiMapview::gotoPosition (const s_int32 & x, const s_int32 & y, const s_int32 & z)
 {
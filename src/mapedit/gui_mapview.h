@@ -41,6 +41,7 @@ namespace gfx
 class MapEntity;
 class MapData;
 class GuiGrid;
+class GuiWalkGrid;
 class GuiZone;
 
 /**
@@ -109,6 +110,12 @@ public:
      */
     void render (const int & sx, const int & sy, const int & l, const int & h);
     
+    /**
+     * Redraw everything after the map has been changed
+     * by undoing or redoing an edit.
+     */
+    void refresh ();
+
     /**
      * Render the given object.
      * @param obj the object to render.
@@ -160,6 +167,12 @@ public:
      * @param show true to show zones, false otherwise.
      */
     void showZones (const bool & show);
+
+    /**
+     * Toggle display of cells blocked by solid objects on or off.
+     * @param show true to show blocked cells, false otherwise.
+     */
+    void showWalkability (const bool & show);
     
     /**
      * Update the overlay.
@@ -287,6 +300,12 @@ protected:
      * @param area the current map.
      */
     void updateLocation(MapData *area);
+    /**
+     * Load the parts of the map around the view, unloading others
+     * if necessary.
+     * @param area the current map.
+     */
+    void updateRegions(MapData *area);
 
 private:
     /// Drawing Area
@@ -306,6 +325,8 @@ private:
     GuiRenderHeight *RenderHeight;
     /// Surface for visualizing zones
     GuiZone *Zones;
+    /// Surface for visualizing walkability
+    GuiWalkGrid *WalkGrid;
     
     /// The currently highlighted object
     MapEntity *CurObj;
@@ -0,0 +1,133 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+ 
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software 
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/** 
+* @file mapedit/gui_walk_grid.cc
+*
+* @author Kai Sterker
+* @brief Display walkability on the mapview.
+*/
+
+#include <adonthell/base/base.h>
+#include <adonthell/gfx/gfx.h>
+
+#include "gui_walk_grid.h"
+#include "map_data.h"
+#include "map_mgr.h"
+
+/// size of a cell in pixels
+#define WALK_CELL_SIZE (1 << MAP_WALK_CELL_SHIFT)
+
+// ctor
+GuiWalkGrid::GuiWalkGrid (gfx::surface *overlay)
+{
+    Overlay = overlay;
+    Layer = NULL;
+    Visible = false;
+    Map = NULL;
+    MapX = MapY = MapZ = 0;
+    Scale = 0;
+    Revision = 0;
+}
+
+// dtor
+GuiWalkGrid::~GuiWalkGrid ()
+{
+    delete Layer;
+}
+
+// check whether map changed since last rendering
+bool GuiWalkGrid::is_outdated () const
+{
+    MapData *map = (MapData *) MapMgr::get_map ();
+    return Visible && map != NULL && (Map != map || Revision != map->walkGrid()->revision());
+}
+
+// update walkability display
+void GuiWalkGrid::update ()
+{
+    if (Visible)
+    {
+        // make sure walkability layer is up to date
+        render ();
+
+        // copy blocked cells to the overlay
+        gfx::drawing_area da (0, 0, Overlay->length(), Overlay->height());
+        Layer->draw (0, 0, &da, Overlay);
+    }
+}
+
+// render blocked cells in view onto walkability layer
+void GuiWalkGrid::render ()
+{
+    MapData *map = (MapData *) MapMgr::get_map ();
+    if (map == NULL) return;
+
+    bool resized = false;
+
+    // resize layer along with the overlay
+    if (Layer == NULL || Layer->length() != Overlay->length() || Layer->height() != Overlay->height())
+    {
+        if (Layer == NULL)
+        {
+            Layer = gfx::create_surface ();
+            Layer->set_alpha (255, true);
+        }
+        Layer->resize (Overlay->length(), Overlay->height());
+        resized = true;
+    }
+
+    // cells or view changed since last rendering?
+    if (!resized && Map == map && MapX == map->x() && MapY == map->y() && MapZ == map->z() &&
+        Scale == base::Scale && Revision == map->walkGrid()->revision())
+    {
+        return;
+    }
+
+    Map = map;
+    MapX = map->x();
+    MapY = map->y();
+    MapZ = map->z();
+    Scale = base::Scale;
+    Revision = map->walkGrid()->revision();
+
+    s_int32 l = Layer->length();
+    s_int32 h = Layer->height();
+    gfx::drawing_area da (0, 0, l, h);
+
+    Layer->fillrect (0, 0, l, h, 0);
+
+    // cells on higher levels appear further up the view
+    s_int32 min_z = map->min().z();
+    s_int32 max_z = map->max().z();
+    world::vector3<s_int32> min (map->x(), map->y() - map->z() + min_z, min_z);
+    world::vector3<s_int32> max (map->x() + l / base::Scale, map->y() - map->z() + max_z + h / base::Scale, max_z);
+
+    std::vector<world::vector3<s_int32> > cells;
+    map->walkGrid()->blocked_cells (min, max, cells);
+
+    u_int32 col = Layer->map_color (0xFF, 0x00, 0x00, 64);
+    for (std::vector<world::vector3<s_int32> >::const_iterator i = cells.begin(); i != cells.end(); i++)
+    {
+        s_int16 sx = (i->x() * WALK_CELL_SIZE - map->x()) * base::Scale;
+        s_int16 sy = (i->y() * WALK_CELL_SIZE - i->z() - map->y() + map->z()) * base::Scale;
+
+        Layer->fillrect (sx, sy, WALK_CELL_SIZE * base::Scale, WALK_CELL_SIZE * base::Scale, col, &da);
+    }
+}
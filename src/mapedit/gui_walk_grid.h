@@ -0,0 +1,93 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+ 
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software 
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/** 
+* @file mapedit/gui_walk_grid.h
+*
+* @author Kai Sterker
+* @brief Display walkability on the mapview.
+*/
+
+#ifndef GUI_WALK_GRID_H
+#define GUI_WALK_GRID_H
+
+#include <adonthell/gfx/surface.h>
+#include <adonthell/world/area.h>
+
+/**
+ * Render the cells blocked by solid objects on the mapview.
+ */
+class GuiWalkGrid
+{
+public:
+    /**
+     * Create the walkability view.
+     */
+    GuiWalkGrid (gfx::surface *overlay);
+
+    /**
+     * Cleanup.
+     */
+    ~GuiWalkGrid ();
+
+    /**
+     * Set walkability visible.
+     * @param visible true to show blocked cells.
+     */
+    void set_visible (const bool & visible) { Visible = visible; }
+
+    /**
+     * Check whether the displayed cells no longer match the map,
+     * because objects have been placed or removed.
+     * @return true if the display needs updating, false otherwise.
+     */
+    bool is_outdated () const;
+
+    /**
+     * Update walkability display
+     */
+    void update ();
+
+private:
+    /**
+     * Render blocked cells in view onto the walkability layer,
+     * unless it is still up to date.
+     */
+    void render ();
+
+    /// overlay onto which to draw blocked cells
+    gfx::surface *Overlay;
+    /// blocked cells in view, rendered for blitting onto the overlay
+    gfx::surface *Layer;
+
+    /// whether blocked cells should be rendered
+    bool Visible;
+
+    /**
+     * @name View the walkability layer has been rendered for
+     */
+    //@{
+    const world::area *Map;
+    s_int32 MapX, MapY, MapZ;
+    u_int16 Scale;
+    u_int32 Revision;
+    //@}
+};
+
+#endif
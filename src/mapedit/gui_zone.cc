@@ -35,8 +35,17 @@
 GuiZone::GuiZone (gfx::surface *overlay)
 {
     Overlay = overlay;
+    Layer = NULL;
+    ActiveZone = NULL;
     Changed = false;
     Visible = false;
+    Dirty = true;
+}
+
+// dtor
+GuiZone::~GuiZone ()
+{
+    delete Layer;
 }
 
 // render zones
@@ -50,59 +59,84 @@ void GuiZone::draw (const s_int32 & x, const s_int32 & y, const u_int16 & l, con
     
     if (Visible)
     {
-        MapData *map = (MapData *) MapMgr::get_map ();
-        
+        // make sure zone layer is up to date
+        render ();
+
         // set clipping rectangle
         gfx::drawing_area da (x, y, l, h);
 
-        std::list<world::zone*> zones = map->zones_in_view (x / base::Scale + map->x(), y / base::Scale + map->y(), map->z(), l, h);
-        for (std::list<world::zone*>::const_iterator i = zones.begin(); i != zones.end(); i++)
+        // copy zones in given area to the overlay
+        Layer->draw (0, 0, &da, Overlay);
+    }
+}
+
+// render zones in view onto zone layer
+void GuiZone::render ()
+{
+    MapData *map = (MapData *) MapMgr::get_map ();
+    if (map == NULL) return;
+
+    // resize layer along with the overlay
+    if (Layer == NULL || Layer->length() != Overlay->length() || Layer->height() != Overlay->height())
+    {
+        if (Layer == NULL)
         {
-            u_int8 blue = *i == ActiveZone ? 0xFF : 0x00;
-
-            // get zone location
-            s_int16 sx = ((*i)->min().x() - map->x()) * base::Scale;
-            s_int16 sy = ((*i)->min().y() - (*i)->min().z() - map->y() + map->z()) * base::Scale;
-            
-            // get zone extend
-            s_int16 ex = ((*i)->max().x() - (*i)->min().x()) * base::Scale;
-            s_int16 ey = ((*i)->max().y() - (*i)->min().y()) * base::Scale;
-            s_int16 ez = ((*i)->max().z() - (*i)->min().z()) * base::Scale;
-
-            gfx::surface *area = gfx::create_surface();
-            area->set_alpha (48);
-            area->resize (ex, ey);
-            area->fillrect(0, 0, ex, ey, area->map_color (0x88, 0xFF, blue));
-
-            // draw zone bottom area
-            area->draw (sx, sy, &da, Overlay);
-
-            // draw zone top area
-            area->draw (sx, sy - ez, &da, Overlay);
-
-            u_int32 col = Overlay->map_color (0x88, 0xFF, blue, 0xBB);
-
-            // draw bottom edges
-            Overlay->draw_line(sx, sy, sx, sy + ey, col, &da);
-            Overlay->draw_line(sx, sy, sx + ex, sy, col, &da);
-            Overlay->draw_line(sx + ex, sy, sx + ex, sy + ey, col, &da);
-            Overlay->draw_line(sx, sy + ey, sx + ex, sy + ey, col, &da);
-
-            // draw top edges
-            Overlay->draw_line(sx, sy - ez, sx, sy - ez + ey, col, &da);
-            Overlay->draw_line(sx, sy - ez, sx + ex, sy - ez, col, &da);
-            Overlay->draw_line(sx + ex, sy - ez, sx + ex, sy - ez + ey, col, &da);
-            Overlay->draw_line(sx, sy - ez + ey, sx + ex, sy - ez + ey, col, &da);
-
-            // draw edges between top and bottom
-            Overlay->draw_line(sx, sy, sx, sy - ez, col, &da);
-            Overlay->draw_line(sx, sy + ey, sx, sy + ey - ez, col, &da);
-            Overlay->draw_line(sx + ex, sy, sx + ex, sy - ez, col, &da);
-            Overlay->draw_line(sx + ex, sy + ey, sx + ex, sy + ey - ez, col, &da);
-
-            // cleanup
-            delete area;
+            Layer = gfx::create_surface ();
+            Layer->set_alpha (255, true);
         }
+        Layer->resize (Overlay->length(), Overlay->height());
+        Dirty = true;
+    }
+
+    // zones or view changed since last rendering?
+    if (!Dirty && Map == map && MapX == map->x() && MapY == map->y() && MapZ == map->z() &&
+        Scale == base::Scale && ZoneRevision == map->zoneRevision())
+    {
+        return;
+    }
+
+    Map = map;
+    MapX = map->x();
+    MapY = map->y();
+    MapZ = map->z();
+    Scale = base::Scale;
+    ZoneRevision = map->zoneRevision();
+    Dirty = false;
+
+    s_int32 l = Layer->length();
+    s_int32 h = Layer->height();
+    gfx::drawing_area da (0, 0, l, h);
+
+    Layer->fillrect (0, 0, l, h, 0);
+
+    std::list<world::zone*> zones = map->zones_in_view (map->x(), map->y(), map->z(), l / base::Scale + 1, h / base::Scale + 1);
+    for (std::list<world::zone*>::const_iterator i = zones.begin(); i != zones.end(); i++)
+    {
+        u_int8 blue = *i == ActiveZone ? 0xFF : 0x00;
+
+        // get zone location
+        s_int16 sx = ((*i)->min().x() - map->x()) * base::Scale;
+        s_int16 sy = ((*i)->min().y() - (*i)->min().z() - map->y() + map->z()) * base::Scale;
+        
+        // get zone extend
+        s_int16 ex = ((*i)->max().x() - (*i)->min().x()) * base::Scale;
+        s_int16 ey = ((*i)->max().y() - (*i)->min().y()) * base::Scale;
+        s_int16 ez = ((*i)->max().z() - (*i)->min().z()) * base::Scale;
+
+        // draw zone bottom and top area
+        u_int32 area = Layer->map_color (0x88, 0xFF, blue, 48);
+        Layer->fillrect (sx, sy, ex, ey, area, &da);
+        Layer->fillrect (sx, sy - ez, ex, ey, area, &da);
+
+        // the outline of the box: two vertical edges spanning from 
+        // top to bottom, plus the front and back edges of top and bottom 
+        u_int32 col = Layer->map_color (0x88, 0xFF, blue, 0xBB);
+        Layer->fillrect (sx, sy - ez, 1, ey + ez + 1, col, &da);
+        Layer->fillrect (sx + ex, sy - ez, 1, ey + ez + 1, col, &da);
+        Layer->fillrect (sx, sy - ez, ex + 1, 1, col, &da);
+        Layer->fillrect (sx, sy - ez + ey, ex + 1, 1, col, &da);
+        Layer->fillrect (sx, sy, ex + 1, 1, col, &da);
+        Layer->fillrect (sx, sy + ey, ex + 1, 1, col, &da);
     }
 }
 
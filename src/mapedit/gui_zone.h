@@ -40,6 +40,11 @@ public:
      * Create the zone view.
      */
     GuiZone (gfx::surface *overlay);
+
+    /**
+     * Cleanup.
+     */
+    ~GuiZone ();
     
     /**
      * Draw zones in the given area
@@ -60,7 +65,7 @@ public:
      * Set the zone being edited, or NULL when editing is done.
      * @param the zone being edited.
      */
-    void set_active_zone (const world::zone * zone) { ActiveZone = zone; }
+    void set_active_zone (const world::zone * zone) { ActiveZone = zone; Dirty = true; }
 
     /**
      * Update zone display
@@ -68,8 +73,16 @@ public:
     void update ();
 
 private:
+    /**
+     * Render all zones in view onto the zone layer, unless it
+     * is still up to date.
+     */
+    void render ();
+
     /// overlay onto which to draw grid
     gfx::surface *Overlay;
+    /// zones in view, rendered for blitting onto the overlay
+    gfx::surface *Layer;
 
     // the currently edited zone
     const world::zone *ActiveZone;
@@ -78,6 +91,18 @@ private:
     bool Visible;
     /// whether re-rendering is required
     bool Changed;
+    /// whether the zone layer needs to be rendered again
+    bool Dirty;
+
+    /**
+     * @name View the zone layer has been rendered for
+     */
+    //@{
+    const world::area *Map;
+    s_int32 MapX, MapY, MapZ;
+    u_int16 Scale;
+    u_int32 ZoneRevision;
+    //@}
 };
 
 #endif
@@ -241,6 +241,9 @@ void GuiZoneDialog::updateValues (const char & c)
         }
     }
 
+    // zone needs to be re-indexed
+    Map->zoneChanged ();
+
     GtkAdjustment *adj = gtk_spin_button_get_adjustment (GTK_SPIN_BUTTON (widget));
     gtk_adjustment_set_upper (adj, upper - min);
 
@@ -263,6 +266,7 @@ void GuiZoneDialog::revertChanges()
 
     Zone->min().set(OldZone->min().x(), OldZone->min().y(), OldZone->min().z());
     Zone->max().set(OldZone->max().x(), OldZone->max().y(), OldZone->max().z());
+    Map->zoneChanged ();
 
     // update map view
     GuiMapedit::window->view()->getZones()->set_active_zone(NULL);
@@ -30,6 +30,7 @@
 #include "gui_mapview.h"
 #include "gui_zone_list.h"
 #include "gui_zone_dialog.h"
+#include "map_command.h"
 
 enum
 {
@@ -196,6 +197,7 @@ static void selected_event (GtkTreeSelection *selection, gpointer user_data)
 // ctor
 GuiZoneList::GuiZoneList ()
 {
+    Map = NULL;
     Panel = gtk_vbox_new (FALSE, 0);
     
     // the tree view
@@ -257,6 +259,9 @@ void GuiZoneList::addZone()
         GuiZoneDialog dlg (z, Map);
         if (dlg.run())
         {
+            // allow undoing this
+            Map->journal()->add (new MapZoneCommand (MapZoneCommand::ADD_ZONE, z));
+
             // add zone to list
             GtkTreeIter iter;
             GtkListStore *model = GTK_LIST_STORE (gtk_tree_view_get_model (TreeView));
@@ -295,8 +300,8 @@ void GuiZoneList::removeZone()
         // get object at selected row
         world::zone *z = (world::zone*) zone_list_get_object (ZONE_LIST (model), &iter);
         
-        // remove zone from map
-        Map->remove_zone (z);
+        // remove zone from map, keeping it around for undo
+        Map->journal()->execute (new MapZoneCommand (MapZoneCommand::REMOVE_ZONE, z));
         
         // remove zone from list
         gtk_list_store_remove  (GTK_LIST_STORE(model), &iter);
@@ -304,9 +309,6 @@ void GuiZoneList::removeZone()
         // update map view
         GuiMapedit::window->view()->updateOverlay();
         GuiMapedit::window->view()->draw();
-
-        // cleanup
-        delete z;
     }        
 }
 
@@ -323,9 +325,19 @@ void GuiZoneList::editZone()
         // get object at selected row
         world::zone *z = (world::zone*) zone_list_get_object (ZONE_LIST (model), &iter);
         
+        // remember zone before it is changed
+        MapZoneCommand *cmd = new MapZoneCommand (MapZoneCommand::UPDATE_ZONE, z);
+
         // bring up properties dialog
         GuiZoneDialog dlg (z, Map);
-        dlg.run ();
+        if (dlg.run () && cmd->set_result ())
+        {
+            // allow undoing the changes
+            Map->journal()->add (cmd);
+            return;
+        }
+
+        delete cmd;
     }    
 }
 
@@ -335,6 +347,14 @@ void GuiZoneList::setMap (MapData * map)
     if (Map == map) return;
     
     Map = map;
+    refresh ();
+}
+
+// rebuild list from zones of the map
+void GuiZoneList::refresh ()
+{
+    if (Map == NULL) return;
+
     GtkTreeIter iter;
     
     // get model
@@ -347,7 +367,7 @@ void GuiZoneList::setMap (MapData * map)
     gtk_list_store_clear (model);
     
     // fill model
-    for (MapData::zone_iter z = map->firstZone(); z != map->lastZone(); z++)
+    for (MapData::zone_iter z = Map->firstZone(); z != Map->lastZone(); z++)
     {
         // get new row
         gtk_list_store_append (model, &iter);
@@ -89,6 +89,12 @@ public:
      * @param map the map whose zones to display.
      */
     void setMap (MapData * map);
+
+    /**
+     * Rebuild the list after zones have been added or removed
+     * by undoing or redoing an edit.
+     */
+    void refresh ();
     
     /**
      * Get the zone view widget.
@@ -33,6 +33,7 @@
 #include <adonthell/python/python.h>
 #include <adonthell/rpg/character.h>
 
+#include "map_checker.h"
 #include "map_cmdline.h"
 #include "gui_mapedit.h"
 #include "mdl_connector.h"
@@ -41,17 +42,30 @@
 
 int main (int argc, char *argv[])
 {
-    // Init GTK+
-    gtk_init (&argc, &argv);
+    // maps are saved in a background thread
+    if (!g_thread_supported ()) g_thread_init (NULL);
+
+    // Init GTK+, but checking maps does not require a display
+    bool has_display = gtk_init_check (&argc, &argv);
     
     // parse command line
     if (!MapCmdline::parse (argc, argv))
         return 1;
 
+    if (!has_display && !MapCmdline::check)
+    {
+        fprintf (stderr, "*** cannot open display\n");
+        return 1;
+    }
+
     // most likely opened by double clicking a model
     if (argc == 2 && MapCmdline::sources == 1)
        if (!MapCmdline::setProjectFromPath(argv[MapCmdline::sources]))
             return 1;
+
+    // try to detect the project of maps to check, if not given
+    if (MapCmdline::check && MapCmdline::project.empty () && MapCmdline::sources < argc)
+        MapCmdline::setProjectFromPath(argv[MapCmdline::sources]);
   
     // init game directory
     base::init (MapCmdline::project, MapCmdline::datadir);
@@ -80,6 +94,10 @@ int main (int argc, char *argv[])
     // load connector templates
     MdlConnectorManager::load(base::Paths().user_data_dir());
 
+    // check maps without opening the editor
+    if (MapCmdline::check)
+        return MapChecker::run (argv + MapCmdline::sources, argc - MapCmdline::sources, MapCmdline::jobs);
+
     // Create the User Interface
     GuiMapedit mapedit;
         
@@ -0,0 +1,613 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_binary.cc
+ *
+ * @author Kai Sterker
+ * @brief Compact binary encoding of maps.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <adonthell/world/object.h>
+#include <adonthell/world/character.h>
+
+#include "map_binary.h"
+#include "map_data.h"
+
+/// identifies a binary map
+#define BINARY_MAP_MAGIC "ABMP"
+/// increase whenever the file layout changes
+#define BINARY_MAP_VERSION 2
+
+/**
+ * Start of a binary map. It is followed by the string offsets, the
+ * string data (padded to a multiple of 4 bytes), the entities, the
+ * zones, the cells and finally the placements.
+ */
+struct map_header
+{
+    /// must be BINARY_MAP_MAGIC
+    char Magic[4];
+    /// must be BINARY_MAP_VERSION
+    u_int32 Version;
+    /// number of strings
+    u_int32 NumStrings;
+    /// size of the string data in bytes
+    u_int32 StringSize;
+    /// number of entity records
+    u_int32 NumEntities;
+    /// number of zone records
+    u_int32 NumZones;
+    /// number of cell records
+    u_int32 NumCells;
+    /// number of placement records
+    u_int32 NumPlacements;
+};
+
+/**
+ * An entity on the map. Strings are indices into the string table.
+ */
+struct map_entity_record
+{
+    /// one of A, S or U
+    char EntityType;
+    /// world::placeable_type of the object
+    u_int8 ObjectType;
+    /// unused
+    u_int16 Padding;
+    /// model file of the object
+    u_int32 Model;
+    /// name of shared and unique entities
+    u_int32 Id;
+    /// state of the object
+    u_int32 State;
+    /// hash of the object
+    u_int32 Hash;
+};
+
+/**
+ * A zone on the map.
+ */
+struct map_zone_record
+{
+    /// name of the zone
+    u_int32 Name;
+    /// type of the zone
+    u_int32 Type;
+    /// minimum corner of the zone
+    s_int32 Min[3];
+    /// maximum corner of the zone
+    s_int32 Max[3];
+};
+
+/**
+ * Collects the strings of a map, storing each only once.
+ */
+class map_string_table
+{
+public:
+    u_int32 add (const std::string & str)
+    {
+        std::map<std::string, u_int32>::const_iterator i = Index.find (str);
+        if (i != Index.end()) return i->second;
+
+        u_int32 idx = Offsets.size ();
+        Offsets.push_back (Data.size ());
+        Data.insert (Data.end(), str.c_str(), str.c_str() + str.length() + 1);
+        Index[str] = idx;
+        return idx;
+    }
+
+    /// start of each string in Data
+    std::vector<u_int32> Offsets;
+    /// zero-terminated strings
+    std::vector<char> Data;
+
+private:
+    std::map<std::string, u_int32> Index;
+};
+
+/**
+ * Everything that goes into a binary map.
+ */
+struct map_tables
+{
+    /// model files, entity names, states, hashes and zone names
+    map_string_table Strings;
+    /// entities on the map
+    std::vector<map_entity_record> Entities;
+    /// zones of the map
+    std::vector<map_zone_record> Zones;
+    /// entities placed on the map
+    std::vector<map_placement_record> Placements;
+};
+
+// round up to multiple of 4 bytes
+static u_int32 align (const u_int32 & size)
+{
+    return (size + 3) & ~3u;
+}
+
+// account for a table of the given size
+static bool consume (u_int32 & remaining, const u_int32 & count, const u_int32 & record_size)
+{
+    if (count > remaining / record_size) return false;
+    remaining -= count * record_size;
+    return true;
+}
+
+// group placements by the part of the map they are located in
+bool MapBinary::placement_order (const map_placement_record & a, const map_placement_record & b)
+{
+    s_int32 ay = cell_y (a);
+    s_int32 by = cell_y (b);
+    if (ay != by) return ay < by;
+
+    s_int32 ax = cell_x (a);
+    s_int32 bx = cell_x (b);
+    if (ax != bx) return ax < bx;
+
+    // within a cell, the order only needs to be well defined
+    for (int i = 2; i >= 0; i--)
+    {
+        if (a.Pos[i] != b.Pos[i]) return a.Pos[i] < b.Pos[i];
+    }
+
+    return a.Entity < b.Entity;
+}
+
+// check for binary map
+bool MapBinary::is_binary (const std::string & fname)
+{
+    FILE *file = fopen (fname.c_str (), "rb");
+    if (file == NULL) return false;
+
+    char magic[4];
+    bool result = fread (magic, 4, 1, file) == 1 && memcmp (magic, BINARY_MAP_MAGIC, 4) == 0;
+    fclose (file);
+
+    return result;
+}
+
+// load binary map
+bool MapBinary::load (MapData *map, const std::string & fname)
+{
+    int fd = open (fname.c_str (), O_RDONLY);
+    if (fd == -1)
+    {
+        fprintf (stderr, "*** MapBinary::load: cannot open '%s'\n", fname.c_str());
+        return false;
+    }
+
+    struct stat statbuf;
+    if (fstat (fd, &statbuf) != 0 || statbuf.st_size < (off_t) sizeof (map_header))
+    {
+        fprintf (stderr, "*** MapBinary::load: '%s' is not a binary map\n", fname.c_str());
+        close (fd);
+        return false;
+    }
+
+    u_int32 size = statbuf.st_size;
+    void *data = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close (fd);
+
+    if (data == MAP_FAILED)
+    {
+        fprintf (stderr, "*** MapBinary::load: cannot map '%s' into memory\n", fname.c_str());
+        return false;
+    }
+
+    bool result = read (map, (const char*) data, size);
+    if (!result)
+    {
+        fprintf (stderr, "*** MapBinary::load: errors reading '%s'\n", fname.c_str());
+    }
+
+    // placements are loaded on demand, directly from the file
+    if (!map->regions()->active ())
+    {
+        munmap (data, size);
+    }
+
+    return result;
+}
+
+// create map from records
+bool MapBinary::read (MapData *map, const char *data, const u_int32 & size)
+{
+    const map_header *header = (const map_header*) data;
+    if (memcmp (header->Magic, BINARY_MAP_MAGIC, 4) != 0 || header->Version != BINARY_MAP_VERSION)
+    {
+        fprintf (stderr, "*** MapBinary::read: unsupported format or version\n");
+        return false;
+    }
+
+    // make sure all tables fit into the file
+    u_int32 remaining = size - sizeof (map_header);
+    if (header->NumStrings == 0 || header->StringSize == 0 || header->StringSize > size
+        || !consume (remaining, header->NumStrings, sizeof (u_int32))
+        || !consume (remaining, align (header->StringSize), 1)
+        || !consume (remaining, header->NumEntities, sizeof (map_entity_record))
+        || !consume (remaining, header->NumZones, sizeof (map_zone_record))
+        || !consume (remaining, header->NumCells, sizeof (map_cell_record))
+        || !consume (remaining, header->NumPlacements, sizeof (map_placement_record))
+        || remaining != 0)
+    {
+        fprintf (stderr, "*** MapBinary::read: file is truncated or corrupt\n");
+        return false;
+    }
+
+    const u_int32 *offsets = (const u_int32*) (data + sizeof (map_header));
+    const char *strings = (const char*) (offsets + header->NumStrings);
+    const map_entity_record *entities = (const map_entity_record*) (strings + align (header->StringSize));
+    const map_zone_record *zones = (const map_zone_record*) (entities + header->NumEntities);
+    const map_cell_record *cells = (const map_cell_record*) (zones + header->NumZones);
+    const map_placement_record *placements = (const map_placement_record*) (cells + header->NumCells);
+
+    // cells must only refer to existing placements
+    for (u_int32 i = 0; i < header->NumCells; i++)
+    {
+        if (cells[i].First > header->NumPlacements || cells[i].Count > header->NumPlacements - cells[i].First)
+        {
+            fprintf (stderr, "*** MapBinary::read: cell table is corrupt\n");
+            return false;
+        }
+    }
+
+    // strings are used in place, so they must be terminated
+    if (strings[header->StringSize - 1] != '\0')
+    {
+        fprintf (stderr, "*** MapBinary::read: string table is corrupt\n");
+        return false;
+    }
+    for (u_int32 i = 0; i < header->NumStrings; i++)
+    {
+        if (offsets[i] >= header->StringSize)
+        {
+            fprintf (stderr, "*** MapBinary::read: string table is corrupt\n");
+            return false;
+        }
+    }
+
+    bool result = true;
+    u_int32 num_strings = header->NumStrings;
+    #define STRING(idx) ((idx) < num_strings ? strings + offsets[idx] : "")
+
+    // create entities
+    std::vector<world::entity*> entity_list (header->NumEntities, (world::entity*) NULL);
+    for (u_int32 i = 0; i < header->NumEntities; i++)
+    {
+        const map_entity_record & rec = entities[i];
+        const char *model = STRING(rec.Model);
+        world::placeable *obj = NULL;
+
+        switch (rec.ObjectType)
+        {
+            case world::OBJECT:
+            {
+                obj = new world::object (*map, STRING(rec.Hash));
+                break;
+            }
+            case world::CHARACTER:
+            {
+                obj = new world::character (*map, STRING(rec.Hash));
+                break;
+            }
+            default:
+            {
+                fprintf (stderr, "*** MapBinary::read: unknown object type %i\n", rec.ObjectType);
+                result = false;
+                continue;
+            }
+        }
+
+        if (!obj->load_model (model))
+        {
+            fprintf (stderr, "*** MapBinary::read: cannot load model '%s'\n", model);
+            delete obj;
+            result = false;
+            continue;
+        }
+        obj->set_state (STRING(rec.State));
+
+        world::entity *ety = NULL;
+        switch (rec.EntityType)
+        {
+            case 'A':
+            {
+                ety = new world::entity (obj);
+                break;
+            }
+            case 'U':
+            {
+                ety = new world::named_entity (obj, STRING(rec.Id), true);
+                break;
+            }
+            case 'S':
+            {
+                ety = new world::named_entity (obj, STRING(rec.Id), false);
+                break;
+            }
+            default:
+            {
+                fprintf (stderr, "*** MapBinary::read: unknown entity type '%c'\n", rec.EntityType);
+                delete obj;
+                result = false;
+                continue;
+            }
+        }
+
+        map->add_entity (ety);
+        entity_list[i] = ety;
+    }
+
+    // create zones
+    for (u_int32 i = 0; i < header->NumZones; i++)
+    {
+        const map_zone_record & rec = zones[i];
+        world::vector3<s_int32> min (rec.Min[0], rec.Min[1], rec.Min[2]);
+        world::vector3<s_int32> max (rec.Max[0], rec.Max[1], rec.Max[2]);
+
+        world::zone *zone = new world::zone (rec.Type, STRING(rec.Name), min, max);
+        if (!map->add_zone (zone))
+        {
+            fprintf (stderr, "*** MapBinary::read: duplicate zone '%s'\n", STRING(rec.Name));
+            delete zone;
+            result = false;
+        }
+    }
+
+    #undef STRING
+
+    // entities are placed once the part of the map they are on is viewed
+    map->regions()->attach (data, size, entity_list, cells, header->NumCells, placements);
+
+    return result;
+}
+
+// write binary map
+bool MapBinary::save (MapData *map, const std::string & fname)
+{
+    MapSnapshot *snapshot = MapBinary::snapshot (map);
+    if (snapshot == NULL)
+    {
+        return false;
+    }
+
+    bool result = snapshot->write (fname);
+    delete snapshot;
+
+    return result;
+}
+
+// check for binary map extension
+bool MapBinary::has_extension (const std::string & fname)
+{
+    size_t len = strlen (BINARY_MAP_EXT);
+    return fname.length() > len && fname.compare (fname.length() - len, len, BINARY_MAP_EXT) == 0;
+}
+
+// copy map contents
+MapSnapshot *MapBinary::snapshot (MapData *map)
+{
+    MapSnapshot *snapshot = new MapSnapshot ();
+    map_tables *tables = snapshot->Tables;
+    map_string_table & strings = tables->Strings;
+
+    // the empty string, used for anonymous entities
+    strings.add ("");
+
+    // collect entities
+    std::map<const world::entity*, u_int32> entity_index;
+    for (MapData::entity_iter i = map->firstEntity(); i != map->lastEntity(); i++)
+    {
+        const world::entity *ety = *i;
+        const world::placeable *obj = ety->get_object ();
+
+        // items and schedules have no record in the binary format
+        if (obj->type () != world::OBJECT && obj->type () != world::CHARACTER)
+        {
+            fprintf (stderr, "*** MapBinary::snapshot: cannot save object type %i of '%s'\n", obj->type (), obj->modelfile ().c_str());
+            delete snapshot;
+            return NULL;
+        }
+        if (obj->type () == world::CHARACTER && ((world::character *) obj)->get_schedule ()->get_manager () != NULL)
+        {
+            fprintf (stderr, "*** MapBinary::snapshot: cannot save schedule of '%s'\n", obj->modelfile ().c_str());
+            delete snapshot;
+            return NULL;
+        }
+
+        map_entity_record rec;
+        rec.EntityType = ety->has_name () ? (((const world::named_entity*) ety)->is_unique () ? 'U' : 'S') : 'A';
+        rec.ObjectType = obj->type ();
+        rec.Padding = 0;
+        rec.Model = strings.add (obj->modelfile ());
+        rec.Id = ety->id () != NULL ? strings.add (*ety->id ()) : 0;
+        rec.State = strings.add (obj->state ());
+        rec.Hash = strings.add (obj->hash ());
+
+        entity_index[ety] = tables->Entities.size ();
+        tables->Entities.push_back (rec);
+    }
+
+    // collect zones
+    for (MapData::zone_iter i = map->firstZone(); i != map->lastZone(); i++)
+    {
+        world::zone *zone = *i;
+
+        map_zone_record rec;
+        rec.Name = strings.add (zone->name ());
+        rec.Type = zone->type ();
+        rec.Min[0] = zone->min().x();
+        rec.Min[1] = zone->min().y();
+        rec.Min[2] = zone->min().z();
+        rec.Max[0] = zone->max().x();
+        rec.Max[1] = zone->max().y();
+        rec.Max[2] = zone->max().z();
+
+        tables->Zones.push_back (rec);
+    }
+
+    // collect placements
+    std::list<world::chunk_info*> objects = map->objects_in_bbox (map->min(), map->max());
+    for (std::list<world::chunk_info*>::const_iterator i = objects.begin(); i != objects.end(); i++)
+    {
+        // neither are actions
+        if ((*i)->has_action ())
+        {
+            fprintf (stderr, "*** MapBinary::snapshot: cannot save action of object at [%i, %i, %i]\n",
+                (*i)->Min.x(), (*i)->Min.y(), (*i)->Min.z());
+            delete snapshot;
+            return NULL;
+        }
+
+        std::map<const world::entity*, u_int32>::const_iterator idx = entity_index.find ((*i)->get_entity ());
+        if (idx == entity_index.end())
+        {
+            fprintf (stderr, "*** MapBinary::snapshot: skipping object not in the map's entity list\n");
+            continue;
+        }
+
+        map_placement_record rec;
+        rec.Entity = idx->second;
+        rec.Pos[0] = (*i)->Min.x();
+        rec.Pos[1] = (*i)->Min.y();
+        rec.Pos[2] = (*i)->Min.z();
+
+        tables->Placements.push_back (rec);
+    }
+
+    // add placements in parts of the map that are not loaded
+    std::vector<map_placement_record> unloaded;
+    map->regions()->get_unloaded (unloaded);
+    for (std::vector<map_placement_record>::iterator i = unloaded.begin(); i != unloaded.end(); i++)
+    {
+        std::map<const world::entity*, u_int32>::const_iterator idx = entity_index.find (map->regions()->entity (i->Entity));
+        if (idx == entity_index.end())
+        {
+            fprintf (stderr, "*** MapBinary::snapshot: skipping object not in the map's entity list\n");
+            continue;
+        }
+
+        i->Entity = idx->second;
+        tables->Placements.push_back (*i);
+    }
+
+    return snapshot;
+}
+
+// ctor
+MapSnapshot::MapSnapshot ()
+{
+    Tables = new map_tables ();
+}
+
+// dtor
+MapSnapshot::~MapSnapshot ()
+{
+    delete Tables;
+}
+
+// write a table to disk
+template<class T> static bool write_table (FILE *file, const std::vector<T> & table)
+{
+    return table.empty () || fwrite (&table[0], sizeof (T), table.size (), file) == table.size ();
+}
+
+// write copy of map to disk
+bool MapSnapshot::write (const std::string & fname)
+{
+    map_string_table & strings = Tables->Strings;
+
+    // group placements by cell
+    std::vector<map_placement_record> & placements = Tables->Placements;
+    std::sort (placements.begin(), placements.end(), MapBinary::placement_order);
+
+    std::vector<map_cell_record> cells;
+    for (u_int32 i = 0; i < placements.size(); i++)
+    {
+        s_int32 x = MapBinary::cell_x (placements[i]);
+        s_int32 y = MapBinary::cell_y (placements[i]);
+        if (cells.empty () || cells.back().X != x || cells.back().Y != y)
+        {
+            map_cell_record cell;
+            cell.X = x;
+            cell.Y = y;
+            cell.First = i;
+            cell.Count = 0;
+            cells.push_back (cell);
+        }
+        cells.back().Count++;
+    }
+
+    map_header header;
+    memcpy (header.Magic, BINARY_MAP_MAGIC, 4);
+    header.Version = BINARY_MAP_VERSION;
+    header.NumStrings = strings.Offsets.size ();
+    header.StringSize = strings.Data.size ();
+    header.NumEntities = Tables->Entities.size ();
+    header.NumZones = Tables->Zones.size ();
+    header.NumCells = cells.size ();
+    header.NumPlacements = Tables->Placements.size ();
+
+    // pad string data, so the records that follow are aligned
+    strings.Data.resize (align (strings.Data.size ()), '\0');
+
+    // write to temporary file, so we never leave a broken map behind
+    std::string tmpname = fname + ".tmp";
+    FILE *file = fopen (tmpname.c_str (), "wb");
+    if (file == NULL)
+    {
+        fprintf (stderr, "*** MapSnapshot::write: cannot write '%s'\n", tmpname.c_str());
+        return false;
+    }
+
+    // one section after the other, straight from the snapshot
+    bool result = fwrite (&header, sizeof (header), 1, file) == 1;
+    result = result && write_table (file, strings.Offsets);
+    result = result && write_table (file, strings.Data);
+    result = result && write_table (file, Tables->Entities);
+    result = result && write_table (file, Tables->Zones);
+    result = result && write_table (file, cells);
+    result = result && write_table (file, Tables->Placements);
+
+    // make sure the data is on disk before replacing the old map
+    result = result && fflush (file) == 0 && fsync (fileno (file)) == 0;
+    result &= fclose (file) == 0;
+
+    if (!result || rename (tmpname.c_str (), fname.c_str ()) != 0)
+    {
+        fprintf (stderr, "*** MapSnapshot::write: error writing '%s'\n", fname.c_str());
+        remove (tmpname.c_str ());
+        return false;
+    }
+
+    return true;
+}
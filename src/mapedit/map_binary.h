@@ -0,0 +1,207 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_binary.h
+ *
+ * @author Kai Sterker
+ * @brief Compact binary encoding of maps.
+ */
+
+#ifndef MAP_BINARY_H
+#define MAP_BINARY_H
+
+#include <string>
+
+#include <adonthell/base/types.h>
+
+class MapData;
+struct map_tables;
+
+/// extension of maps stored in binary format
+#define BINARY_MAP_EXT ".bmap"
+/// placements are grouped into cells of 2^BINARY_MAP_CELL_SHIFT pixels
+#define BINARY_MAP_CELL_SHIFT 9
+
+/**
+ * An entity placed on the map.
+ */
+struct map_placement_record
+{
+    /// index of the entity record
+    u_int32 Entity;
+    /// position of the entity
+    s_int32 Pos[3];
+};
+
+/**
+ * A square part of the map, as seen in the map view. Its placements
+ * are stored next to each other, so they can be loaded on demand.
+ */
+struct map_cell_record
+{
+    /// column of the cell
+    s_int32 X;
+    /// row of the cell
+    s_int32 Y;
+    /// index of the first placement in the cell
+    u_int32 First;
+    /// number of placements in the cell
+    u_int32 Count;
+};
+
+/**
+ * A copy of the contents of a map, in the form they are written
+ * to disk. Taking it is cheap compared to writing the file, and
+ * the copy can be written from a background thread while the map
+ * is edited further.
+ */
+class MapSnapshot
+{
+public:
+    /**
+     * Cleanup.
+     */
+    ~MapSnapshot ();
+
+    /**
+     * Write the snapshot as binary map. The data goes to a temporary
+     * file first, which replaces the given file only once complete.
+     * Does not access the map, so it is safe to call from any thread.
+     * @param fname full path of the binary map.
+     * @return true on success, false otherwise.
+     */
+    bool write (const std::string & fname);
+
+private:
+    friend class MapBinary;
+
+    /**
+     * Create empty snapshot.
+     */
+    MapSnapshot ();
+
+    /// the records to write
+    map_tables *Tables;
+};
+
+/**
+ * Reads and writes maps in a compact binary format that is much
+ * faster to open than XML. All strings (model files, entity names,
+ * states, zone names) are kept in a single table, and everything
+ * else are fixed-size records referring to it. Placements of
+ * entities are sorted by the region of the map they fall into,
+ * so that neighbouring objects get added to the map together.
+ *
+ * Loading maps the file into memory and creates the entities
+ * straight from the records. Placements are left in the file until
+ * the part of the map they are on is displayed, see MapRegions. XML remains the format for maps under
+ * version control, as it can be compared and merged.
+ *
+ * Records are written in native byte order and the format carries
+ * a version number, so files from a different machine or an older
+ * mapedit are rejected instead of being misread.
+ */
+class MapBinary
+{
+public:
+    /**
+     * Check whether the given file is a binary map.
+     * @param fname full path of the map.
+     * @return true if that is the case, false otherwise.
+     */
+    static bool is_binary (const std::string & fname);
+
+    /**
+     * Add the contents of the given binary map to the given map.
+     * @param map an empty map.
+     * @param fname full path of the binary map.
+     * @return true on success, false otherwise.
+     */
+    static bool load (MapData *map, const std::string & fname);
+
+    /**
+     * Write the given map in binary format.
+     * @param map the map to save.
+     * @param fname full path of the binary map.
+     * @return true on success, false otherwise.
+     */
+    static bool save (MapData *map, const std::string & fname);
+
+    /**
+     * Copy the contents of the given map, to be written later. Maps
+     * containing items, character schedules or actions attached to
+     * placed objects cannot be stored in binary format.
+     * @param map the map to copy.
+     * @return the copy of the map, or NULL if it cannot be stored.
+     */
+    static MapSnapshot *snapshot (MapData *map);
+
+    /**
+     * Check whether the given file name has the extension of
+     * binary maps.
+     * @param fname full path of the map.
+     * @return true if that is the case, false otherwise.
+     */
+    static bool has_extension (const std::string & fname);
+
+    /**
+     * Get the column of the cell containing the given placement.
+     * @param rec a placement.
+     * @return column of the cell.
+     */
+    static s_int32 cell_x (const map_placement_record & rec)
+    {
+        return rec.Pos[0] >> BINARY_MAP_CELL_SHIFT;
+    }
+
+    /**
+     * Get the row of the cell containing the given placement. Cells
+     * are laid out as seen in the map view, so objects higher up
+     * belong to rows further up.
+     * @param rec a placement.
+     * @return row of the cell.
+     */
+    static s_int32 cell_y (const map_placement_record & rec)
+    {
+        return (rec.Pos[1] - rec.Pos[2]) >> BINARY_MAP_CELL_SHIFT;
+    }
+
+    /**
+     * Order placements by cell, rows first.
+     * @param a first placement.
+     * @param b second placement.
+     * @return true if a comes before b, false otherwise.
+     */
+    static bool placement_order (const map_placement_record & a, const map_placement_record & b);
+
+private:
+    /**
+     * Create entities and zones from a binary map that has been
+     * read into memory and pass the placements on to the map's
+     * regions.
+     * @param map an empty map.
+     * @param data contents of the binary map.
+     * @param size size of the binary map in bytes.
+     * @return true on success, false otherwise.
+     */
+    static bool read (MapData *map, const char *data, const u_int32 & size);
+};
+
+#endif // MAP_BINARY_H
@@ -0,0 +1,365 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_checker.cc
+ *
+ * @author Kai Sterker
+ * @brief Checking maps from the command line.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <vector>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <adonthell/base/base.h>
+
+#include "map_checker.h"
+#include "map_data.h"
+#include "map_shape_tree.h"
+
+/// number of cells with most placements to list
+#define CHECK_BUSIEST_CELLS 10
+
+/**
+ * Format a position on the map.
+ * @param pos the position.
+ * @return the position as text.
+ */
+static std::string position (const world::vector3<s_int32> & pos)
+{
+    std::ostringstream out;
+    out << "(" << pos.x() << ", " << pos.y() << ", " << pos.z() << ")";
+    return out.str();
+}
+
+// check all maps
+int MapChecker::run (char *files[], const int & count, const int & jobs)
+{
+    bool result = true;
+
+    if (count <= 0)
+    {
+        fprintf (stderr, "*** MapChecker::run: no maps to check\n");
+        return 1;
+    }
+
+    // check in this process
+    if (jobs <= 1)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            std::string report;
+            if (check (files[i], report) > 0) result = false;
+            fputs (report.c_str(), stdout);
+        }
+
+        return result ? 0 : 1;
+    }
+
+    std::deque<job> running;
+    int next = 0;
+
+    while (next < count || !running.empty())
+    {
+        // keep the given number of maps in progress
+        while (next < count && (int) running.size() < jobs)
+        {
+            job j;
+            j.Filename = files[next++];
+            j.Pid = spawn (j.Filename, j.Fd);
+            if (j.Pid == -1)
+            {
+                fprintf (stderr, "*** MapChecker::run: cannot check '%s'\n", j.Filename.c_str());
+                result = false;
+                continue;
+            }
+
+            running.push_back (j);
+        }
+
+        // print reports in the order maps were given
+        if (!running.empty())
+        {
+            if (!collect (running.front())) result = false;
+            running.pop_front ();
+        }
+    }
+
+    return result ? 0 : 1;
+}
+
+// check a single map
+int MapChecker::check (const std::string & fname, std::string & report)
+{
+    std::ostringstream out;
+    int errors = 0;
+
+    out << fname << ":" << std::endl;
+
+    MapData map;
+    if (!map.loadFile (fname))
+    {
+        out << "  error: cannot load map completely" << std::endl;
+        errors++;
+    }
+
+    // placements of binary maps are only loaded on demand
+    map.regions()->load_all ();
+
+    u_int32 num_entities = 0;
+    u_int32 num_zones = 0;
+    std::map<const world::entity*, u_int32> per_entity;
+    std::map<s_int32, u_int32> per_level;
+    std::map<std::pair<s_int32, s_int32>, u_int32> per_cell;
+
+    for (MapData::entity_iter e = map.firstEntity(); e != map.lastEntity(); e++)
+    {
+        per_entity[*e] = 0;
+        num_entities++;
+    }
+
+    for (MapData::zone_iter z = map.firstZone(); z != map.lastZone(); z++)
+    {
+        num_zones++;
+    }
+
+    // count placements
+    std::list<world::chunk_info*> objects = map.objects_in_bbox (map.min(), map.max());
+    for (std::list<world::chunk_info*>::const_iterator i = objects.begin(); i != objects.end(); i++)
+    {
+        map_placement_record rec;
+        rec.Pos[0] = (*i)->Min.x();
+        rec.Pos[1] = (*i)->Min.y();
+        rec.Pos[2] = (*i)->Min.z();
+
+        per_entity[(*i)->get_entity()]++;
+        per_level[rec.Pos[2]]++;
+        per_cell[std::make_pair (MapBinary::cell_x (rec), MapBinary::cell_y (rec))]++;
+    }
+
+    out << "  " << objects.size() << " placements of " << num_entities << " entities, "
+        << num_zones << " zones" << std::endl;
+
+    // placements per entity, most used first
+    std::vector<std::pair<u_int32, std::string> > entities;
+    for (std::map<const world::entity*, u_int32>::const_iterator i = per_entity.begin(); i != per_entity.end(); i++)
+    {
+        entities.push_back (std::make_pair (i->second, name_of (i->first)));
+    }
+    std::sort (entities.begin(), entities.end(), std::greater<std::pair<u_int32, std::string> >());
+
+    out << "  placements per entity:" << std::endl;
+    for (std::vector<std::pair<u_int32, std::string> >::const_iterator i = entities.begin(); i != entities.end(); i++)
+    {
+        out << "    " << i->first << "\t" << i->second << std::endl;
+    }
+
+    out << "  placements per level:" << std::endl;
+    for (std::map<s_int32, u_int32>::const_iterator i = per_level.begin(); i != per_level.end(); i++)
+    {
+        out << "    z = " << i->first << "\t" << i->second << std::endl;
+    }
+
+    // only list the cells with most placements
+    std::vector<std::pair<u_int32, std::pair<s_int32, s_int32> > > cells;
+    for (std::map<std::pair<s_int32, s_int32>, u_int32>::const_iterator i = per_cell.begin(); i != per_cell.end(); i++)
+    {
+        cells.push_back (std::make_pair (i->second, i->first));
+    }
+    std::sort (cells.begin(), cells.end(), std::greater<std::pair<u_int32, std::pair<s_int32, s_int32> > >());
+
+    out << "  placements per cell of " << (1 << BINARY_MAP_CELL_SHIFT) << " pixels: " << cells.size() << " cells";
+    if (!cells.empty())
+    {
+        out << ", " << (float) objects.size() / cells.size() << " on average";
+    }
+    out << std::endl;
+    for (u_int32 i = 0; i < cells.size() && i < CHECK_BUSIEST_CELLS; i++)
+    {
+        out << "    [" << cells[i].second.first << ", " << cells[i].second.second << "]\t" << cells[i].first << std::endl;
+    }
+
+    // entities never placed, missing models and ids used twice
+    std::map<std::string, u_int32> ids;
+    for (std::map<const world::entity*, u_int32>::const_iterator i = per_entity.begin(); i != per_entity.end(); i++)
+    {
+        if (i->second == 0)
+        {
+            out << "  error: entity '" << name_of (i->first) << "' is not placed on the map" << std::endl;
+            errors++;
+        }
+
+        std::string model = i->first->get_object()->modelfile();
+        if (!base::Paths().find_in_path (model, false))
+        {
+            out << "  error: model '" << model << "' not found" << std::endl;
+            errors++;
+        }
+
+        if (i->first->has_name())
+        {
+            ids[name_of (i->first)]++;
+        }
+    }
+
+    for (std::map<std::string, u_int32>::const_iterator i = ids.begin(); i != ids.end(); i++)
+    {
+        if (i->second > 1)
+        {
+            out << "  error: id '" << i->first << "' used by " << i->second << " entities" << std::endl;
+            errors++;
+        }
+    }
+
+    // solid objects overlapping each other
+    std::map<const world::placeable*, MapShapeTree> trees;
+    for (std::list<world::chunk_info*>::const_iterator i = objects.begin(); i != objects.end(); i++)
+    {
+        const world::placeable *obj = (*i)->get_object();
+        MapShapeTree & tree = trees[obj];
+        if (!tree.is_current (obj)) tree.build (obj);
+
+        std::list<world::chunk_info*> others = map.objects_in_bbox ((*i)->Min, (*i)->Max);
+        for (std::list<world::chunk_info*>::const_iterator j = others.begin(); j != others.end(); j++)
+        {
+            // each pair is found twice, only look at it once
+            if (!std::less<world::chunk_info*>() (*i, *j)) continue;
+
+            const world::placeable *other = (*j)->get_object();
+            for (world::placeable::iterator model = other->begin(); model != other->end(); model++)
+            {
+                const world::placeable_shape *shape = (*model)->current_shape ();
+                if (shape != NULL && shape->is_solid() && tree.intersects (shape, (*i)->center_min() - (*j)->center_min()))
+                {
+                    out << "  error: '" << name_of ((*i)->get_entity()) << "' at " << position ((*i)->Min)
+                        << " overlaps '" << name_of ((*j)->get_entity()) << "' at " << position ((*j)->Min) << std::endl;
+                    errors++;
+                    break;
+                }
+            }
+        }
+    }
+
+    out << "  " << errors << " errors" << std::endl;
+
+    report = out.str();
+    return errors;
+}
+
+// check map in child process
+int MapChecker::spawn (const std::string & fname, int & fd)
+{
+    int fds[2];
+    if (pipe (fds) == -1) return -1;
+
+    // do not let the child print what is still buffered
+    fflush (stdout);
+    fflush (stderr);
+
+    pid_t pid = fork ();
+    if (pid == -1)
+    {
+        close (fds[0]);
+        close (fds[1]);
+        return -1;
+    }
+
+    if (pid == 0)
+    {
+        close (fds[0]);
+
+        std::string report;
+        int errors = check (fname, report);
+
+        const char *data = report.data();
+        size_t size = report.size();
+        while (size > 0)
+        {
+            ssize_t written = write (fds[1], data, size);
+            if (written == -1)
+            {
+                if (errno == EINTR) continue;
+                break;
+            }
+
+            data += written;
+            size -= written;
+        }
+
+        // the engine was set up by the parent, leave cleanup to it
+        close (fds[1]);
+        _exit (errors > 0 ? 1 : 0);
+    }
+
+    close (fds[1]);
+    fd = fds[0];
+    return pid;
+}
+
+// print report of child process
+bool MapChecker::collect (const job & j)
+{
+    char buffer[4096];
+    ssize_t size;
+
+    while ((size = read (j.Fd, buffer, sizeof (buffer))) != 0)
+    {
+        if (size == -1)
+        {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        fwrite (buffer, 1, size, stdout);
+    }
+    close (j.Fd);
+
+    int status;
+    while (waitpid (j.Pid, &status, 0) == -1)
+    {
+        if (errno != EINTR) return false;
+    }
+
+    if (!WIFEXITED (status))
+    {
+        fprintf (stderr, "*** MapChecker::collect: checking '%s' failed\n", j.Filename.c_str());
+        return false;
+    }
+
+    return WEXITSTATUS (status) == 0;
+}
+
+// readable name of entity
+std::string MapChecker::name_of (const world::entity *ety)
+{
+    if (ety->has_name())
+    {
+        return *((const world::named_entity*) ety)->id();
+    }
+
+    return ety->get_object()->modelfile();
+}
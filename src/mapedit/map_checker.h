@@ -0,0 +1,103 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_checker.h
+ *
+ * @author Kai Sterker
+ * @brief Checking maps from the command line.
+ */
+
+#ifndef MAP_CHECKER_H
+#define MAP_CHECKER_H
+
+#include <string>
+
+#include <adonthell/world/entity.h>
+
+/**
+ * Loads maps without opening the editor and reports what is on them:
+ * placements per entity, per level and per cell of the binary format.
+ * Entities never placed, models that cannot be found, ids used more
+ * than once and solid objects overlapping each other are reported as
+ * errors, so that maps can be checked as part of a build.
+ *
+ * Each map is checked in a process of its own, forked once the engine
+ * has been initialized. Several maps can thus be checked at the same
+ * time, without the engine having to be thread-safe. Reports are
+ * printed in the order the maps were given.
+ */
+class MapChecker
+{
+public:
+    /**
+     * Check the given maps and print a report for each.
+     * @param files full paths of the maps to check.
+     * @param count number of maps.
+     * @param jobs number of maps to check at the same time.
+     * @return 0 if all maps are fine, 1 otherwise.
+     */
+    static int run (char *files[], const int & count, const int & jobs);
+
+private:
+    /**
+     * Load and check a single map.
+     * @param fname full path of the map.
+     * @param report receives the report.
+     * @return number of errors found.
+     */
+    static int check (const std::string & fname, std::string & report);
+
+    /**
+     * Check a map in a child process.
+     * @param fname full path of the map.
+     * @param fd receives the end of the pipe the report is written to.
+     * @return id of the child or -1 on error.
+     */
+    static int spawn (const std::string & fname, int & fd);
+
+    /**
+     * A map being checked in a child process.
+     */
+    struct job
+    {
+        /// full path of the map
+        std::string Filename;
+        /// id of the child
+        int Pid;
+        /// the pipe the report is written to
+        int Fd;
+    };
+
+    /**
+     * Print the report of a child process and wait for it to exit.
+     * @param j the map being checked.
+     * @return true if the map is fine, false otherwise.
+     */
+    static bool collect (const job & j);
+
+    /**
+     * Get a readable name of the given entity.
+     * @param ety an entity of the map.
+     * @return the entity's id or model file.
+     */
+    static std::string name_of (const world::entity *ety);
+};
+
+#endif // MAP_CHECKER_H
@@ -27,6 +27,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <iostream> 
+#include <cstdlib>
 #include <dirent.h>
 #include <unistd.h>
 
@@ -44,6 +45,15 @@ std::string MapCmdline::project = "";
 // the default project
 std::string MapCmdline::modeldir = "models";
 
+// memory for objects on the map, in MB
+int MapCmdline::budget = 256;
+
+// whether to check maps instead of editing
+bool MapCmdline::check = false;
+
+// number of maps to check in parallel
+int MapCmdline::jobs = 1;
+
 // index of the first dialgoue source in argv[]
 int MapCmdline::sources;
 
@@ -53,10 +63,16 @@ bool MapCmdline::parse (int argc, char* argv[])
     int c;
     
     // Check for options
-    while ((c = getopt (argc, argv, "dhvg:p:m:")) != -1)
+    while ((c = getopt (argc, argv, "cdhvb:g:j:p:m:")) != -1)
     {
         switch (c)
         {
+            case 'c':
+            {
+                check = true;
+                break;
+            }
+
             case 'd':
             {
                 std::cout << datadir << std::endl;
@@ -95,6 +111,30 @@ bool MapCmdline::parse (int argc, char* argv[])
                 break;
             }
             
+            case 'b':
+            {
+                budget = atoi (optarg);
+                if (budget <= 0)
+                {
+                    std::cerr << "Invalid memory budget " << optarg << "!" << std::endl;
+                    return false;
+                }
+
+                break;
+            }
+
+            case 'j':
+            {
+                jobs = atoi (optarg);
+                if (jobs <= 0)
+                {
+                    std::cerr << "Invalid number of jobs " << optarg << "!" << std::endl;
+                    return false;
+                }
+
+                break;
+            }
+
             case 'm':
             {
                 modeldir = optarg;
@@ -158,7 +198,7 @@ bool MapCmdline::setProjectFromPath (char *file)
 // prints the help message
 void MapCmdline::help (const std::string &program)
 {
-    std::cout << "Usage: " << program << " [OPTIONS] [MAPFILE]" << std::endl;
+    std::cout << "Usage: " << program << " [OPTIONS] [MAPFILE ...]" << std::endl;
     std::cout << std::endl;
     std::cout << "Where [OPTIONS] can be:\n";
     std::cout << "-h         print this help message and exit" << std::endl; 
@@ -167,4 +207,7 @@ void MapCmdline::help (const std::string &program)
     std::cout << "-g path    specify path to custom projects directory (default is builtin)" << std::endl;
     std::cout << "-p project specify project inside projects directory" << std::endl;
     std::cout << "-m dir     specify directory to load models from (default is models)" << std::endl;
+    std::cout << "-b mb      memory for objects of large binary maps (default is 256)" << std::endl;
+    std::cout << "-c         check all MAPFILEs, print statistics and exit" << std::endl;
+    std::cout << "-j n       number of maps to check at the same time (default is 1)" << std::endl;
 }
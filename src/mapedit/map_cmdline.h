@@ -71,6 +71,24 @@ public:
      */
     static std::string modeldir;
 
+    /**
+     * Memory in megabytes that objects placed on the map may use.
+     * Parts of large binary maps not in view are unloaded when
+     * this is exceeded. The default is 256.
+     */
+    static int budget;
+
+    /**
+     * Whether to check the given maps and exit, instead of
+     * opening the editor.
+     */
+    static bool check;
+
+    /**
+     * Number of maps to check at the same time. The default is 1.
+     */
+    static int jobs;
+
     /**
      * The index in the argument vector pointing to the first non-option.
      * With a bit of luck, this is a map file to load on startup.
@@ -0,0 +1,475 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_command.cc
+ *
+ * @author Kai Sterker
+ * @brief Reversible edit operations on a map.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <glib.h>
+
+#include "map_command.h"
+#include "map_data.h"
+#include "map_entity.h"
+
+// split line into tab separated fields
+static std::vector<std::string> split_fields (const std::string & line)
+{
+    std::vector<std::string> fields;
+    std::string::size_type start = 0;
+    std::string::size_type end;
+
+    while ((end = line.find ('\t', start)) != line.npos)
+    {
+        fields.push_back (line.substr (start, end - start));
+        start = end + 1;
+    }
+    fields.push_back (line.substr (start));
+
+    return fields;
+}
+
+// convert position to text
+static std::string put_position (const world::vector3<s_int32> & pos)
+{
+    char buf[48];
+    snprintf (buf, sizeof (buf), "%i,%i,%i", pos.x(), pos.y(), pos.z());
+    return buf;
+}
+
+// read position from text
+static bool get_position (const char *str, world::vector3<s_int32> & pos)
+{
+    int x, y, z;
+    if (sscanf (str, "%i,%i,%i", &x, &y, &z) != 3) return false;
+
+    pos = world::vector3<s_int32> (x, y, z);
+    return true;
+}
+
+// compare two positions
+static bool same_position (const world::vector3<s_int32> & a, const world::vector3<s_int32> & b)
+{
+    return a.x() == b.x() && a.y() == b.y() && a.z() == b.z();
+}
+
+// convert list of positions to text
+static std::string put_positions (const std::vector<world::vector3<s_int32> > & positions)
+{
+    std::string result;
+    for (std::vector<world::vector3<s_int32> >::const_iterator i = positions.begin(); i != positions.end(); i++)
+    {
+        if (!result.empty()) result += ' ';
+        result += put_position (*i);
+    }
+    return result;
+}
+
+// read list of positions from text
+static bool get_positions (const std::string & str, std::vector<world::vector3<s_int32> > & positions)
+{
+    world::vector3<s_int32> pos;
+    std::string::size_type start = 0;
+
+    while (start < str.length())
+    {
+        std::string::size_type end = str.find (' ', start);
+        if (end == str.npos) end = str.length();
+
+        if (!get_position (str.substr (start, end - start).c_str(), pos)) return false;
+        positions.push_back (pos);
+
+        start = end + 1;
+    }
+
+    return true;
+}
+
+// read any command from text
+MapCommand *MapCommand::get_state (const std::string & line, MapData *map, MapEntityResolver *resolver)
+{
+    switch (line[0])
+    {
+        case 'E': return MapEntityCommand::get_state (line, resolver);
+        case 'N': return MapRenameCommand::get_state (line, resolver);
+        case 'Z': return MapZoneCommand::get_state (line, map);
+        default: break;
+    }
+
+    fprintf (stderr, "*** MapCommand::get_state: unknown command '%s'\n", line.c_str());
+    return NULL;
+}
+
+// ctor
+MapEntityCommand::MapEntityCommand (MapEntity *entity)
+{
+    Entity = entity;
+    ModelFile = entity->modelFile();
+
+    gchar *type = entity->get_entity_type ();
+    EntityType = type[0];
+    g_free (type);
+
+    gchar *id = entity->get_id ();
+    if (id != NULL)
+    {
+        Id = id;
+        g_free (id);
+    }
+}
+
+// add or remove entity at given locations
+u_int32 MapEntityCommand::apply (const std::vector<world::vector3<s_int32> > & locations, const bool & add, const u_int32 & count)
+{
+    u_int32 i = 0;
+    for (; i < count; i++)
+    {
+        const world::vector3<s_int32> & pos = locations[i];
+        bool result = add ? Entity->addToLocation (world::coordinates (pos.x(), pos.y(), pos.z())) :
+                            Entity->removeFromLocation (pos);
+        if (!result) break;
+    }
+    return i;
+}
+
+// perform edit
+bool MapEntityCommand::execute (MapData *map)
+{
+    u_int32 removed = apply (Removed, false, Removed.size());
+    if (removed == Removed.size())
+    {
+        u_int32 placed = apply (Placed, true, Placed.size());
+        if (placed == Placed.size()) return true;
+
+        // keep map unchanged if edit is only partially possible
+        apply (Placed, false, placed);
+    }
+
+    apply (Removed, true, removed);
+    return false;
+}
+
+// revert edit
+bool MapEntityCommand::undo (MapData *map)
+{
+    u_int32 placed = apply (Placed, false, Placed.size());
+    if (placed == Placed.size())
+    {
+        u_int32 removed = apply (Removed, true, Removed.size());
+        if (removed == Removed.size()) return true;
+
+        apply (Removed, false, removed);
+    }
+
+    apply (Placed, true, placed);
+    return false;
+}
+
+// merge paint strokes and moves
+bool MapEntityCommand::merge (const MapCommand *cmd)
+{
+    const MapEntityCommand *next = dynamic_cast<const MapEntityCommand*> (cmd);
+    if (next == NULL || next->Entity != Entity || !next->Removed.empty())
+    {
+        return false;
+    }
+
+    Placed.insert (Placed.end(), next->Placed.begin(), next->Placed.end());
+    return true;
+}
+
+// memory used by command
+u_int32 MapEntityCommand::size () const
+{
+    return sizeof (*this) + ModelFile.capacity() + Id.capacity() +
+        (Removed.capacity() + Placed.capacity()) * sizeof (world::vector3<s_int32>);
+}
+
+// convert to text
+std::string MapEntityCommand::put_state () const
+{
+    return std::string ("E\t") + ModelFile + "\t" + EntityType + "\t" + Id + "\t" +
+        put_positions (Removed) + "\t" + put_positions (Placed);
+}
+
+// read from text
+MapEntityCommand *MapEntityCommand::get_state (const std::string & line, MapEntityResolver *resolver)
+{
+    std::vector<std::string> fields = split_fields (line);
+    if (fields.size() != 6 || fields[2].length() != 1)
+    {
+        fprintf (stderr, "*** MapEntityCommand::get_state: malformed command '%s'\n", line.c_str());
+        return NULL;
+    }
+
+    MapEntity *entity = resolver->resolveEntity (fields[1], fields[2][0], fields[3]);
+    if (entity == NULL)
+    {
+        fprintf (stderr, "*** MapEntityCommand::get_state: cannot find entity '%s' of '%s'\n", fields[3].c_str(), fields[1].c_str());
+        return NULL;
+    }
+
+    MapEntityCommand *cmd = new MapEntityCommand (entity);
+    if (!get_positions (fields[4], cmd->Removed) || !get_positions (fields[5], cmd->Placed))
+    {
+        fprintf (stderr, "*** MapEntityCommand::get_state: malformed command '%s'\n", line.c_str());
+        delete cmd;
+        return NULL;
+    }
+
+    return cmd;
+}
+
+// ctor
+MapRenameCommand::MapRenameCommand (MapEntity *entity, const std::string & old_id, const std::string & new_id)
+{
+    Entity = entity;
+    ModelFile = entity->modelFile();
+    OldId = old_id;
+    NewId = new_id;
+
+    gchar *type = entity->get_entity_type ();
+    EntityType = type[0];
+    g_free (type);
+}
+
+// perform rename
+bool MapRenameCommand::execute (MapData *map)
+{
+    return Entity->rename (NewId);
+}
+
+// revert rename
+bool MapRenameCommand::undo (MapData *map)
+{
+    return Entity->rename (OldId);
+}
+
+// memory used by command
+u_int32 MapRenameCommand::size () const
+{
+    return sizeof (*this) + ModelFile.capacity() + OldId.capacity() + NewId.capacity();
+}
+
+// convert to text
+std::string MapRenameCommand::put_state () const
+{
+    return std::string ("N\t") + ModelFile + "\t" + EntityType + "\t" + OldId + "\t" + NewId;
+}
+
+// read from text
+MapRenameCommand *MapRenameCommand::get_state (const std::string & line, MapEntityResolver *resolver)
+{
+    std::vector<std::string> fields = split_fields (line);
+    if (fields.size() != 5 || fields[2].length() != 1)
+    {
+        fprintf (stderr, "*** MapRenameCommand::get_state: malformed command '%s'\n", line.c_str());
+        return NULL;
+    }
+
+    // entity is still known by its old name
+    MapEntity *entity = resolver->resolveEntity (fields[1], fields[2][0], fields[3]);
+    if (entity == NULL)
+    {
+        fprintf (stderr, "*** MapRenameCommand::get_state: cannot find entity '%s' of '%s'\n", fields[3].c_str(), fields[1].c_str());
+        return NULL;
+    }
+
+    return new MapRenameCommand (entity, fields[3], fields[4]);
+}
+
+// ctor
+MapZoneCommand::MapZoneCommand (const char & op, world::zone *zone)
+{
+    Op = op;
+    Zone = zone;
+    Owned = false;
+
+    get_zone (Before);
+    After = Before;
+}
+
+// dtor
+MapZoneCommand::~MapZoneCommand ()
+{
+    if (Owned) delete Zone;
+}
+
+// store zone state after update
+bool MapZoneCommand::set_result ()
+{
+    get_zone (After);
+
+    return After.Name != Before.Name || After.Type != Before.Type ||
+        !same_position (After.Min, Before.Min) || !same_position (After.Max, Before.Max);
+}
+
+// get current zone state
+void MapZoneCommand::get_zone (zone_state & state) const
+{
+    state.Name = Zone->name();
+    state.Type = Zone->type();
+    state.Min = Zone->min();
+    state.Max = Zone->max();
+}
+
+// set zone state
+void MapZoneCommand::set_zone (const zone_state & state)
+{
+    Zone->set_name (state.Name);
+    Zone->set_type (state.Type);
+    Zone->min().set (state.Min.x(), state.Min.y(), state.Min.z());
+    Zone->max().set (state.Max.x(), state.Max.y(), state.Max.z());
+}
+
+// add or remove zone
+bool MapZoneCommand::toggle (MapData *map, const bool & add)
+{
+    if (add)
+    {
+        if (!map->add_zone (Zone)) return false;
+    }
+    else
+    {
+        map->remove_zone (Zone);
+    }
+
+    // keep zone alive while it might be added again
+    Owned = !add;
+    return true;
+}
+
+// perform zone edit
+bool MapZoneCommand::execute (MapData *map)
+{
+    switch (Op)
+    {
+        case ADD_ZONE: return toggle (map, true);
+        case REMOVE_ZONE: return toggle (map, false);
+        default: break;
+    }
+
+    set_zone (After);
+    map->zoneChanged ();
+    return true;
+}
+
+// revert zone edit
+bool MapZoneCommand::undo (MapData *map)
+{
+    switch (Op)
+    {
+        case ADD_ZONE: return toggle (map, false);
+        case REMOVE_ZONE: return toggle (map, true);
+        default: break;
+    }
+
+    set_zone (Before);
+    map->zoneChanged ();
+    return true;
+}
+
+// memory used by command
+u_int32 MapZoneCommand::size () const
+{
+    u_int32 result = sizeof (*this) + Before.Name.capacity() + After.Name.capacity();
+    if (Owned) result += sizeof (world::zone) + Zone->name().capacity();
+    return result;
+}
+
+// convert to text
+std::string MapZoneCommand::put_state () const
+{
+    char type[16];
+    std::string result = std::string ("Z\t") + Op;
+
+    const zone_state *states[2] = { &Before, &After };
+    for (int i = 0; i < 2; i++)
+    {
+        snprintf (type, sizeof (type), "%u", states[i]->Type);
+        result += "\t" + states[i]->Name + "\t" + type + "\t" +
+            put_position (states[i]->Min) + "\t" + put_position (states[i]->Max);
+    }
+
+    return result;
+}
+
+// read from text
+MapZoneCommand *MapZoneCommand::get_state (const std::string & line, MapData *map)
+{
+    std::vector<std::string> fields = split_fields (line);
+    if (fields.size() != 10 || fields[1].length() != 1 || strchr ("aru", fields[1][0]) == NULL)
+    {
+        fprintf (stderr, "*** MapZoneCommand::get_state: malformed command '%s'\n", line.c_str());
+        return NULL;
+    }
+
+    zone_state states[2];
+    for (int i = 0; i < 2; i++)
+    {
+        states[i].Name = fields[2 + i*4];
+        states[i].Type = strtoul (fields[3 + i*4].c_str(), NULL, 10);
+        if (!get_position (fields[4 + i*4].c_str(), states[i].Min) ||
+            !get_position (fields[5 + i*4].c_str(), states[i].Max))
+        {
+            fprintf (stderr, "*** MapZoneCommand::get_state: malformed command '%s'\n", line.c_str());
+            return NULL;
+        }
+    }
+
+    world::zone *zone = NULL;
+    char op = fields[1][0];
+
+    if (op == ADD_ZONE)
+    {
+        // zone does not exist yet
+        zone = new world::zone (states[1].Type, states[1].Name, states[1].Min, states[1].Max);
+    }
+    else
+    {
+        // find zone as it was before the edit
+        for (MapData::zone_iter z = map->firstZone(); z != map->lastZone(); z++)
+        {
+            if ((*z)->name() == states[0].Name)
+            {
+                zone = *z;
+                break;
+            }
+        }
+
+        if (zone == NULL)
+        {
+            fprintf (stderr, "*** MapZoneCommand::get_state: cannot find zone '%s'\n", states[0].Name.c_str());
+            return NULL;
+        }
+    }
+
+    MapZoneCommand *cmd = new MapZoneCommand (op, zone);
+    cmd->Before = states[0];
+    cmd->After = states[1];
+    cmd->Owned = op == ADD_ZONE;
+
+    return cmd;
+}
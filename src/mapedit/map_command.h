@@ -0,0 +1,342 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_command.h
+ *
+ * @author Kai Sterker
+ * @brief Reversible edit operations on a map.
+ */
+
+#ifndef MAP_COMMAND_H
+#define MAP_COMMAND_H
+
+#include <string>
+#include <vector>
+
+#include <adonthell/base/types.h>
+#include <adonthell/world/zone.h>
+
+class MapData;
+class MapEntity;
+
+/**
+ * Interface for looking up the entities referenced by commands
+ * that are read back from disk.
+ */
+class MapEntityResolver
+{
+public:
+    /**
+     * Destructor.
+     */
+    virtual ~MapEntityResolver () {}
+
+    /**
+     * Find the map entity for the given model and entity id.
+     * @param model_file model file of the entity.
+     * @param entity_type one of A, S or U.
+     * @param id name of shared or unique entities, empty otherwise.
+     * @return the matching entity or NULL if there is none.
+     */
+    virtual MapEntity *resolveEntity (const std::string & model_file, const char & entity_type, const std::string & id) = 0;
+};
+
+/**
+ * A single edit of the map that can be reverted. Commands are
+ * kept by the MapJournal and written to its sidecar file as a
+ * line of text, so that they can be replayed after a crash.
+ */
+class MapCommand
+{
+public:
+    /**
+     * Destructor.
+     */
+    virtual ~MapCommand () {}
+
+    /**
+     * Apply the edit to the map.
+     * @param map the map to edit.
+     * @return true on success, false otherwise.
+     */
+    virtual bool execute (MapData *map) = 0;
+
+    /**
+     * Revert the edit.
+     * @param map the map to edit.
+     * @return true on success, false otherwise.
+     */
+    virtual bool undo (MapData *map) = 0;
+
+    /**
+     * Try to combine a subsequent edit with this one, so that
+     * both can be reverted in a single step.
+     * @param cmd an edit that already has been applied.
+     * @return true if the edit has been merged, false otherwise.
+     */
+    virtual bool merge (const MapCommand *cmd) { return false; }
+
+    /**
+     * Check whether the command refers to the given entity.
+     * @param entity the entity to check.
+     * @return true if that is the case, false otherwise.
+     */
+    virtual bool references (const MapEntity *entity) const { return false; }
+
+    /**
+     * Get the approximate amount of memory used by the command.
+     * @return size of the command in bytes.
+     */
+    virtual u_int32 size () const = 0;
+
+    /**
+     * Convert the command to a line of text.
+     * @return the command as text, without line break.
+     */
+    virtual std::string put_state () const = 0;
+
+    /**
+     * Create a command from a line of text written by put_state.
+     * @param line the command as text.
+     * @param map the map the command applies to.
+     * @param resolver used to find entities by name.
+     * @return the command or NULL on error.
+     */
+    static MapCommand *get_state (const std::string & line, MapData *map, MapEntityResolver *resolver);
+};
+
+/**
+ * Placing entities on the map and removing them. A move is a removal
+ * followed by placing the same entity somewhere else, and a paint
+ * stroke is an entity placed several times in a row, so that both
+ * get reverted as one.
+ */
+class MapEntityCommand : public MapCommand
+{
+public:
+    /**
+     * Create an edit of the given entity.
+     * @param entity the entity being placed or removed.
+     */
+    MapEntityCommand (MapEntity *entity);
+
+    /**
+     * Remove the entity from the given location.
+     * @param pos location of the entity on the map.
+     */
+    void remove (const world::vector3<s_int32> & pos) { Removed.push_back (pos); }
+
+    /**
+     * Place the entity at the given location.
+     * @param pos location of the entity on the map.
+     */
+    void place (const world::vector3<s_int32> & pos) { Placed.push_back (pos); }
+
+    /**
+     * @name Implementation of MapCommand
+     */
+    //@{
+    bool execute (MapData *map);
+    bool undo (MapData *map);
+    bool merge (const MapCommand *cmd);
+    bool references (const MapEntity *entity) const { return entity == Entity; }
+    u_int32 size () const;
+    std::string put_state () const;
+    //@}
+
+    /**
+     * Create the command from a line of text.
+     * @param line the command as text.
+     * @param resolver used to find the entity.
+     * @return the command or NULL on error.
+     */
+    static MapEntityCommand *get_state (const std::string & line, MapEntityResolver *resolver);
+
+private:
+    /**
+     * Place or remove the entity at the given locations.
+     * @param locations where to add or remove the entity.
+     * @param add true to place entity, false to remove it.
+     * @param count number of locations to process.
+     * @return number of locations processed successfully.
+     */
+    u_int32 apply (const std::vector<world::vector3<s_int32> > & locations, const bool & add, const u_int32 & count);
+
+    /// the entity being edited
+    MapEntity *Entity;
+    /// model of the entity
+    std::string ModelFile;
+    /// one of A, S or U
+    char EntityType;
+    /// name of shared and unique entities
+    std::string Id;
+    /// locations the entity got removed from
+    std::vector<world::vector3<s_int32> > Removed;
+    /// locations the entity got placed at
+    std::vector<world::vector3<s_int32> > Placed;
+};
+
+/**
+ * Renaming a shared or unique entity.
+ */
+class MapRenameCommand : public MapCommand
+{
+public:
+    /**
+     * Create the rename edit.
+     * @param entity the entity being renamed.
+     * @param old_id the current name of the entity.
+     * @param new_id the new name of the entity.
+     */
+    MapRenameCommand (MapEntity *entity, const std::string & old_id, const std::string & new_id);
+
+    /**
+     * @name Implementation of MapCommand
+     */
+    //@{
+    bool execute (MapData *map);
+    bool undo (MapData *map);
+    bool references (const MapEntity *entity) const { return entity == Entity; }
+    u_int32 size () const;
+    std::string put_state () const;
+    //@}
+
+    /**
+     * Create the command from a line of text.
+     * @param line the command as text.
+     * @param resolver used to find the entity.
+     * @return the command or NULL on error.
+     */
+    static MapRenameCommand *get_state (const std::string & line, MapEntityResolver *resolver);
+
+private:
+    /// the entity being renamed
+    MapEntity *Entity;
+    /// model of the entity
+    std::string ModelFile;
+    /// one of S or U
+    char EntityType;
+    /// name before the edit
+    std::string OldId;
+    /// name after the edit
+    std::string NewId;
+};
+
+/**
+ * Adding, removing or changing a zone.
+ */
+class MapZoneCommand : public MapCommand
+{
+public:
+    /** The kind of zone edit. */
+    enum
+    {
+        ADD_ZONE = 'a',
+        REMOVE_ZONE = 'r',
+        UPDATE_ZONE = 'u'
+    };
+
+    /**
+     * Create a zone edit. This remembers the current state of the
+     * zone, so for updates it must be created prior to changing
+     * the zone.
+     * @param op one of ADD_ZONE, REMOVE_ZONE or UPDATE_ZONE.
+     * @param zone the zone being edited.
+     */
+    MapZoneCommand (const char & op, world::zone *zone);
+
+    /**
+     * Delete the zone, if it is no longer part of the map.
+     */
+    ~MapZoneCommand ();
+
+    /**
+     * Remember the current state of the zone as result of the edit.
+     * @return true if the zone has changed, false otherwise.
+     */
+    bool set_result ();
+
+    /**
+     * @name Implementation of MapCommand
+     */
+    //@{
+    bool execute (MapData *map);
+    bool undo (MapData *map);
+    u_int32 size () const;
+    std::string put_state () const;
+    //@}
+
+    /**
+     * Create the command from a line of text.
+     * @param line the command as text.
+     * @param map the map containing the zone.
+     * @return the command or NULL on error.
+     */
+    static MapZoneCommand *get_state (const std::string & line, MapData *map);
+
+private:
+    /**
+     * Everything that can be edited about a zone.
+     */
+    struct zone_state
+    {
+        /// name of the zone
+        std::string Name;
+        /// type of the zone
+        u_int32 Type;
+        /// minimum corner of the zone
+        world::vector3<s_int32> Min;
+        /// maximum corner of the zone
+        world::vector3<s_int32> Max;
+    };
+
+    /**
+     * Copy state of the zone.
+     * @param state receives the zone state.
+     */
+    void get_zone (zone_state & state) const;
+
+    /**
+     * Change zone to the given state.
+     * @param state the state to apply.
+     */
+    void set_zone (const zone_state & state);
+
+    /**
+     * Add the zone to the map or remove it from the map.
+     * @param map the map containing the zone.
+     * @param add true to add the zone, false to remove it.
+     * @return true on success, false otherwise.
+     */
+    bool toggle (MapData *map, const bool & add);
+
+    /// the kind of edit
+    char Op;
+    /// the zone being edited
+    world::zone *Zone;
+    /// whether the zone is currently not part of the map
+    bool Owned;
+    /// zone state before the edit
+    zone_state Before;
+    /// zone state after the edit
+    zone_state After;
+};
+
+#endif // MAP_COMMAND_H
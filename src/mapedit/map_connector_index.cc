@@ -0,0 +1,94 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_connector_index.cc
+ *
+ * @author Kai Sterker
+ * @brief Index of the entities offering a certain connector.
+ */
+
+#include "map_connector_index.h"
+
+// entities per connector
+std::hash_map<MapConnectorIndex::key, MapTagIndex::bitset, MapConnectorIndex::hash_key> MapConnectorIndex::Entities;
+// current revision
+u_int32 MapConnectorIndex::Revision = 0;
+
+// index connector of entity
+void MapConnectorIndex::add (const u_int32 & entity, const MdlConnector *ctor)
+{
+    MapTagIndex::bitset & entities = Entities[make_key (ctor, ctor->side())];
+
+    u_int32 word = entity >> 5;
+    if (word >= entities.size()) entities.resize (word + 1, 0);
+
+    entities[word] |= 1u << (entity & 31);
+    Revision++;
+}
+
+// drop connector of entity
+void MapConnectorIndex::remove (const u_int32 & entity, const MdlConnector *ctor)
+{
+    std::hash_map<key, MapTagIndex::bitset, hash_key>::iterator i = Entities.find (make_key (ctor, ctor->side()));
+    if (i == Entities.end()) return;
+
+    u_int32 word = entity >> 5;
+    if (word < i->second.size())
+    {
+        i->second[word] &= ~(1u << (entity & 31));
+    }
+
+    Revision++;
+}
+
+// collect entities fitting to given connector
+void MapConnectorIndex::merge_matching (const MdlConnector *ctor, MapTagIndex::bitset & result)
+{
+    MdlConnector::face side = MdlConnector::LEFT;
+    switch (ctor->side())
+    {
+        case MdlConnector::LEFT: side = MdlConnector::RIGHT; break;
+        case MdlConnector::RIGHT: side = MdlConnector::LEFT; break;
+        case MdlConnector::FRONT: side = MdlConnector::BACK; break;
+        case MdlConnector::BACK: side = MdlConnector::FRONT; break;
+    }
+
+    std::hash_map<key, MapTagIndex::bitset, hash_key>::const_iterator i = Entities.find (make_key (ctor, side));
+    if (i == Entities.end()) return;
+
+    const MapTagIndex::bitset & entities = i->second;
+    if (result.size() < entities.size()) result.resize (entities.size(), 0);
+
+    for (u_int32 j = 0; j < entities.size(); j++)
+    {
+        result[j] |= entities[j];
+    }
+}
+
+// create key for connector
+MapConnectorIndex::key MapConnectorIndex::make_key (const MdlConnector *ctor, const MdlConnector::face & side)
+{
+    key k;
+    k.Name = ctor->name_id ();
+    k.Side = side;
+    k.Length = ctor->length ();
+    k.Width = ctor->width ();
+    return k;
+}
@@ -0,0 +1,123 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_connector_index.h
+ *
+ * @author Kai Sterker
+ * @brief Index of the entities offering a certain connector.
+ */
+
+#ifndef MAP_CONNECTOR_INDEX_H
+#define MAP_CONNECTOR_INDEX_H
+
+#include <adonthell/base/hash_map.h>
+
+#include "common/mdl_connector.h"
+#include "map_tag_index.h"
+
+/**
+ * Keeps track of the connectors offered by all entities, so that
+ * the entities that fit a given connector can be looked up directly,
+ * instead of comparing all connectors of all entities. Connectors
+ * are indexed by name, side and size. Entities are identified by
+ * their index in the MapTagIndex.
+ */
+class MapConnectorIndex
+{
+public:
+    /**
+     * Add a connector of the given entity to the index.
+     * @param entity index of the entity.
+     * @param ctor the connector.
+     */
+    static void add (const u_int32 & entity, const MdlConnector *ctor);
+
+    /**
+     * Remove a connector of the given entity from the index.
+     * @param entity index of the entity.
+     * @param ctor the connector.
+     */
+    static void remove (const u_int32 & entity, const MdlConnector *ctor);
+
+    /**
+     * Add all entities to the given set that have a connector of the
+     * same name and size on the side opposite to the given connector.
+     * @param ctor the connector to match.
+     * @param result set of entities to extend.
+     */
+    static void merge_matching (const MdlConnector *ctor, MapTagIndex::bitset & result);
+
+    /**
+     * Get a number that changes whenever the connectors of any entity
+     * change. Allows to cache results computed from the index.
+     * @return the current revision of the index.
+     */
+    static u_int32 revision () { return Revision; }
+
+private:
+    /// forbid instantiation
+    MapConnectorIndex ();
+
+    /**
+     * Connector properties relevant for matching.
+     */
+    struct key
+    {
+        /// interned connector name
+        u_int32 Name;
+        /// side of the connector
+        u_int16 Side;
+        /// size when used on horizontal edge
+        u_int16 Length;
+        /// size when used on vertical edge
+        u_int16 Width;
+
+        bool operator == (const key & k) const
+        {
+            return Name == k.Name && Side == k.Side && Length == k.Length && Width == k.Width;
+        }
+    };
+
+    /**
+     * Hash function for connector keys.
+     */
+    struct hash_key
+    {
+        size_t operator() (const key & k) const
+        {
+            return (k.Name * 31 + k.Side) * 65599 + (k.Length << 16 | k.Width);
+        }
+    };
+
+    /**
+     * Create the key for a connector.
+     * @param ctor the connector.
+     * @param side the side to use instead of the connector's.
+     * @return key of the connector.
+     */
+    static key make_key (const MdlConnector *ctor, const MdlConnector::face & side);
+
+    /// entities offering a connector, indexed by connector properties
+    static std::hash_map<key, MapTagIndex::bitset, hash_key> Entities;
+    /// incremented on each change
+    static u_int32 Revision;
+};
+
+#endif // MAP_CONNECTOR_INDEX_H
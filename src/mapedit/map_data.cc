@@ -25,17 +25,23 @@
  */
 
 #include <algorithm>
+#include <cstdio>
 
+#include <adonthell/world/character.h>
+
+#include "map_binary.h"
 #include "map_data.h"
 #include "map_entity.h"
 #include "map_cmdline.h"
 
 // ctor
-MapData::MapData() : world::area ()
+MapData::MapData() : world::area (), Journal (this), Regions (this)
 {
     PosX = 0;
     PosY = 0;
     PosZ = 0;
+    ZonesChanged = true;
+    ZoneRevision = 0;
 }
 
 // dtor
@@ -47,7 +53,24 @@ MapData::~MapData()
 u_int32 MapData::getEntityCount (world::entity *ety) const
 {
     const std::list<world::chunk_info*> & result = getEntityLocations (ety);
-    return result.size();
+    return result.size() + Regions.count (ety);
+}
+
+// put entity on the map
+world::chunk_info *MapData::place (world::entity *ety, const world::coordinates & pos)
+{
+    world::chunk_info *location = add (ety, pos);
+    WalkGrid.add (location);
+
+    // update moveable position
+    world::moving *mov = dynamic_cast<world::moving*>(ety->get_object ());
+    if (mov != NULL)
+    {
+        mov->set_position (pos.x(), pos.y());
+        mov->set_altitude (pos.z());
+    }
+
+    return location;
 }
 
 // get locations of entity on the map
@@ -130,6 +153,20 @@ void MapData::remove_entity (MapEntity *entity)
     }
 }
 
+// add zone to map
+bool MapData::add_zone (world::zone *zone)
+{
+    zoneChanged ();
+    return world::area::add_zone (zone);
+}
+
+// remove zone from map
+void MapData::remove_zone (world::zone *zone)
+{
+    zoneChanged ();
+    world::area::remove_zone (zone);
+}
+
 // find all zones in the given view
 std::list<world::zone*> MapData::zones_in_view (const s_int32 & x, const s_int32 & y, const s_int32 & z, const s_int32 & length, const s_int32 & width) const
 {
@@ -139,20 +176,95 @@ std::list<world::zone*> MapData::zones_in_view (const s_int32 & x, const s_int32
     s_int32 min_yz = y - z;
     s_int32 max_yz = min_yz + width;
     
-    std::list<world::zone *>::const_iterator i;
-    for (i = Zones.begin(); i != Zones.end(); i++)
+    // zones are loaded, added or changed rarely compared to drawing them
+    if (ZonesChanged)
     {
-        // no overlap on x-axis
-        if (max_x < (*i)->min().x() || x > (*i)->max().x()) continue;
-        // no overlap on y/z-axis
-        if (max_yz < ((*i)->min().y() - (*i)->max().z()) || min_yz > ((*i)->max().y() - (*i)->min().z())) continue;
-        
-        result.push_back (*i);        
+        ZoneIndex.build (Zones);
+        ZonesChanged = false;
     }
 
+    ZoneIndex.find (x, max_x, min_yz, max_yz, result);
+
     return result;
 }
 
+// load map in either format
+bool MapData::loadFile (const std::string & fname)
+{
+    if (!MapBinary::is_binary (fname))
+    {
+        return load (fname);
+    }
+
+    Filename = fname;
+    return MapBinary::load (this, fname);
+}
+
+// save map in format matching the file extension
+bool MapData::saveFile (const std::string & fname)
+{
+    if (MapBinary::has_extension (fname))
+    {
+        if (!MapBinary::save (this, fname))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        base::diskio *rec = record ();
+        bool result = rec != NULL && writeRecord (rec, fname);
+        delete rec;
+
+        if (!result)
+        {
+            return false;
+        }
+    }
+
+    Filename = fname;
+    return true;
+}
+
+// copy map contents for writing as XML
+base::diskio *MapData::record ()
+{
+    // XML is written from the objects on the map, so all of them must be there
+    Regions.load_all ();
+
+    base::diskio *rec = new base::diskio (base::diskio::XML_FILE);
+    if (!put_state (*rec))
+    {
+        fprintf (stderr, "*** MapData::record: error storing map contents\n");
+        delete rec;
+        return NULL;
+    }
+
+    return rec;
+}
+
+// write map contents as XML
+bool MapData::writeRecord (base::diskio *rec, const std::string & fname)
+{
+    // write to temporary file, so we never leave a broken map behind
+    std::string tmpname = fname + ".tmp";
+    if (!rec->put_record (tmpname) || rename (tmpname.c_str (), fname.c_str ()) != 0)
+    {
+        fprintf (stderr, "*** MapData::writeRecord: error writing '%s'\n", fname.c_str());
+        remove (tmpname.c_str ());
+        return false;
+    }
+
+    return true;
+}
+
+// map written in the background is complete
+void MapData::fileSaved (const std::string & fname, const long & checkpoint)
+{
+    Filename = fname;
+    Journal.saved (fname, checkpoint);
+}
+
 // try to determine model directory used by this map
 std::string MapData::getModelDirectory() const
 {
@@ -27,8 +27,14 @@
 #ifndef MAP_DATA_H
 #define MAP_DATA_H
 
+#include <adonthell/base/diskio.h>
 #include <adonthell/world/area.h>
 
+#include "map_journal.h"
+#include "map_regions.h"
+#include "map_walk_grid.h"
+#include "map_zone_index.h"
+
 class MapEntity;
 
 class MapData : public world::area 
@@ -91,19 +97,31 @@ public:
     world::entity *renameEntity (MapEntity *entity, const std::string & id);
     
     /**
-     * Count how often this entity is present on the map.
+     * Count how often this entity is present on the map, including
+     * parts of the map not currently loaded.
      * @param ety the entity to count.
      * @return number of time this entity is present.
      */
     u_int32 getEntityCount (world::entity *ety) const;
     
     /**
-     * Get all locations of an entity on the map.
+     * Get all locations of an entity on the map. For binary maps,
+     * only locations in loaded parts of the map are returned, unless
+     * MapRegions::load_entity has been called before.
      * @param ety the entity whose locations to get.
      * @return list of entity locations.
      */
     std::list<world::chunk_info*> getEntityLocations (world::entity *ety) const;
 
+    /**
+     * Place an entity on the map, updating the walk grid and, for
+     * moving objects, their position.
+     * @param ety the entity to place.
+     * @param pos where to place the entity.
+     * @return location of the entity on the map.
+     */
+    world::chunk_info *place (world::entity *ety, const world::coordinates & pos);
+
     /**
      * Checks if an entity with this name exists on the map.
      * @param entity_name the entity to check for.
@@ -134,6 +152,31 @@ public:
      * @return iterator past last zone.
      */
     zone_iter lastZone() { return Zones.end(); }
+
+    /**
+     * Add a zone to the map.
+     * @param zone the zone to add.
+     * @return true on success, false if a zone with same name exists.
+     */
+    bool add_zone (world::zone *zone);
+
+    /**
+     * Remove a zone from the map. The zone is not deleted.
+     * @param zone the zone to remove.
+     */
+    void remove_zone (world::zone *zone);
+
+    /**
+     * Notify the map that the extent of a zone has changed.
+     */
+    void zoneChanged () { ZonesChanged = true; ZoneRevision++; }
+
+    /**
+     * Get a number that changes whenever zones are added, removed
+     * or changed. Allows to cache anything computed from the zones.
+     * @return current revision of the map's zones.
+     */
+    u_int32 zoneRevision () const { return ZoneRevision; }
     
     /**
      * Get list of zones that overlap with the given view.
@@ -147,11 +190,76 @@ public:
     std::list<world::zone*> zones_in_view (const s_int32 & x, const s_int32 & y, const s_int32 & z, const s_int32 & length, const s_int32 & width) const;
     //@}
     
+    /**
+     * @name Loading and Saving
+     */
+    //@{
+    /**
+     * Load map from disk. Binary maps are recognized by their
+     * contents, everything else is read as XML.
+     * @param fname full path of the map.
+     * @return true on success, false otherwise.
+     */
+    bool loadFile (const std::string & fname);
+
+    /**
+     * Save map to disk. Files ending in BINARY_MAP_EXT are
+     * written in binary format, everything else as XML.
+     * @param fname full path of the map.
+     * @return true on success, false otherwise.
+     */
+    bool saveFile (const std::string & fname);
+
+    /**
+     * Copy the contents of the map into a record that can be
+     * written as XML without accessing the map again. Loads all
+     * parts of the map that have not been loaded yet.
+     * @return the record, or NULL on error.
+     */
+    base::diskio *record ();
+
+    /**
+     * Write a record returned by record() to disk. Goes through a
+     * temporary file, so that a broken map is never left behind.
+     * Safe to call from a background thread.
+     * @param rec the contents of the map.
+     * @param fname full path of the XML map.
+     * @return true on success, false otherwise.
+     */
+    static bool writeRecord (base::diskio *rec, const std::string & fname);
+
+    /**
+     * Called once a copy of the map has been written to disk in
+     * the background.
+     * @param fname file the map has been written to.
+     * @param checkpoint position of the journal when the copy was made.
+     */
+    void fileSaved (const std::string & fname, const long & checkpoint);
+    //@}
+
     /**
      * @return model directory.
      */
     std::string getModelDirectory() const;
 
+    /**
+     * Get the undo/redo journal of the map.
+     * @return the journal of edits made to this map.
+     */
+    MapJournal *journal () { return &Journal; }
+
+    /**
+     * Get the parts of the map that are loaded on demand.
+     * @return the regions of this map.
+     */
+    MapRegions *regions () { return &Regions; }
+
+    /**
+     * Get the parts of the map blocked by solid objects.
+     * @return the walkability of this map.
+     */
+    MapWalkGrid *walkGrid () { return &WalkGrid; }
+
     /**
      * @name Position Data
      */
@@ -200,6 +308,20 @@ private:
     int PosY;
     /// current x position of map in view
     int PosZ;    
+
+    /// spatial index of the zones on the map
+    mutable MapZoneIndex ZoneIndex;
+    /// whether the zone index needs to be rebuilt
+    mutable bool ZonesChanged;
+    /// incremented whenever zones change
+    u_int32 ZoneRevision;
+
+    /// edits that can be undone
+    MapJournal Journal;
+    /// parts of the map loaded on demand
+    MapRegions Regions;
+    /// parts of the map blocked by solid objects
+    MapWalkGrid WalkGrid;
 };
 
 #endif // MAP_DATA_H
@@ -33,10 +33,14 @@
 #include <adonthell/world/character.h>
 
 #include "backend/gtk/screen_gtk.h"
+#include "common/intern.h"
 #include "common/uid.h"
 #include "gui_filter_dialog.h"
 #include "map_entity.h"
 #include "map_data.h"
+#include "map_connector_index.h"
+#include "map_manifest.h"
+#include "map_tag_index.h"
 
 // ctor
 MapEntity::MapEntity (world::entity *obj, const u_int32 & count)
@@ -44,7 +48,12 @@ MapEntity::MapEntity (world::entity *obj, const u_int32 & count)
     Location = NULL;
     Entity = obj;
     Object = obj->get_object ();
+    ModelFile = Object->modelfile ();
+    Manifest = NULL;
+    Area = NULL;
+    Length = Width = Height = 0;
     RefCount = count;
+    Index = MapTagIndex::add_entity ();
 }
 
 // ctor
@@ -53,20 +62,91 @@ MapEntity::MapEntity (world::placeable *obj)
     Location = NULL;
     Entity = NULL;
     Object = obj;
+    ModelFile = Object->modelfile ();
+    Manifest = NULL;
+    Area = NULL;
+    Length = Width = Height = 0;
     RefCount = 0;
+    Index = MapTagIndex::add_entity ();
+}
+
+// ctor
+MapEntity::MapEntity (world::area *map, const MapManifest::entry & entry, MapManifest *manifest)
+{
+    Location = NULL;
+    Entity = NULL;
+    Object = NULL;
+    ModelFile = entry.ModelFile;
+    Manifest = manifest;
+    Area = map;
+    RefCount = 0;
+    Index = MapTagIndex::add_entity ();
+
+    // restore meta data
+    ObjectType = (world::placeable_type) entry.Type;
+    Length = entry.Length;
+    Width = entry.Width;
+    Height = entry.Height;
+    Comment = entry.Comment;
+    for (std::vector<std::string>::const_iterator i = entry.Tags.begin(); i != entry.Tags.end(); i++)
+    {
+        add_tag (intern::get (*i));
+    }
+    for (std::vector<MapManifest::connector>::const_iterator i = entry.Connectors.begin(); i != entry.Connectors.end(); i++)
+    {
+        MdlConnectorTemplate *tmpl = MdlConnectorManager::get(i->Template);
+        if (tmpl != NULL)
+        {
+            MdlConnector *ctor = new MdlConnector (tmpl);
+            ctor->set_side((MdlConnector::face) i->Side);
+            ctor->set_pos(i->Pos);
+
+            Connectors.push_back(ctor);
+            MapConnectorIndex::add (Index, ctor);
+        }
+    }
 }
 
 // dtor
 MapEntity::~MapEntity()
 {
     remove_tags ();
+    clear_connectors ();
+    MapTagIndex::remove_entity (Index);
+}
+
+// get the placeable, loading it on first access
+world::placeable *MapEntity::object () const
+{
+    if (Object == NULL && Area != NULL)
+    {
+        // same as for objects loaded by the entity list
+        world::object *obj = new world::object(*Area, uid::as_string(uid::hash(ModelFile)));
+        if (!obj->load_model (ModelFile))
+        {
+            fprintf (stderr, "*** MapEntity::object: cannot load model '%s'!\n", ModelFile.c_str());
+            delete obj;
+            return NULL;
+        }
+
+        // set default state
+        obj->set_state ("");
+        Object = obj;
+    }
+
+    return Object;
 }
 
 void MapEntity::loadMetaData ()
 {
+    // discard meta data loaded previously
+    remove_tags ();
+    clear_connectors ();
+    Comment = "";
+
     update_tags();
 
-    std::string name = Object->modelfile();
+    std::string name = ModelFile;
     size_t idx = name.find_last_of('.');
     if (idx == std::string::npos)
     {
@@ -93,7 +173,7 @@ void MapEntity::loadMetaData ()
     base::flat tags = meta_data.get_flat("tags");
     while (tags.next(&value) != base::flat::T_UNKNOWN)
     {
-        add_tag(strdup ((gchar *) value));
+        add_tag(intern::get ((const char *) value));
     }
 
     // load connectors
@@ -110,6 +190,7 @@ void MapEntity::loadMetaData ()
             ctor->set_pos(connector.get_sint16 ("pos"));
 
             Connectors.push_back(ctor);
+            MapConnectorIndex::add (Index, ctor);
         }
     }
 }
@@ -117,6 +198,9 @@ void MapEntity::loadMetaData ()
 // create or update entity
 bool MapEntity::update_entity (const world::placeable_type & obj_type, const char & entity_type, const std::string & id)
 {
+    // make sure the object is loaded
+    if (object() == NULL) return false;
+
     // get map associated with the object
     MapData *map = (MapData*) &(Object->map());    
 
@@ -240,23 +324,18 @@ bool MapEntity::addToLocation(const world::coordinates & pos)
 {
     // get map associated with the object
     MapData *map = (MapData*) &(Object->map());
+
+    // part of the map might not be loaded, e.g. when undoing an edit
+    map->regions()->touch (pos);
     
     // make sure we don't place same object twice at same location
     if (!((world::area*)map)->exists (Entity, pos))
     {
         // place object on map
-        map->add (Entity, pos);
+        map->place (Entity, pos);
         
         // update refcount
         incRef();
-        
-        // update moveable position
-        world::moving *mov = dynamic_cast<world::moving*>(Object);
-        if (mov != NULL)
-        {
-            mov->set_position (pos.x(), pos.y());
-            mov->set_altitude (pos.z());
-        }
 
         return true;
     }
@@ -271,6 +350,7 @@ bool MapEntity::removeAtCurLocation()
     {
         // get map associated with the object
         MapData *map = (MapData*) &(Object->map());
+        map->walkGrid()->remove (Location);
         if (map->remove (*Location) != NULL)
         {
             decRef();
@@ -281,9 +361,42 @@ bool MapEntity::removeAtCurLocation()
     return false;
 }
 
+// remove this entity from the given position
+bool MapEntity::removeFromLocation (const world::vector3<s_int32> & pos)
+{
+    if (Entity == NULL) return false;
+
+    // get map associated with the object
+    MapData *map = (MapData*) &(Object->map());
+    map->regions()->touch (pos);
+
+    const std::list<world::chunk_info*> locations = map->getEntityLocations (Entity);
+    for (std::list<world::chunk_info*>::const_iterator i = locations.begin(); i != locations.end(); i++)
+    {
+        const world::vector3<s_int32> & min = (*i)->Min;
+        if (min.x() == pos.x() && min.y() == pos.y() && min.z() == pos.z())
+        {
+            Location = *i;
+            return removeAtCurLocation ();
+        }
+    }
+
+    return false;
+}
+
 // check intersection of map entity at given position with objects from the given list
 bool MapEntity::intersects (const std::list<world::chunk_info*> & objects, const world::vector3<s_int32> & pos)
 {
+    const world::placeable *obj = object();
+    if (obj == NULL)
+    {
+        Overlapping = false;
+        return false;
+    }
+
+    // only rebuild shape tree if object changed state
+    if (!ShapeTree.is_current (obj)) ShapeTree.build (obj);
+
     // check all objects returned
     for (std::list<world::chunk_info*>::const_iterator i = objects.begin(); i != objects.end(); i++)
     {
@@ -294,7 +407,7 @@ bool MapEntity::intersects (const std::list<world::chunk_info*> & objects, const
         {
             // get the model's current shape, ...
             const world::placeable_shape *shape = (*model)->current_shape ();
-            if (shape->is_solid() && intersects (shape, pos - (*i)->center_min()))
+            if (shape->is_solid() && ShapeTree.intersects (shape, pos - (*i)->center_min()))
             {
                 Overlapping = true;
                 return true;
@@ -309,44 +422,22 @@ bool MapEntity::intersects (const std::list<world::chunk_info*> & objects, const
 // check for intersection of a specific shape with this object
 bool MapEntity::intersects (const world::placeable_shape *other_shape, const world::vector3<s_int32> & offset) const
 {
-    // check all models this entity consists of
-    for (world::placeable::iterator model = Object->begin(); model != Object->end(); model++)
-    {
-        const world::placeable_shape *shape = (*model)->current_shape ();
-        if (shape->is_solid() && shape->intersects (other_shape, offset))
-        {
-            return true;
-        }
-    }
+    const world::placeable *obj = object();
+    if (obj == NULL) return false;
 
-    return false;
+    // check all models this entity consists of
+    if (!ShapeTree.is_current (obj)) ShapeTree.build (obj);
+    return ShapeTree.intersects (other_shape, offset);
 }
 
-void MapEntity::add_tag(const gchar *tag)
+void MapEntity::add_tag(const u_int32 & tag)
 {
     // TODO: check for duplicate tag
 
-    GtkTreeIter row;
-    GtkListStore *filter_model = GuiFilterDialog::getFilterModel();
-
-    if (GuiFilterDialog::findTagInFilter(tag, &row))
-    {
-        // tag already present? -> update count
-        guint count;
-        gtk_tree_model_get (GTK_TREE_MODEL(filter_model), &row, 2, &count, -1);
-        gtk_list_store_set (filter_model, &row, 2, count+1, -1);
-    }
-    else
-    {
-        // otherwise insert new row
-        if (strcmp(tag, "template") != 0)
-        {
-            gtk_list_store_append (filter_model, &row);
-            gtk_list_store_set (filter_model, &row, 0, false, 1, tag, 2, 1, -1);
-        }
-    }
+    GuiFilterDialog::addTag (tag);
 
     Tags.push_back(tag);
+    MapTagIndex::add (Index, tag);
 }
 
 // update tags
@@ -354,13 +445,13 @@ void MapEntity::update_tags ()
 {
     Tags.clear ();
 
-    std::string path = Object->modelfile();
+    std::string path = ModelFile;
     gchar *dir_name = g_path_get_dirname (path.c_str());
     gchar **tags = g_strsplit (dir_name, "/", -1);
 
     for (gchar **iter = tags; *iter != NULL; iter++)
     {
-        add_tag(*iter);
+        add_tag(intern::get (*iter));
     }
 
     g_strfreev (tags);
@@ -370,25 +461,28 @@ void MapEntity::update_tags ()
 // remove all tags this entity contained
 void MapEntity::remove_tags()
 {
-    for (std::vector<std::string>::const_iterator i = Tags.begin(); i != Tags.end(); i++)
+    for (std::vector<u_int32>::const_iterator i = Tags.begin(); i != Tags.end(); i++)
     {
-        GtkTreeIter row;
-        GtkListStore *filter_model = GuiFilterDialog::getFilterModel();
+        GuiFilterDialog::removeTag (*i);
+        MapTagIndex::remove (Index, *i);
+    }
+}
 
-        if (GuiFilterDialog::findTagInFilter(i->c_str(), &row))
-        {
-            // decrease tag count
-            guint count;
-            gtk_tree_model_get (GTK_TREE_MODEL(filter_model), &row, 2, &count, -1);
-            gtk_list_store_set (filter_model, &row, 2, count-1, -1);
-        }
+// delete all connectors of this entity
+void MapEntity::clear_connectors ()
+{
+    for (std::vector<MdlConnector*>::iterator i = Connectors.begin(); i != Connectors.end(); i++)
+    {
+        MapConnectorIndex::remove (Index, *i);
+        delete *i;
     }
+    Connectors.clear ();
 }
 
 // check entity for given tag
 bool MapEntity::hasTag (const std::string & tag) const
 {
-    return std::find (Tags.begin(), Tags.end(), tag) != Tags.end();
+    return std::find (Tags.begin(), Tags.end(), intern::get (tag)) != Tags.end();
 }
 
 // check for matching connectors
@@ -408,7 +502,7 @@ bool MapEntity::canConnectWith (const MapEntity *entity, const bool & strict) co
                 // connectors only match if they are on opposing sides
                 // and have the same name
                 if ((*i)->opposite ((*j)->side()) &&
-                    (*i)->name() == (*j)->name()) return true;
+                    (*i)->name_id() == (*j)->name_id()) return true;
             }
         }
     }
@@ -434,10 +528,10 @@ void MapEntity::connect (const MapEntity *entity, s_int32 & ox, s_int32 & oy) co
                     if ((*i)->length() == (*j)->length() && (*i)->opposite ((*j)->side()))
                     {
                         ox = (*j)->pos() - (*i)->pos();
-                        oy = (*i)->side() == MdlConnector::FRONT ? 0 : Object->width();
+                        oy = (*i)->side() == MdlConnector::FRONT ? 0 : width();
 
                         // exact match found, so stop
-                        if ((*i)->name() == (*j)->name()) return;
+                        if ((*i)->name_id() == (*j)->name_id()) return;
                     }
 
                     break;
@@ -448,11 +542,11 @@ void MapEntity::connect (const MapEntity *entity, s_int32 & ox, s_int32 & oy) co
                     // try connecting left or right
                     if ((*i)->width() == (*j)->width() && (*i)->opposite ((*j)->side()))
                     {
-                        ox = (*i)->side() == MdlConnector::RIGHT ? 0 : Object->length();
+                        ox = (*i)->side() == MdlConnector::RIGHT ? 0 : length();
                         oy = (*j)->pos() - (*i)->pos();
 
                         // exact match found, so stop
-                        if ((*i)->name() == (*j)->name()) return;
+                        if ((*i)->name_id() == (*j)->name_id()) return;
                     }
 
                     break;
@@ -465,7 +559,7 @@ void MapEntity::connect (const MapEntity *entity, s_int32 & ox, s_int32 & oy) co
 // name of entity
 gchar* MapEntity::get_name () const
 {
-    std::string path = Object->modelfile();
+    std::string path = ModelFile;
     gchar* name = g_path_get_basename (path.substr (0, path.rfind(".")).c_str());
     return name;
 }
@@ -499,8 +593,8 @@ gchar* MapEntity::createNewId () const
         }
     }
     
-    // get map associated with the object
-    MapData *map = (MapData*) &(Object->map());
+    // get map associated with the object, without loading it
+    MapData *map = (MapData*) (Object != NULL ? &(Object->map()) : Area);
     
     // try to create unique id
     u_int32 i = 0;
@@ -543,9 +637,30 @@ GdkPixbuf *MapEntity::get_icon (const u_int32 & size) const
 {
     static world::default_renderer renderer;
 
+    // use cached thumbnail, as long as the model is not yet loaded
+    if (Object == NULL && Manifest != NULL && !isOnMap() && size == 32)
+    {
+        GdkPixbuf *icon = Manifest->get_icon (ModelFile);
+        if (icon != NULL) return icon;
+    }
+
+    world::placeable *obj = object();
+
     // pixmap extends
-    int l = Object->length();
-    int h = Object->width() + Object->height();
+    int l = length();
+    int h = width() + height();
+    
+    // model cannot be loaded, so show an empty box of its size instead
+    if (obj == NULL)
+    {
+        if (l <= 0 || h <= 0) l = h = size;
+
+        int nl = l > h ? size : ((float) l / h) * size + 1;
+        int nh = h > l ? size : ((float) h / l) * size + 1;
+        GdkPixbuf *icon = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, nl, nh);
+        gdk_pixbuf_fill (icon, 0x808080FF);
+        return icon;
+    }
     
     // create pixmap
     gfx::surface_gtk *surface = (gfx::surface_gtk *) gfx::create_surface();
@@ -571,13 +686,13 @@ GdkPixbuf *MapEntity::get_icon (const u_int32 & size) const
     surface->fillrect (0, 0, l, h, color);
     
     // properly render the object
-    world::vector3<s_int32> min (0, 0, 0), max (Object->length(), Object->width(), Object->height());
-    world::named_entity ety (Object, "", false);
+    world::vector3<s_int32> min (0, 0, 0), max (obj->length(), obj->width(), obj->height());
+    world::named_entity ety (obj, "", false);
     world::chunk_info ci (&ety, min, max);
     std::list <world::chunk_info*> object_list;
     object_list.push_back (&ci);
     gfx::drawing_area da (0, 0, l, h);
-    renderer.render (0, Object->height(), object_list, da, surface);
+    renderer.render (0, obj->height(), object_list, da, surface);
     
     // thumbnail of entity
     GdkPixbuf *pixbuf = surface->to_pixbuf();
@@ -593,16 +708,19 @@ GdkPixbuf *MapEntity::get_icon (const u_int32 & size) const
 }
 
 // return states of object
-std::hash_set<std::string> MapEntity::get_object_states () const
+std::hash_set<u_int32> MapEntity::get_object_states () const
 {
-    static std::hash_set<std::string> states;
+    static std::hash_set<u_int32> states;
     
     states.clear();
-    for (world::placeable::iterator i = Object->begin(); i != Object->end(); i++)
+    const world::placeable *obj = object();
+    if (obj == NULL) return states;
+
+    for (world::placeable::iterator i = obj->begin(); i != obj->end(); i++)
     {
         for (world::placeable_model::iterator j = (*i)->begin(); j != (*i)->end(); j++)
         {
-            states.insert (j->first);
+            states.insert (intern::get (j->first));
         }
     }
     
@@ -618,12 +736,18 @@ world::placeable_type MapEntity::get_object_type () const
         return Entity->get_object()->type();
     }
     
+    // type remembered from manifest
+    if (Manifest != NULL)
+    {
+        return ObjectType;
+    }
+
     // we don't know the type yet, but we can make an educated guess
-    if (std::find (Tags.begin(), Tags.end(), std::string ("char")) != Tags.end())
+    if (hasTag ("char"))
     {
         return world::CHARACTER;
     }
-    if (std::find (Tags.begin(), Tags.end(), std::string ("item")) != Tags.end())
+    if (hasTag ("item"))
     {
         return world::ITEM;
     }
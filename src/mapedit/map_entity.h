@@ -33,6 +33,8 @@
 #include <adonthell/world/coordinates.h>
 
 #include "common/mdl_connector.h"
+#include "map_manifest.h"
+#include "map_shape_tree.h"
 
 /**
  * Wrapper around an entity on the map, for storage in a
@@ -54,6 +56,16 @@ public:
      * @param obj an object not present on the map.
      */
     MapEntity (world::placeable *obj);
+
+    /**
+     * Create meta data container for object not yet placed
+     * on a map from cached data. The object itself will only
+     * be loaded when it is accessed for the first time.
+     * @param map the map the object will be placed on.
+     * @param entry the cached model data.
+     * @param manifest the cache the model data is stored in.
+     */
+    MapEntity (world::area *map, const MapManifest::entry & entry, MapManifest *manifest);
   
     /**
      * Cleanup.
@@ -72,10 +84,42 @@ public:
     world::entity *entity () const { return Entity; }
         
     /**
-     * Get the placeable wrapped by this object.
-     * @return the placeable.
+     * Get the placeable wrapped by this object. For objects created
+     * from cached data, this will load the object first.
+     * @return the placeable or NULL if it cannot be loaded.
+     */
+    world::placeable *object () const;
+
+    /**
+     * Get the model file of the wrapped object. Unlike object(),
+     * this will never load the object.
+     * @return the model file name, relative to the data directory.
+     */
+    const std::string & modelFile () const { return ModelFile; }
+
+    /**
+     * Get the extension of the wrapped object along the x axis.
+     * For objects created from cached data, this will not load
+     * the object.
+     * @return length of the object.
+     */
+    s_int32 length () const { return Object != NULL ? Object->length () : Length; }
+
+    /**
+     * Get the extension of the wrapped object along the y axis.
+     * For objects created from cached data, this will not load
+     * the object.
+     * @return width of the object.
      */
-    world::placeable *object () const { return Object; }
+    s_int32 width () const { return Object != NULL ? Object->width () : Width; }
+
+    /**
+     * Get the extension of the wrapped object along the z axis.
+     * For objects created from cached data, this will not load
+     * the object.
+     * @return height of the object.
+     */
+    s_int32 height () const { return Object != NULL ? Object->height () : Height; }
     
     /**
      * Create or update the wrapped entity. (For now, only the
@@ -102,6 +146,12 @@ public:
      */
     bool hasTag (const std::string & tag) const;
 
+    /**
+     * Get the index of this entity in the tag index.
+     * @return index of this entity.
+     */
+    u_int32 getIndex () const { return Index; }
+
     /**
      * Check whether this entity shares a connector with the given entity.
      * @param entity the other entity
@@ -158,6 +208,13 @@ public:
      * @return true on success, false otherwise.
      */
     bool removeAtCurLocation ();
+
+    /**
+     * Remove this entity from the given location on the map.
+     * @param pos the location to remove object from.
+     * @return true on success, false otherwise.
+     */
+    bool removeFromLocation (const world::vector3<s_int32> & pos);
     
     /**
      * Set location of this entity. For anonymous entities
@@ -237,9 +294,9 @@ public:
 
     /**
      * Return the states that are possible for this entity.
-     * @return the object states.
+     * @return the object states, as interned strings.
      */
-    std::hash_set<std::string> get_object_states () const;
+    std::hash_set<u_int32> get_object_states () const;
 
     /**
      * Get thumbnail of the object.
@@ -253,6 +310,18 @@ public:
      * @return The comment associated with this object.
      */
     std::string get_comment () const { return Comment; }
+
+    /**
+     * Get the tags associated with this object.
+     * @return the object's tags, as interned strings.
+     */
+    const std::vector<u_int32> & get_tags () const { return Tags; }
+
+    /**
+     * Get the connectors of this object.
+     * @return the object's connectors.
+     */
+    const std::vector<MdlConnector*> & get_connectors () const { return Connectors; }
     //@}
 
 protected:
@@ -268,9 +337,14 @@ protected:
 
     /**
      * Add new tag to the entity
-     * @param tag the tag to add.
+     * @param tag the interned tag to add.
+     */
+    void add_tag(const u_int32 & tag);
+
+    /**
+     * Remove all connectors from the entity.
      */
-    void add_tag(const gchar *tag);
+    void clear_connectors ();
 
     /**
      * Check whether the given shape intersects with this map entity.
@@ -285,9 +359,25 @@ private:
     u_int32 RefCount;
     /// whether the object is currently overlapping another object on the map
     bool Overlapping;
+    /// the object's shapes, for fast overlap checks
+    mutable MapShapeTree ShapeTree;
 
     /// the object this meta data is associated with 
-    world::placeable *Object;
+    mutable world::placeable *Object;
+    /// model file of the object
+    std::string ModelFile;
+    /// map used for loading the object on demand
+    world::area *Area;
+    /// cache the object has been created from, if any
+    MapManifest *Manifest;
+    /// type of the object, if created from cache
+    world::placeable_type ObjectType;
+    /// extension of the object along the x axis, if created from cache
+    u_int16 Length;
+    /// extension of the object along the y axis, if created from cache
+    u_int16 Width;
+    /// extension of the object along the z axis, if created from cache
+    u_int16 Height;
     /// the entity this meta data is associated with
     world::entity *Entity;
     /// position of entity on map (for named entities only)
@@ -299,8 +389,10 @@ private:
     //@{
     /// comment
     std::string Comment;
-    /// list of tags associated with this entity
-    std::vector<std::string> Tags;
+    /// list of tags associated with this entity, as interned strings
+    std::vector<u_int32> Tags;
+    /// index of this entity in the tag index
+    u_int32 Index;
     /// list of connectors for this entity
     std::vector<MdlConnector*> Connectors;
     //@}
@@ -0,0 +1,348 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_journal.cc
+ *
+ * @author Kai Sterker
+ * @brief Undo and redo of map edits.
+ */
+
+#include <sys/stat.h>
+
+#include "map_journal.h"
+
+/// memory available for recorded edits
+#define MAX_JOURNAL_SIZE (4 * 1024 * 1024)
+
+// ctor
+MapJournal::MapJournal (MapData *map)
+{
+    Map = map;
+    Size = 0;
+    Sealed = true;
+    Modified = false;
+    File = NULL;
+}
+
+// dtor
+MapJournal::~MapJournal ()
+{
+    clear ();
+
+    if (File != NULL)
+    {
+        fclose (File);
+    }
+}
+
+// perform and record edit
+bool MapJournal::execute (MapCommand *cmd)
+{
+    if (!cmd->execute (Map))
+    {
+        delete cmd;
+        return false;
+    }
+
+    add (cmd);
+    return true;
+}
+
+// record edit
+void MapJournal::add (MapCommand *cmd)
+{
+    // a new edit invalidates everything undone before
+    clear_undone ();
+
+    std::string record = cmd->put_state ();
+
+    if (!Sealed && !Done.empty())
+    {
+        MapCommand *prev = Done.back ();
+        u_int32 prev_size = prev->size ();
+
+        if (prev->merge (cmd))
+        {
+            Size += prev->size () - prev_size;
+            write ("+" + record);
+            delete cmd;
+
+            trim ();
+            return;
+        }
+    }
+
+    Done.push_back (cmd);
+    Size += cmd->size ();
+    Sealed = false;
+
+    write (record);
+    trim ();
+}
+
+// revert most recent edit
+bool MapJournal::undo ()
+{
+    if (Done.empty()) return false;
+
+    MapCommand *cmd = Done.back ();
+    if (!cmd->undo (Map))
+    {
+        fprintf (stderr, "*** MapJournal::undo: reverting edit failed\n");
+        return false;
+    }
+
+    Done.pop_back ();
+    Undone.push_back (cmd);
+    Sealed = true;
+
+    write ("U");
+    return true;
+}
+
+// perform most recently reverted edit
+bool MapJournal::redo ()
+{
+    if (Undone.empty()) return false;
+
+    MapCommand *cmd = Undone.back ();
+    if (!cmd->execute (Map))
+    {
+        fprintf (stderr, "*** MapJournal::redo: repeating edit failed\n");
+        return false;
+    }
+
+    Undone.pop_back ();
+    Done.push_back (cmd);
+    Sealed = true;
+
+    write ("R");
+    return true;
+}
+
+// drop edits referring to an entity that is about to be deleted
+void MapJournal::forget (const MapEntity *entity)
+{
+    std::deque<MapCommand*>::const_iterator i;
+    for (i = Done.begin(); i != Done.end(); i++)
+    {
+        if ((*i)->references (entity))
+        {
+            clear ();
+            return;
+        }
+    }
+    for (i = Undone.begin(); i != Undone.end(); i++)
+    {
+        if ((*i)->references (entity))
+        {
+            clear ();
+            return;
+        }
+    }
+}
+
+// drop all edits
+void MapJournal::clear ()
+{
+    clear_undone ();
+
+    for (std::deque<MapCommand*>::iterator i = Done.begin(); i != Done.end(); i++)
+    {
+        delete *i;
+    }
+
+    Done.clear ();
+    Size = 0;
+    Sealed = true;
+}
+
+// drop all edits that can be redone
+void MapJournal::clear_undone ()
+{
+    for (std::deque<MapCommand*>::iterator i = Undone.begin(); i != Undone.end(); i++)
+    {
+        Size -= (*i)->size ();
+        delete *i;
+    }
+
+    Undone.clear ();
+}
+
+// forget oldest edits
+void MapJournal::trim ()
+{
+    // always keep the most recent edit
+    while (Size > MAX_JOURNAL_SIZE && Done.size() > 1)
+    {
+        MapCommand *cmd = Done.front ();
+        Size -= cmd->size ();
+        Done.pop_front ();
+        delete cmd;
+    }
+}
+
+// start writing sidecar file
+bool MapJournal::open (const std::string & mapfile, const bool & append)
+{
+    if (File != NULL)
+    {
+        fclose (File);
+    }
+
+    Filename = mapfile + JOURNAL_EXT;
+    Modified = append;
+
+    File = fopen (Filename.c_str (), append ? "a" : "w");
+    if (File == NULL)
+    {
+        fprintf (stderr, "*** MapJournal::open: cannot write '%s'\n", Filename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// remember position before saving the map
+long MapJournal::checkpoint ()
+{
+    // edits after saving must not be merged with those before
+    seal ();
+
+    return File != NULL ? ftell (File) : 0;
+}
+
+// drop edits that have been saved
+bool MapJournal::saved (const std::string & mapfile, const long & checkpoint)
+{
+    // edits made while the map was being saved
+    std::string tail;
+    if (File != NULL)
+    {
+        FILE *in = fopen (Filename.c_str (), "r");
+        if (in != NULL && fseek (in, checkpoint, SEEK_SET) == 0)
+        {
+            char buf[4096];
+            size_t len;
+            while ((len = fread (buf, 1, sizeof (buf), in)) > 0)
+            {
+                tail.append (buf, len);
+            }
+        }
+        if (in != NULL) fclose (in);
+    }
+
+    if (!open (mapfile, false))
+    {
+        return false;
+    }
+
+    if (!tail.empty ())
+    {
+        fputs (tail.c_str (), File);
+        fflush (File);
+        Modified = true;
+    }
+
+    return true;
+}
+
+// append record to sidecar file
+void MapJournal::write (const std::string & record)
+{
+    Modified = true;
+    if (File == NULL) return;
+
+    fputs (record.c_str (), File);
+    fputc ('\n', File);
+
+    // make sure the edit survives a crash
+    fflush (File);
+}
+
+// check for edits of an unsaved session
+bool MapJournal::has_unsaved_edits (const std::string & mapfile)
+{
+    struct stat statbuf;
+    std::string filename = mapfile + JOURNAL_EXT;
+
+    return stat (filename.c_str (), &statbuf) == 0 && statbuf.st_size > 0;
+}
+
+// replay edits from sidecar file
+bool MapJournal::replay (const std::string & mapfile, MapEntityResolver *resolver)
+{
+    std::string filename = mapfile + JOURNAL_EXT;
+    FILE *in = fopen (filename.c_str (), "r");
+    if (in == NULL)
+    {
+        fprintf (stderr, "*** MapJournal::replay: cannot read '%s'\n", filename.c_str());
+        return false;
+    }
+
+    // don't write replayed edits to the file we're reading
+    FILE *out = File;
+    File = NULL;
+
+    bool result = true;
+    std::string line;
+    char buf[1024];
+
+    while (fgets (buf, sizeof (buf), in) != NULL)
+    {
+        line += buf;
+
+        // read entire line, even if longer than our buffer
+        if (line[line.length() - 1] != '\n' && !feof (in)) continue;
+        if (line[line.length() - 1] == '\n') line.erase (line.length() - 1);
+
+        if (line == "U")
+        {
+            result &= undo ();
+        }
+        else if (line == "R")
+        {
+            result &= redo ();
+        }
+        else if (!line.empty())
+        {
+            // continuation of a paint stroke?
+            bool merged = line[0] == '+';
+            if (!merged) seal ();
+
+            MapCommand *cmd = MapCommand::get_state (merged ? line.substr (1) : line, Map, resolver);
+            if (cmd == NULL || !execute (cmd))
+            {
+                fprintf (stderr, "*** MapJournal::replay: skipping edit '%s'\n", line.c_str());
+                result = false;
+            }
+        }
+
+        line.clear ();
+    }
+
+    fclose (in);
+    File = out;
+
+    // stroke of previous session must not continue
+    seal ();
+
+    return result;
+}
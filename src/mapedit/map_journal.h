@@ -0,0 +1,203 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_journal.h
+ *
+ * @author Kai Sterker
+ * @brief Undo and redo of map edits.
+ */
+
+#ifndef MAP_JOURNAL_H
+#define MAP_JOURNAL_H
+
+#include <cstdio>
+#include <deque>
+
+#include "map_command.h"
+
+/// extension of the file the journal of a map is written to
+#define JOURNAL_EXT ".journal"
+
+/**
+ * Keeps the edits made to a map, so that they can be undone and
+ * redone. Only a limited amount of memory is used for that, after
+ * which the oldest edits are forgotten. Each edit is also appended
+ * to a sidecar file next to the map as soon as it is made. That file
+ * is reset when the map is saved, so if it still contains anything
+ * when loading the map, the previous session ended without saving
+ * and its edits can be replayed.
+ */
+class MapJournal
+{
+public:
+    /**
+     * Create an empty journal.
+     * @param map the map whose edits are recorded.
+     */
+    MapJournal (MapData *map);
+
+    /**
+     * Cleanup.
+     */
+    ~MapJournal ();
+
+    /**
+     * Apply the given edit to the map and record it. The journal
+     * takes ownership of the command.
+     * @param cmd the edit to perform.
+     * @return true on success, false if the edit failed.
+     */
+    bool execute (MapCommand *cmd);
+
+    /**
+     * Record an edit that already has been applied to the map. The
+     * journal takes ownership of the command.
+     * @param cmd the edit that has been performed.
+     */
+    void add (MapCommand *cmd);
+
+    /**
+     * Revert the most recent edit.
+     * @return true on success, false otherwise.
+     */
+    bool undo ();
+
+    /**
+     * Perform the most recently reverted edit again.
+     * @return true on success, false otherwise.
+     */
+    bool redo ();
+
+    /**
+     * Check whether there is an edit that can be reverted.
+     * @return true if that is the case, false otherwise.
+     */
+    bool can_undo () const { return !Done.empty(); }
+
+    /**
+     * Check whether there is an edit that can be performed again.
+     * @return true if that is the case, false otherwise.
+     */
+    bool can_redo () const { return !Undone.empty(); }
+
+    /**
+     * Prevent the next edit from being merged with the previous one.
+     * Called whenever a paint stroke ends.
+     */
+    void seal () { Sealed = true; }
+
+    /**
+     * Forget all edits, if any of them refers to the given entity.
+     * Must be called before deleting a map entity.
+     * @param entity the entity that is about to be deleted.
+     */
+    void forget (const MapEntity *entity);
+
+    /**
+     * Forget all edits.
+     */
+    void clear ();
+
+    /**
+     * Start writing edits to the sidecar file of the given map.
+     * @param mapfile full path of the map.
+     * @param append true to keep edits already in the file,
+     *      false to start with an empty file.
+     * @return true on success, false otherwise.
+     */
+    bool open (const std::string & mapfile, const bool & append);
+
+    /**
+     * Mark the current position in the sidecar file, before the map
+     * is written to disk in the background. Edits made from then on
+     * are not part of the saved map.
+     * @return position in the sidecar file.
+     */
+    long checkpoint ();
+
+    /**
+     * Drop the edits up to the given checkpoint from the sidecar file,
+     * as they are now part of the saved map. Edits made while saving
+     * are kept, in the sidecar file of the given map.
+     * @param mapfile full path of the saved map.
+     * @param checkpoint position returned by checkpoint().
+     * @return true on success, false otherwise.
+     */
+    bool saved (const std::string & mapfile, const long & checkpoint);
+
+    /**
+     * Check whether edits have been made since the map was loaded
+     * or saved.
+     * @return true if that is the case, false otherwise.
+     */
+    bool modified () const { return Modified; }
+
+    /**
+     * Check whether the sidecar file of the given map contains edits
+     * that have not been saved.
+     * @param mapfile full path of the map.
+     * @return true if that is the case, false otherwise.
+     */
+    static bool has_unsaved_edits (const std::string & mapfile);
+
+    /**
+     * Perform the edits stored in the sidecar file of the given map.
+     * @param mapfile full path of the map.
+     * @param resolver used to find the entities referenced by edits.
+     * @return true if all edits could be replayed, false otherwise.
+     */
+    bool replay (const std::string & mapfile, MapEntityResolver *resolver);
+
+private:
+    /**
+     * Append a line to the sidecar file.
+     * @param record the line to write.
+     */
+    void write (const std::string & record);
+
+    /**
+     * Forget the oldest edits until the journal fits into memory.
+     */
+    void trim ();
+
+    /**
+     * Delete all edits that have been undone.
+     */
+    void clear_undone ();
+
+    /// the map being edited
+    MapData *Map;
+    /// edits that can be undone, oldest first
+    std::deque<MapCommand*> Done;
+    /// edits that can be redone, most recently undone last
+    std::deque<MapCommand*> Undone;
+    /// approximate memory used by the recorded edits
+    u_int32 Size;
+    /// whether the next edit must not be merged with the previous
+    bool Sealed;
+    /// whether there are edits not yet saved
+    bool Modified;
+    /// the sidecar file or NULL
+    FILE *File;
+    /// name of the sidecar file
+    std::string Filename;
+};
+
+#endif // MAP_JOURNAL_H
@@ -0,0 +1,511 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_manifest.cc
+ *
+ * @author Kai Sterker
+ * @brief Cache of model meta data for faster startup.
+ */
+
+#include <cstring>
+
+#include <adonthell/world/placeable.h>
+
+#include "common/intern.h"
+#include "map_entity.h"
+#include "map_manifest.h"
+
+/// identifies a manifest file
+#define MANIFEST_MAGIC "AMMF"
+/// increase whenever the file layout changes
+#define MANIFEST_VERSION 3
+/// size of magic, version, entry count and table size
+#define MANIFEST_HEADER_SIZE 16
+
+/**
+ * Helper to serialize manifest entries into a memory buffer.
+ */
+class manifest_writer
+{
+public:
+    void put_uint8 (const u_int8 & val) { Buffer.push_back (val); }
+    void put_uint16 (const u_int16 & val) { put ((const u_int8*) &val, sizeof (val)); }
+    void put_uint32 (const u_int32 & val) { put ((const u_int8*) &val, sizeof (val)); }
+    void put_string (const std::string & val)
+    {
+        put_uint32 (val.length ());
+        put ((const u_int8*) val.data (), val.length ());
+    }
+    void put (const u_int8 *data, const u_int32 & size) { Buffer.insert (Buffer.end (), data, data + size); }
+
+    /// the serialized data
+    std::vector<u_int8> Buffer;
+};
+
+/**
+ * Helper to deserialize manifest entries from a memory buffer.
+ */
+class manifest_reader
+{
+public:
+    manifest_reader (const u_int8 *data, const u_int32 & size) : Data (data), Size (size), Pos (0), Error (false) { }
+
+    u_int8 get_uint8 () { u_int8 val = 0; get ((u_int8*) &val, sizeof (val)); return val; }
+    u_int16 get_uint16 () { u_int16 val = 0; get ((u_int8*) &val, sizeof (val)); return val; }
+    u_int32 get_uint32 () { u_int32 val = 0; get ((u_int8*) &val, sizeof (val)); return val; }
+    std::string get_string ()
+    {
+        u_int32 length = get_uint32 ();
+        if (Error || Pos + length > Size) { Error = true; return ""; }
+        std::string val ((const char*) Data + Pos, length);
+        Pos += length;
+        return val;
+    }
+    void get (u_int8 *data, const u_int32 & size)
+    {
+        if (Error || Pos + size > Size) { Error = true; return; }
+        memcpy (data, Data + Pos, size);
+        Pos += size;
+    }
+
+    /// whether reading went past the end of data
+    bool error () const { return Error; }
+
+private:
+    const u_int8 *Data;
+    u_int32 Size;
+    u_int32 Pos;
+    bool Error;
+};
+
+// write a single entry
+static void write_entry (manifest_writer & out, const MapManifest::entry & e)
+{
+    out.put_string (e.ModelFile);
+    out.put_uint32 (e.ModelTime);
+    out.put_uint32 (e.ModelSize);
+    out.put_uint32 (e.MetaTime);
+    out.put_uint32 (e.MetaSize);
+
+    out.put_uint8 (e.Type);
+    out.put_uint16 (e.Length);
+    out.put_uint16 (e.Width);
+    out.put_uint16 (e.Height);
+
+    out.put_string (e.Comment);
+    out.put_uint32 (e.Tags.size ());
+    for (std::vector<std::string>::const_iterator i = e.Tags.begin(); i != e.Tags.end(); i++)
+    {
+        out.put_string (*i);
+    }
+    out.put_uint32 (e.Connectors.size ());
+    for (std::vector<MapManifest::connector>::const_iterator i = e.Connectors.begin(); i != e.Connectors.end(); i++)
+    {
+        out.put_uint32 (i->Template);
+        out.put_uint8 (i->Side);
+        out.put_uint16 ((u_int16) i->Pos);
+    }
+
+    out.put_uint16 (e.IconWidth);
+    out.put_uint16 (e.IconHeight);
+    out.put_uint16 (e.IconRowstride);
+    out.put_uint8 (e.IconAlpha);
+    out.put_uint32 (e.IconOffset);
+    out.put_uint32 (e.IconSize);
+}
+
+// read a single entry
+static void read_entry (manifest_reader & in, MapManifest::entry & e)
+{
+    e.ModelFile = in.get_string ();
+    e.ModelTime = in.get_uint32 ();
+    e.ModelSize = in.get_uint32 ();
+    e.MetaTime = in.get_uint32 ();
+    e.MetaSize = in.get_uint32 ();
+
+    e.Type = in.get_uint8 ();
+    e.Length = in.get_uint16 ();
+    e.Width = in.get_uint16 ();
+    e.Height = in.get_uint16 ();
+
+    e.Comment = in.get_string ();
+    u_int32 count = in.get_uint32 ();
+    for (u_int32 i = 0; i < count && !in.error(); i++)
+    {
+        e.Tags.push_back (in.get_string ());
+    }
+    count = in.get_uint32 ();
+    for (u_int32 i = 0; i < count && !in.error(); i++)
+    {
+        MapManifest::connector c;
+        c.Template = in.get_uint32 ();
+        c.Side = in.get_uint8 ();
+        c.Pos = (s_int16) in.get_uint16 ();
+        e.Connectors.push_back (c);
+    }
+
+    e.IconWidth = in.get_uint16 ();
+    e.IconHeight = in.get_uint16 ();
+    e.IconRowstride = in.get_uint16 ();
+    e.IconAlpha = in.get_uint8 ();
+    e.IconOffset = in.get_uint32 ();
+    e.IconSize = in.get_uint32 ();
+
+    e.Seen = false;
+}
+
+// ctor
+MapManifest::MapManifest ()
+{
+    File = NULL;
+    Changed = false;
+}
+
+// dtor
+MapManifest::~MapManifest ()
+{
+    if (File != NULL)
+    {
+        fclose (File);
+    }
+}
+
+// read manifest from disk
+bool MapManifest::load (const std::string & filename)
+{
+    if (File != NULL)
+    {
+        fclose (File);
+        File = NULL;
+    }
+
+    Entries.clear ();
+    Filename = filename;
+    Changed = false;
+
+    File = fopen (filename.c_str (), "rb");
+    if (File == NULL)
+    {
+        // no manifest yet
+        return false;
+    }
+
+    u_int8 header[MANIFEST_HEADER_SIZE];
+    if (fread (header, MANIFEST_HEADER_SIZE, 1, File) != 1)
+    {
+        fclose (File);
+        File = NULL;
+        return false;
+    }
+
+    manifest_reader hdr (header, MANIFEST_HEADER_SIZE);
+    char magic[4];
+    hdr.get ((u_int8*) magic, 4);
+    u_int32 version = hdr.get_uint32 ();
+    u_int32 count = hdr.get_uint32 ();
+    u_int32 size = hdr.get_uint32 ();
+
+    // also rejects manifests written on a machine with different byte order
+    if (memcmp (magic, MANIFEST_MAGIC, 4) != 0 || version != MANIFEST_VERSION)
+    {
+        fprintf (stderr, "*** warning: ignoring outdated model manifest '%s'.\n", filename.c_str());
+        fclose (File);
+        File = NULL;
+        return false;
+    }
+
+    // read the whole table at once
+    std::vector<u_int8> table (size);
+    if (size > 0 && fread (&table[0], size, 1, File) != 1)
+    {
+        fclose (File);
+        File = NULL;
+        return false;
+    }
+
+    manifest_reader in (size > 0 ? &table[0] : NULL, size);
+    for (u_int32 i = 0; i < count && !in.error(); i++)
+    {
+        entry e;
+        read_entry (in, e);
+        if (!in.error())
+        {
+            Entries[e.ModelFile] = e;
+        }
+    }
+
+    if (in.error())
+    {
+        fprintf (stderr, "*** warning: model manifest '%s' is corrupt.\n", filename.c_str());
+        Entries.clear ();
+        fclose (File);
+        File = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+// write manifest to disk
+bool MapManifest::save (const bool & purge)
+{
+    if (Filename.empty ()) return false;
+
+    std::hash_map<std::string, entry>::iterator i = Entries.begin();
+    while (i != Entries.end())
+    {
+        // model no longer exists
+        if (purge && !i->second.Seen)
+        {
+            Entries.erase (i++);
+            Changed = true;
+            continue;
+        }
+
+        i->second.Seen = false;
+        i++;
+    }
+
+    if (!Changed) return true;
+
+    // thumbnails are copied over from the previous manifest
+    for (i = Entries.begin(); i != Entries.end(); i++)
+    {
+        if (i->second.IconData.empty() && i->second.IconSize > 0)
+        {
+            read_icon (i->second, i->second.IconData);
+        }
+    }
+
+    // first pass to determine size of table
+    manifest_writer table;
+    for (i = Entries.begin(); i != Entries.end(); i++)
+    {
+        write_entry (table, i->second);
+    }
+
+    // now we can set the location of the thumbnails
+    u_int32 offset = MANIFEST_HEADER_SIZE + table.Buffer.size ();
+    for (i = Entries.begin(); i != Entries.end(); i++)
+    {
+        i->second.IconSize = i->second.IconData.size ();
+        i->second.IconOffset = i->second.IconSize > 0 ? offset : 0;
+        offset += i->second.IconSize;
+    }
+
+    manifest_writer out;
+    out.put ((const u_int8*) MANIFEST_MAGIC, 4);
+    out.put_uint32 (MANIFEST_VERSION);
+    out.put_uint32 (Entries.size ());
+    out.put_uint32 (table.Buffer.size ());
+    for (i = Entries.begin(); i != Entries.end(); i++)
+    {
+        write_entry (out, i->second);
+    }
+
+    // write to temporary file, so we never leave a broken manifest behind
+    std::string tmpname = Filename + ".tmp";
+    FILE *file = fopen (tmpname.c_str (), "wb");
+    if (file == NULL)
+    {
+        fprintf (stderr, "*** warning: cannot write model manifest '%s'!\n", tmpname.c_str());
+        return false;
+    }
+
+    bool result = fwrite (&out.Buffer[0], out.Buffer.size (), 1, file) == 1;
+    for (i = Entries.begin(); i != Entries.end() && result; i++)
+    {
+        if (!i->second.IconData.empty ())
+        {
+            result = fwrite (&i->second.IconData[0], i->second.IconData.size (), 1, file) == 1;
+        }
+    }
+    result &= fclose (file) == 0;
+
+    if (File != NULL)
+    {
+        fclose (File);
+        File = NULL;
+    }
+
+    if (!result || rename (tmpname.c_str (), Filename.c_str ()) != 0)
+    {
+        fprintf (stderr, "*** warning: cannot write model manifest '%s'!\n", Filename.c_str());
+        remove (tmpname.c_str ());
+        Entries.clear ();
+        return false;
+    }
+
+    // thumbnails are read from disk from now on
+    for (i = Entries.begin(); i != Entries.end(); i++)
+    {
+        std::vector<u_int8>().swap (i->second.IconData);
+    }
+
+    File = fopen (Filename.c_str (), "rb");
+    Changed = false;
+
+    return true;
+}
+
+// get cached data, if still valid
+const MapManifest::entry *MapManifest::find (const std::string & model_file, const struct stat & model, const struct stat *meta)
+{
+    std::hash_map<std::string, entry>::iterator i = Entries.find (model_file);
+    if (i == Entries.end ()) return NULL;
+
+    entry & e = i->second;
+    e.Seen = true;
+
+    if (e.ModelTime != (u_int32) model.st_mtime || e.ModelSize != (u_int32) model.st_size)
+    {
+        return NULL;
+    }
+
+    if (meta == NULL)
+    {
+        return e.MetaTime == 0 ? &e : NULL;
+    }
+
+    if (e.MetaTime != (u_int32) meta->st_mtime || e.MetaSize != (u_int32) meta->st_size)
+    {
+        return NULL;
+    }
+
+    return &e;
+}
+
+// mark model as present
+void MapManifest::keep (const std::string & model_file)
+{
+    std::hash_map<std::string, entry>::iterator i = Entries.find (model_file);
+    if (i != Entries.end ())
+    {
+        i->second.Seen = true;
+    }
+}
+
+// store freshly loaded model data
+void MapManifest::update (const struct stat & model, const struct stat *meta, const MapEntity *ety)
+{
+    const world::placeable *obj = ety->object ();
+    if (obj == NULL) return;
+
+    entry & e = Entries[ety->modelFile ()];
+
+    e.ModelFile = ety->modelFile ();
+    e.ModelTime = model.st_mtime;
+    e.ModelSize = model.st_size;
+    e.MetaTime = meta ? meta->st_mtime : 0;
+    e.MetaSize = meta ? meta->st_size : 0;
+
+    e.Type = ety->get_object_type ();
+    e.Length = obj->length ();
+    e.Width = obj->width ();
+    e.Height = obj->height ();
+
+    e.Comment = ety->get_comment ();
+    e.Tags.clear ();
+
+    const std::vector<u_int32> & tags = ety->get_tags ();
+    for (std::vector<u_int32>::const_iterator i = tags.begin(); i != tags.end(); i++)
+    {
+        e.Tags.push_back (intern::str (*i));
+    }
+    e.Connectors.clear ();
+
+    const std::vector<MdlConnector*> & connectors = ety->get_connectors ();
+    for (std::vector<MdlConnector*>::const_iterator i = connectors.begin(); i != connectors.end(); i++)
+    {
+        connector c;
+        c.Template = (*i)->uid ();
+        c.Side = (*i)->side ();
+        c.Pos = (*i)->pos ();
+        e.Connectors.push_back (c);
+    }
+
+    // keep a copy of the thumbnail
+    GdkPixbuf *icon = ety->get_icon ();
+    int width = gdk_pixbuf_get_width (icon);
+    int height = gdk_pixbuf_get_height (icon);
+    int rowstride = gdk_pixbuf_get_rowstride (icon);
+    int bpp = gdk_pixbuf_get_n_channels (icon);
+    const guchar *pixels = gdk_pixbuf_get_pixels (icon);
+
+    e.IconWidth = width;
+    e.IconHeight = height;
+    e.IconRowstride = rowstride;
+    e.IconAlpha = gdk_pixbuf_get_has_alpha (icon);
+    e.IconOffset = 0;
+
+    // the last row might not be padded to full rowstride
+    e.IconData.assign (pixels, pixels + (height - 1) * rowstride + width * bpp);
+    e.IconSize = e.IconData.size ();
+
+    g_object_unref (icon);
+
+    e.Seen = true;
+    Changed = true;
+}
+
+// create thumbnail from cached data
+GdkPixbuf *MapManifest::get_icon (const std::string & model_file)
+{
+    std::hash_map<std::string, entry>::const_iterator i = Entries.find (model_file);
+    if (i == Entries.end () || i->second.IconSize == 0) return NULL;
+
+    const entry & e = i->second;
+    std::vector<u_int8> buffer;
+    const std::vector<u_int8> *pixels = &e.IconData;
+
+    if (pixels->empty ())
+    {
+        if (!read_icon (e, buffer)) return NULL;
+        pixels = &buffer;
+    }
+
+    GdkPixbuf *icon = gdk_pixbuf_new (GDK_COLORSPACE_RGB, e.IconAlpha, 8, e.IconWidth, e.IconHeight);
+    guchar *dest = gdk_pixbuf_get_pixels (icon);
+    int rowstride = gdk_pixbuf_get_rowstride (icon);
+    int length = e.IconWidth * gdk_pixbuf_get_n_channels (icon);
+
+    for (int y = 0; y < e.IconHeight; y++)
+    {
+        memcpy (dest + y * rowstride, &(*pixels)[y * e.IconRowstride], length);
+    }
+
+    return icon;
+}
+
+// read thumbnail pixels from manifest file
+bool MapManifest::read_icon (const entry & e, std::vector<u_int8> & pixels)
+{
+    if (File == NULL || e.IconSize == 0) return false;
+
+    pixels.resize (e.IconSize);
+    if (fseek (File, e.IconOffset, SEEK_SET) != 0 ||
+        fread (&pixels[0], e.IconSize, 1, File) != 1)
+    {
+        pixels.clear ();
+        return false;
+    }
+
+    return true;
+}
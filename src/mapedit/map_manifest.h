@@ -0,0 +1,192 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_manifest.h
+ *
+ * @author Kai Sterker
+ * @brief Cache of model meta data for faster startup.
+ */
+
+#ifndef MAP_MANIFEST_H
+#define MAP_MANIFEST_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include <adonthell/base/types.h>
+#include <adonthell/base/hash_map.h>
+
+class MapEntity;
+
+/**
+ * A binary cache of everything the entity list needs to know about
+ * the models in the model directory. Entries are validated against
+ * the modification time and size of the model and its meta data, so
+ * that only models that changed since the last run have to be parsed
+ * again. All other models are loaded on demand, once they get picked
+ * for placing on the map.
+ */
+class MapManifest
+{
+public:
+    /**
+     * A connector of a cached model.
+     */
+    struct connector
+    {
+        /// id of the connector template
+        u_int32 Template;
+        /// side of the model the connector is attached to
+        u_int8 Side;
+        /// position of the connector
+        s_int16 Pos;
+    };
+
+    /**
+     * Cached data of a single model.
+     */
+    struct entry
+    {
+        /// model file name, relative to the data directory
+        std::string ModelFile;
+        /// modification time of the model
+        u_int32 ModelTime;
+        /// size of the model file
+        u_int32 ModelSize;
+        /// modification time of the meta data, 0 if there is none
+        u_int32 MetaTime;
+        /// size of the meta data file
+        u_int32 MetaSize;
+
+        /// the placeable type
+        u_int8 Type;
+        /// extension of the model along the x axis
+        u_int16 Length;
+        /// extension of the model along the y axis
+        u_int16 Width;
+        /// extension of the model along the z axis
+        u_int16 Height;
+
+        /// the model description
+        std::string Comment;
+        /// the model's tags
+        std::vector<std::string> Tags;
+        /// the model's connectors
+        std::vector<connector> Connectors;
+
+        /// thumbnail width
+        u_int16 IconWidth;
+        /// thumbnail height
+        u_int16 IconHeight;
+        /// thumbnail bytes per row
+        u_int16 IconRowstride;
+        /// whether thumbnail has an alpha channel
+        u_int8 IconAlpha;
+        /// offset of thumbnail pixels inside the manifest file
+        u_int32 IconOffset;
+        /// size of thumbnail pixels, 0 if there is no thumbnail
+        u_int32 IconSize;
+        /// thumbnail pixels not yet written to disk
+        std::vector<u_int8> IconData;
+
+        /// whether the model has been seen during the last scan
+        bool Seen;
+    };
+
+    /**
+     * Create an empty manifest.
+     */
+    MapManifest ();
+
+    /**
+     * Cleanup.
+     */
+    ~MapManifest ();
+
+    /**
+     * Read the manifest from the given file. Silently starts with
+     * an empty manifest if the file is missing or outdated.
+     * @param filename full path of the manifest file.
+     * @return true on success, false otherwise.
+     */
+    bool load (const std::string & filename);
+
+    /**
+     * Write the manifest back to disk.
+     * @param purge whether to drop models not seen since the last
+     *      call to save, as they no longer exist.
+     * @return true on success, false otherwise.
+     */
+    bool save (const bool & purge);
+
+    /**
+     * Get the cached data of a model, provided it is still up to date.
+     * @param model_file name of the model, relative to the data directory.
+     * @param model stat of the model file.
+     * @param meta stat of the model's meta data file or NULL.
+     * @return the cached data or NULL if the model needs to be loaded.
+     */
+    const entry *find (const std::string & model_file, const struct stat & model, const struct stat *meta);
+
+    /**
+     * Mark a model as still present, even if its data is not needed.
+     * @param model_file name of the model, relative to the data directory.
+     */
+    void keep (const std::string & model_file);
+
+    /**
+     * Store the data of a freshly loaded model in the manifest.
+     * @param model stat of the model file.
+     * @param meta stat of the model's meta data file or NULL.
+     * @param ety the loaded model.
+     */
+    void update (const struct stat & model, const struct stat *meta, const MapEntity *ety);
+
+    /**
+     * Create the cached thumbnail of a model.
+     * @param model_file name of the model, relative to the data directory.
+     * @return thumbnail of the model or NULL if not cached.
+     */
+    GdkPixbuf *get_icon (const std::string & model_file);
+
+private:
+    /**
+     * Read the thumbnail pixels of the given entry.
+     * @param e the entry whose thumbnail to read.
+     * @param pixels buffer receiving the pixels.
+     * @return true on success, false otherwise.
+     */
+    bool read_icon (const entry & e, std::vector<u_int8> & pixels);
+
+    /// name of the manifest file
+    std::string Filename;
+    /// manifest file, kept open for reading thumbnails
+    FILE *File;
+    /// cached model data, indexed by model file name
+    std::hash_map<std::string, entry> Entries;
+    /// whether the manifest needs saving
+    bool Changed;
+};
+
+#endif // MAP_MANIFEST_H
@@ -41,7 +41,12 @@ public:
      */
     static void set_map (MapData *map)
     {
-        // FIXME: pathfinding not updated yet
+        // the grid is kept up to date once built
+        if (map != NULL && !map->walkGrid()->is_built ())
+        {
+            map->walkGrid()->rebuild (map);
+        }
+
         ActiveMap = map;
     }
 };
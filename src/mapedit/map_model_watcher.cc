@@ -0,0 +1,277 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_model_watcher.cc
+ *
+ * @author Kai Sterker
+ * @brief Monitor the model directory for changes.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <cstdio>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+
+#include "gui_entity_list.h"
+#include "map_model_watcher.h"
+
+#ifdef HAVE_SYS_INOTIFY_H
+/// the events we are interested in
+#define MODEL_WATCH_MASK (IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)
+#endif
+
+// callback for inotify events
+static gboolean on_model_dir_changed (GIOChannel *source, GIOCondition condition, gpointer user_data)
+{
+    MapModelWatcher *watcher = (MapModelWatcher *) user_data;
+    watcher->processEvents ();
+    return TRUE;
+}
+
+// ctor
+MapModelWatcher::MapModelWatcher (GuiEntityList *list)
+{
+    EntityList = list;
+    Channel = NULL;
+    SourceId = 0;
+    Fd = -1;
+}
+
+// dtor
+MapModelWatcher::~MapModelWatcher ()
+{
+    stop ();
+}
+
+// start watching the model directory
+bool MapModelWatcher::watch (const std::string & datadir)
+{
+    stop ();
+
+#ifdef HAVE_SYS_INOTIFY_H
+    Fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+    if (Fd == -1)
+    {
+        fprintf (stderr, "*** warning: cannot monitor model directory '%s'!\n", datadir.c_str());
+        return false;
+    }
+
+    addWatch (datadir, NULL);
+
+    // process events as part of the GTK+ main loop
+    Channel = g_io_channel_unix_new (Fd);
+    SourceId = g_io_add_watch (Channel, G_IO_IN, on_model_dir_changed, this);
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+// stop watching the model directory
+void MapModelWatcher::stop ()
+{
+    if (SourceId != 0)
+    {
+        g_source_remove (SourceId);
+        SourceId = 0;
+    }
+
+    if (Channel != NULL)
+    {
+        g_io_channel_unref (Channel);
+        Channel = NULL;
+    }
+
+    if (Fd != -1)
+    {
+        // this also removes all our watches
+        close (Fd);
+        Fd = -1;
+    }
+
+    Watches.clear ();
+}
+
+// recursively watch the given directory
+void MapModelWatcher::addWatch (const std::string & dir, std::set<std::string> *models)
+{
+#ifdef HAVE_SYS_INOTIFY_H
+    int wd = inotify_add_watch (Fd, dir.c_str (), MODEL_WATCH_MASK | IN_ONLYDIR);
+    if (wd == -1)
+    {
+        fprintf (stderr, "*** warning: cannot monitor directory '%s'!\n", dir.c_str());
+        return;
+    }
+
+    // note that a directory moved inside the tree keeps its descriptor
+    Watches[wd] = dir;
+
+    DIR *dirp;
+    struct dirent *dirent;
+    struct stat statbuf;
+
+    if ((dirp = opendir (dir.c_str ())) != NULL)
+    {
+        while ((dirent = readdir (dirp)) != NULL)
+        {
+            // skip anything starting with ., just like the entity list does
+            if (dirent->d_name[0] == '.') continue;
+
+            std::string filepath = dir + "/";
+            filepath += dirent->d_name;
+
+            if (stat (filepath.c_str (), &statbuf) != -1)
+            {
+                if (S_ISDIR (statbuf.st_mode))
+                {
+                    addWatch (filepath, models);
+                }
+                else if (models != NULL && S_ISREG (statbuf.st_mode) && isModelFile (filepath))
+                {
+                    models->insert (filepath);
+                }
+            }
+        }
+
+        closedir (dirp);
+    }
+#endif
+}
+
+// process pending inotify events
+void MapModelWatcher::processEvents ()
+{
+#ifdef HAVE_SYS_INOTIFY_H
+    char buffer[4096] __attribute__ ((aligned (__alignof__ (struct inotify_event))));
+    const struct inotify_event *event;
+    bool overflow = false;
+    ssize_t len;
+
+    // models are often written more than once when saved, so collect
+    // all pending events first and reload each model only once
+    std::set<std::string> changed;
+    std::set<std::string> removed;
+
+    while ((len = read (Fd, buffer, sizeof (buffer))) > 0)
+    {
+        for (char *ptr = buffer; ptr < buffer + len; ptr += sizeof (struct inotify_event) + event->len)
+        {
+            event = (const struct inotify_event *) ptr;
+
+            // kernel dropped events, so we cannot tell what changed
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                overflow = true;
+                continue;
+            }
+
+            // watched directory is gone
+            if (event->mask & IN_IGNORED)
+            {
+                Watches.erase (event->wd);
+                continue;
+            }
+
+            std::hash_map<int, std::string>::const_iterator dir = Watches.find (event->wd);
+            if (dir == Watches.end() || event->len == 0 || event->name[0] == '.')
+            {
+                continue;
+            }
+
+            std::string filepath = dir->second + "/" + event->name;
+
+            if (event->mask & IN_ISDIR)
+            {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                {
+                    // start watching new directory and pick up its contents
+                    addWatch (filepath, &changed);
+                }
+                else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                {
+                    // drop everything that was contained in the directory
+                    removed.insert (filepath);
+                }
+                continue;
+            }
+
+            if (!isModelFile (filepath))
+            {
+                continue;
+            }
+
+            // files being created are only of interest once they have been written
+            if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+            {
+                removed.erase (filepath);
+                changed.insert (filepath);
+            }
+            else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+            {
+                changed.erase (filepath);
+                removed.insert (filepath);
+            }
+        }
+    }
+
+    if (overflow)
+    {
+        EntityList->refresh ();
+        return;
+    }
+
+    std::set<std::string>::const_iterator i;
+    for (i = removed.begin(); i != removed.end(); i++)
+    {
+        EntityList->removeModel (*i);
+    }
+    for (i = changed.begin(); i != changed.end(); i++)
+    {
+        EntityList->updateModel (*i);
+    }
+#endif
+}
+
+// check if file is a model or its meta data
+bool MapModelWatcher::isModelFile (const std::string & filepath)
+{
+    if (filepath.length() < 5) return false;
+
+    // models are .xml or .amdl files, meta data is stored in .xtra files
+    return filepath.compare (filepath.length() - 4, 4, ".xml") == 0 ||
+           filepath.compare (filepath.length() - 5, 5, ".amdl") == 0 ||
+           isMetaData (filepath);
+}
+
+// check if file is a model's meta data
+bool MapModelWatcher::isMetaData (const std::string & filepath)
+{
+    return filepath.length() > 5 && filepath.compare (filepath.length() - 5, 5, ".xtra") == 0;
+}
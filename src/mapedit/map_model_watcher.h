@@ -0,0 +1,118 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_model_watcher.h
+ *
+ * @author Kai Sterker
+ * @brief Monitor the model directory for changes.
+ */
+
+#ifndef MAP_MODEL_WATCHER_H
+#define MAP_MODEL_WATCHER_H
+
+#include <set>
+#include <string>
+#include <glib.h>
+
+#include <adonthell/base/hash_map.h>
+
+class GuiEntityList;
+
+/**
+ * Watches the model directory and all its subdirectories for
+ * models and meta data being written, moved or deleted. Any such
+ * change is passed on to the entity list, so that only the affected
+ * entries need to be reloaded. Watching is implemented with inotify
+ * and hooked into the GTK+ main loop via a GIOChannel. On systems
+ * without inotify, the watcher does nothing and the entity list has
+ * to be refreshed manually.
+ */
+class MapModelWatcher
+{
+public:
+    /**
+     * Create a watcher that reports to the given entity list.
+     * @param list the entity list to notify of changes.
+     */
+    MapModelWatcher (GuiEntityList *list);
+
+    /**
+     * Stop watching and cleanup.
+     */
+    ~MapModelWatcher ();
+
+    /**
+     * Start watching the given directory recursively. Any
+     * previously watched directory is dropped.
+     * @param datadir the model directory.
+     * @return true on success, false otherwise.
+     */
+    bool watch (const std::string & datadir);
+
+    /**
+     * Stop watching the model directory.
+     */
+    void stop ();
+
+    /**
+     * Read pending file system events and forward the changed
+     * model files to the entity list. Called from the main loop
+     * whenever the inotify descriptor becomes readable.
+     */
+    void processEvents ();
+
+    /**
+     * Check whether the given file is a model's meta data.
+     * @param filepath the file to check.
+     * @return true if the file is an .xtra file.
+     */
+    static bool isMetaData (const std::string & filepath);
+
+protected:
+    /**
+     * Add a watch for the given directory and its subdirectories.
+     * @param dir the directory to watch.
+     * @param models if not NULL, receives the models found in the
+     *      directory. This is required for directories that have
+     *      been created or moved in after watching started.
+     */
+    void addWatch (const std::string & dir, std::set<std::string> *models);
+
+    /**
+     * Check whether the given file is a model or a model's meta data.
+     * @param filepath the file to check.
+     * @return true if the entity list might be interested in the file.
+     */
+    static bool isModelFile (const std::string & filepath);
+
+private:
+    /// the entity list to notify
+    GuiEntityList *EntityList;
+    /// the inotify file descriptor
+    int Fd;
+    /// main loop integration of the inotify descriptor
+    GIOChannel *Channel;
+    /// id of the main loop event source
+    guint SourceId;
+    /// watched directories, indexed by watch descriptor
+    std::hash_map<int, std::string> Watches;
+};
+
+#endif // MAP_MODEL_WATCHER_H
@@ -0,0 +1,363 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_regions.cc
+ *
+ * @author Kai Sterker
+ * @brief Loading parts of a map on demand.
+ */
+
+#include <algorithm>
+#include <sys/mman.h>
+
+#include "map_cmdline.h"
+#include "map_data.h"
+#include "map_regions.h"
+
+/// estimated memory used by an object placed on the map, in bytes
+#define PLACEMENT_MEMORY 256
+
+/// size of a cell in pixels
+#define CELL_SIZE (1 << BINARY_MAP_CELL_SHIFT)
+
+/**
+ * Orders cells by the time they were last viewed.
+ */
+struct region_age
+{
+    region_age (const std::vector<u_int32> & last_used) : LastUsed (last_used) { }
+    bool operator () (const u_int32 & a, const u_int32 & b) const { return LastUsed[a] < LastUsed[b]; }
+    const std::vector<u_int32> & LastUsed;
+};
+
+// ctor
+MapRegions::MapRegions (MapData *map)
+{
+    Map = map;
+    Data = NULL;
+    Size = 0;
+    NumLoaded = 0;
+    Clock = 0;
+    Held = 0;
+}
+
+// dtor
+MapRegions::~MapRegions ()
+{
+    if (Data != NULL)
+    {
+        munmap ((void*) Data, Size);
+    }
+}
+
+// take over binary map
+void MapRegions::attach (const char *data, const u_int32 & size, const std::vector<world::entity*> & entities,
+    const map_cell_record *cells, const u_int32 & num_cells, const map_placement_record *placements)
+{
+    Data = data;
+    Size = size;
+    Entities = entities;
+    Unloaded.assign (Entities.size(), 0);
+
+    for (u_int32 i = 0; i < Entities.size(); i++)
+    {
+        if (Entities[i] != NULL) EntityIndex[Entities[i]] = i;
+    }
+
+    Regions.resize (num_cells);
+    for (u_int32 i = 0; i < num_cells; i++)
+    {
+        region & r = Regions[i];
+        r.X = cells[i].X;
+        r.Y = cells[i].Y;
+        r.Records = placements + cells[i].First;
+        r.Count = cells[i].Count;
+        r.IsChanged = false;
+        r.Loaded = false;
+        r.NumLoaded = 0;
+        r.LastUsed = 0;
+
+        Index[std::make_pair (r.X, r.Y)] = i;
+
+        for (u_int32 j = 0; j < r.Count; j++)
+        {
+            if (r.Records[j].Entity < Unloaded.size()) Unloaded[r.Records[j].Entity]++;
+        }
+    }
+}
+
+// load cells in view
+bool MapRegions::update (const s_int32 & x, const s_int32 & y, const s_int32 & z, const s_int32 & length, const s_int32 & width)
+{
+    if (Data == NULL) return false;
+
+    Clock++;
+
+    // objects reach into neighbouring cells, so load those as well
+    s_int32 min_x = (x >> BINARY_MAP_CELL_SHIFT) - 1;
+    s_int32 max_x = ((x + length) >> BINARY_MAP_CELL_SHIFT) + 1;
+    s_int32 min_y = ((y - z) >> BINARY_MAP_CELL_SHIFT) - 1;
+    s_int32 max_y = ((y - z + width) >> BINARY_MAP_CELL_SHIFT) + 1;
+
+    for (s_int32 cy = min_y; cy <= max_y; cy++)
+    {
+        for (s_int32 cx = min_x; cx <= max_x; cx++)
+        {
+            region *r = find (cx, cy);
+            if (r == NULL) continue;
+
+            if (!r->Loaded) load (*r);
+            r->LastUsed = Clock;
+        }
+    }
+
+    // number of placements fitting the budget, as many as possible for huge budgets
+    u_int32 per_megabyte = 1024 * 1024 / PLACEMENT_MEMORY;
+    u_int32 budget = (u_int32) MapCmdline::budget > 0xFFFFFFFFu / per_megabyte ? 0xFFFFFFFFu :
+        (u_int32) MapCmdline::budget * per_megabyte;
+    if (NumLoaded <= budget || Held > 0) return false;
+
+    // unload cells that have been out of view the longest
+    std::vector<u_int32> candidates;
+    std::vector<u_int32> last_used (Regions.size());
+    for (u_int32 i = 0; i < Regions.size(); i++)
+    {
+        last_used[i] = Regions[i].LastUsed;
+        if (Regions[i].Loaded && Regions[i].LastUsed != Clock) candidates.push_back (i);
+    }
+    std::sort (candidates.begin(), candidates.end(), region_age (last_used));
+
+    bool result = false;
+    for (std::vector<u_int32>::const_iterator i = candidates.begin(); i != candidates.end() && NumLoaded > budget; i++)
+    {
+        if (unload (Regions[*i])) result = true;
+    }
+
+    return result;
+}
+
+// load every cell
+void MapRegions::load_all ()
+{
+    for (std::vector<region>::iterator r = Regions.begin(); r != Regions.end(); r++)
+    {
+        if (!r->Loaded) load (*r);
+        r->LastUsed = Clock;
+    }
+}
+
+// load cells containing entity
+void MapRegions::load_entity (const world::entity *ety)
+{
+    std::map<const world::entity*, u_int32>::const_iterator idx = EntityIndex.find (ety);
+    if (idx == EntityIndex.end()) return;
+
+    for (std::vector<region>::iterator r = Regions.begin(); r != Regions.end() && Unloaded[idx->second] > 0; r++)
+    {
+        if (r->Loaded) continue;
+
+        const map_placement_record *records = r->IsChanged ? (r->Changed.empty() ? NULL : &r->Changed[0]) : r->Records;
+        u_int32 count = r->IsChanged ? r->Changed.size() : r->Count;
+
+        for (u_int32 i = 0; i < count; i++)
+        {
+            if (records[i].Entity == idx->second)
+            {
+                load (*r);
+                r->LastUsed = Clock;
+                break;
+            }
+        }
+    }
+}
+
+// load cell at given position
+void MapRegions::touch (const world::vector3<s_int32> & pos)
+{
+    if (Data == NULL) return;
+
+    map_placement_record rec;
+    rec.Pos[0] = pos.x();
+    rec.Pos[1] = pos.y();
+    rec.Pos[2] = pos.z();
+
+    region *r = find (MapBinary::cell_x (rec), MapBinary::cell_y (rec));
+    if (r != NULL && !r->Loaded)
+    {
+        load (*r);
+        r->LastUsed = Clock;
+    }
+}
+
+// check whether cell at given position is loaded
+bool MapRegions::is_loaded (const world::vector3<s_int32> & pos) const
+{
+    if (Data == NULL) return true;
+
+    map_placement_record rec;
+    rec.Pos[0] = pos.x();
+    rec.Pos[1] = pos.y();
+    rec.Pos[2] = pos.z();
+
+    std::map<std::pair<s_int32, s_int32>, u_int32>::const_iterator i =
+        Index.find (std::make_pair (MapBinary::cell_x (rec), MapBinary::cell_y (rec)));
+
+    return i == Index.end() || Regions[i->second].Loaded;
+}
+
+// count unloaded placements of entity
+u_int32 MapRegions::count (const world::entity *ety) const
+{
+    std::map<const world::entity*, u_int32>::const_iterator i = EntityIndex.find (ety);
+    return i != EntityIndex.end() ? Unloaded[i->second] : 0;
+}
+
+// collect placements not on the map
+void MapRegions::get_unloaded (std::vector<map_placement_record> & placements) const
+{
+    for (std::vector<region>::const_iterator r = Regions.begin(); r != Regions.end(); r++)
+    {
+        if (r->Loaded) continue;
+
+        if (r->IsChanged)
+        {
+            placements.insert (placements.end(), r->Changed.begin(), r->Changed.end());
+        }
+        else
+        {
+            placements.insert (placements.end(), r->Records, r->Records + r->Count);
+        }
+    }
+}
+
+// place objects of cell on map
+void MapRegions::load (region & r)
+{
+    const map_placement_record *records = r.IsChanged ? (r.Changed.empty() ? NULL : &r.Changed[0]) : r.Records;
+    u_int32 count = r.IsChanged ? r.Changed.size() : r.Count;
+
+    for (u_int32 i = 0; i < count; i++)
+    {
+        const map_placement_record & rec = records[i];
+        world::entity *ety = entity (rec.Entity);
+        if (ety == NULL) continue;
+
+        world::coordinates pos (rec.Pos[0], rec.Pos[1], rec.Pos[2]);
+        Map->place (ety, pos);
+        Unloaded[rec.Entity]--;
+    }
+
+    r.Loaded = true;
+    r.NumLoaded = count;
+    NumLoaded += count;
+}
+
+// remove objects of cell from map
+bool MapRegions::unload (region & r)
+{
+    // the cell, as seen in the map view, is a slanted box on the map
+    s_int32 min_z = Map->min().z();
+    s_int32 max_z = Map->max().z();
+    world::vector3<s_int32> min (r.X * CELL_SIZE, r.Y * CELL_SIZE + min_z, min_z);
+    world::vector3<s_int32> max ((r.X + 1) * CELL_SIZE - 1, (r.Y + 1) * CELL_SIZE - 1 + max_z, max_z);
+
+    std::list<world::chunk_info*> objects = Map->objects_in_bbox (min, max);
+    std::list<world::chunk_info*> in_cell;
+    std::vector<map_placement_record> records;
+
+    // only objects positioned inside the cell belong to it
+    for (std::list<world::chunk_info*>::const_iterator i = objects.begin(); i != objects.end(); i++)
+    {
+        map_placement_record rec;
+        rec.Pos[0] = (*i)->Min.x();
+        rec.Pos[1] = (*i)->Min.y();
+        rec.Pos[2] = (*i)->Min.z();
+        if (MapBinary::cell_x (rec) != r.X || MapBinary::cell_y (rec) != r.Y) continue;
+
+        // the action would be lost with the object
+        if ((*i)->has_action ()) return false;
+
+        rec.Entity = index_of ((*i)->get_entity ());
+        records.push_back (rec);
+        in_cell.push_back (*i);
+    }
+
+    // keep cell contents in memory if they differ from what was loaded
+    std::sort (records.begin(), records.end(), MapBinary::placement_order);
+
+    const map_placement_record *loaded = r.IsChanged ? (r.Changed.empty() ? NULL : &r.Changed[0]) : r.Records;
+    u_int32 count = r.IsChanged ? r.Changed.size() : r.Count;
+
+    bool changed = records.size() != count;
+    for (u_int32 i = 0; i < count && !changed; i++)
+    {
+        changed = records[i].Entity != loaded[i].Entity
+            || records[i].Pos[0] != loaded[i].Pos[0]
+            || records[i].Pos[1] != loaded[i].Pos[1]
+            || records[i].Pos[2] != loaded[i].Pos[2];
+    }
+
+    if (changed)
+    {
+        r.Changed.swap (records);
+        r.IsChanged = true;
+    }
+
+    // now remove them from the map
+    for (std::list<world::chunk_info*>::const_iterator i = in_cell.begin(); i != in_cell.end(); i++)
+    {
+        Map->walkGrid()->remove (*i);
+        Map->remove (**i);
+    }
+
+    count = r.IsChanged ? r.Changed.size() : r.Count;
+    for (u_int32 i = 0; i < count; i++)
+    {
+        Unloaded[r.IsChanged ? r.Changed[i].Entity : r.Records[i].Entity]++;
+    }
+
+    r.Loaded = false;
+    NumLoaded -= std::min (NumLoaded, r.NumLoaded);
+    r.NumLoaded = 0;
+
+    return true;
+}
+
+// find cell by position
+MapRegions::region *MapRegions::find (const s_int32 & x, const s_int32 & y)
+{
+    std::map<std::pair<s_int32, s_int32>, u_int32>::const_iterator i = Index.find (std::make_pair (x, y));
+    return i != Index.end() ? &Regions[i->second] : NULL;
+}
+
+// get or assign entity index
+u_int32 MapRegions::index_of (world::entity *ety)
+{
+    std::map<const world::entity*, u_int32>::const_iterator i = EntityIndex.find (ety);
+    if (i != EntityIndex.end()) return i->second;
+
+    // entity added to the map after loading
+    u_int32 index = Entities.size();
+    Entities.push_back (ety);
+    Unloaded.push_back (0);
+    EntityIndex[ety] = index;
+
+    return index;
+}
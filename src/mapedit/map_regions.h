@@ -0,0 +1,241 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_regions.h
+ *
+ * @author Kai Sterker
+ * @brief Loading parts of a map on demand.
+ */
+
+#ifndef MAP_REGIONS_H
+#define MAP_REGIONS_H
+
+#include <map>
+#include <vector>
+
+#include <adonthell/world/entity.h>
+
+#include "map_binary.h"
+
+class MapData;
+
+/**
+ * Keeps track of which parts of a binary map have their objects
+ * placed on the map. Only the cells around the map view are loaded,
+ * straight from the memory-mapped file. Cells that have not been
+ * viewed for a while are unloaded again once the placements on the
+ * map exceed the memory budget given on the command line.
+ *
+ * Unloading a cell collects the objects that are on the map at that
+ * time, so anything placed or deleted in the meantime is kept, in
+ * memory, until the map is saved. Objects are deleted when their
+ * cell is unloaded, so locations referring to them become invalid.
+ */
+class MapRegions
+{
+public:
+    /**
+     * Create regions of the given map.
+     * @param map the map whose objects are loaded on demand.
+     */
+    MapRegions (MapData *map);
+
+    /**
+     * Release the binary map.
+     */
+    ~MapRegions ();
+
+    /**
+     * Take over the placements of a binary map. The memory mapping
+     * is released by the regions from now on.
+     * @param data start of the memory-mapped binary map.
+     * @param size size of the mapping in bytes.
+     * @param entities the entities the placements refer to.
+     * @param cells the cells of the map.
+     * @param num_cells number of cells.
+     * @param placements the placements, ordered by cell.
+     */
+    void attach (const char *data, const u_int32 & size, const std::vector<world::entity*> & entities,
+        const map_cell_record *cells, const u_int32 & num_cells, const map_placement_record *placements);
+
+    /**
+     * Check whether parts of the map are loaded on demand.
+     * @return true if that is the case, false otherwise.
+     */
+    bool active () const { return Data != NULL; }
+
+    /**
+     * Load the cells in and around the given view, then unload cells
+     * not used recently, if over budget. Arguments are the same as
+     * for MapData::zones_in_view.
+     * @param x x-coordinate of the view.
+     * @param y y-coordinate of the view.
+     * @param z z-coordinate of the view.
+     * @param length size of the view on the x-axis.
+     * @param width size of the view on the y-axis.
+     * @return true if cells have been unloaded, false otherwise.
+     */
+    bool update (const s_int32 & x, const s_int32 & y, const s_int32 & z, const s_int32 & length, const s_int32 & width);
+
+    /**
+     * Load all cells, regardless of the memory budget. Used when
+     * the whole map is needed at once.
+     */
+    void load_all ();
+
+    /**
+     * Load all cells containing the given entity, regardless of
+     * the memory budget. Used when all locations of an entity are
+     * needed.
+     * @param ety an entity of the map.
+     */
+    void load_entity (const world::entity *ety);
+
+    /**
+     * Make sure the cell containing the given position is loaded.
+     * Used before objects are placed or removed.
+     * @param pos a position on the map.
+     */
+    void touch (const world::vector3<s_int32> & pos);
+
+    /**
+     * Check whether the cell containing the given position is loaded.
+     * @param pos a position on the map.
+     * @return true if that is the case, false otherwise.
+     */
+    bool is_loaded (const world::vector3<s_int32> & pos) const;
+
+    /**
+     * Keep all loaded cells on the map until release() is called,
+     * so that locations of objects on the map remain valid meanwhile.
+     * Calls may be nested.
+     */
+    void hold () { Held++; }
+
+    /**
+     * Allow cells to be unloaded again.
+     */
+    void release () { if (Held > 0) Held--; }
+
+    /**
+     * Get the number of placements of the given entity that are
+     * not loaded.
+     * @param ety an entity of the map.
+     * @return number of placements in cells not loaded.
+     */
+    u_int32 count (const world::entity *ety) const;
+
+    /**
+     * Get the placements of all cells not loaded.
+     * @param placements receives the placements.
+     */
+    void get_unloaded (std::vector<map_placement_record> & placements) const;
+
+    /**
+     * Get an entity placements refer to.
+     * @param index entity index of a placement.
+     * @return the entity or NULL.
+     */
+    world::entity *entity (const u_int32 & index) const
+    {
+        return index < Entities.size() ? Entities[index] : NULL;
+    }
+
+private:
+    /**
+     * A cell of the map.
+     */
+    struct region
+    {
+        /// column of the cell
+        s_int32 X;
+        /// row of the cell
+        s_int32 Y;
+        /// placements in the file
+        const map_placement_record *Records;
+        /// number of placements in the file
+        u_int32 Count;
+        /// placements after the cell has been edited
+        std::vector<map_placement_record> Changed;
+        /// whether the cell has been edited
+        bool IsChanged;
+        /// whether the cell is loaded
+        bool Loaded;
+        /// number of placements added to the map
+        u_int32 NumLoaded;
+        /// last time the cell was in view
+        u_int32 LastUsed;
+    };
+
+    /**
+     * Place the objects of a cell on the map.
+     * @param r the cell to load.
+     */
+    void load (region & r);
+
+    /**
+     * Remove the objects of a cell from the map, remembering
+     * what has changed. Cells containing objects with an action
+     * stay loaded, as placements cannot store actions.
+     * @param r the cell to unload.
+     * @return true if the cell has been unloaded, false otherwise.
+     */
+    bool unload (region & r);
+
+    /**
+     * Get the cell at the given position.
+     * @param x column of the cell.
+     * @param y row of the cell.
+     * @return the cell or NULL if it contains no placements.
+     */
+    region *find (const s_int32 & x, const s_int32 & y);
+
+    /**
+     * Get index of the given entity, adding it if necessary.
+     * @param ety an entity of the map.
+     * @return index of the entity.
+     */
+    u_int32 index_of (world::entity *ety);
+
+    /// the map
+    MapData *Map;
+    /// start of the memory-mapped file
+    const char *Data;
+    /// size of the memory-mapped file
+    u_int32 Size;
+    /// the cells containing placements
+    std::vector<region> Regions;
+    /// cell index by column and row
+    std::map<std::pair<s_int32, s_int32>, u_int32> Index;
+    /// the entities placements refer to
+    std::vector<world::entity*> Entities;
+    /// entity indices
+    std::map<const world::entity*, u_int32> EntityIndex;
+    /// number of unloaded placements per entity
+    std::vector<u_int32> Unloaded;
+    /// number of placements loaded
+    u_int32 NumLoaded;
+    /// increases with each update
+    u_int32 Clock;
+    /// while non-zero, no cells are unloaded
+    u_int32 Held;
+};
+
+#endif // MAP_REGIONS_H
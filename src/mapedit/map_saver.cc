@@ -0,0 +1,154 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_saver.cc
+ *
+ * @author Kai Sterker
+ * @brief Saving maps in the background.
+ */
+
+#include <cstdio>
+
+#include "map_binary.h"
+#include "map_data.h"
+#include "map_saver.h"
+
+/// how often to check whether saving is complete, in milliseconds
+#define SAVE_POLL_INTERVAL 50
+
+// the save in progress
+MapSaver::save_task *MapSaver::Task = NULL;
+// the background thread
+GThread *MapSaver::Thread = NULL;
+// main loop source
+guint MapSaver::SourceId = 0;
+
+// start saving map
+void MapSaver::start (MapData *map, const std::string & fname, finished_callback callback, void *data)
+{
+    // one at a time
+    wait ();
+
+    Task = new save_task ();
+    Task->Map = map;
+    Task->Snapshot = NULL;
+    Task->Record = NULL;
+    Task->Filename = fname;
+    Task->Checkpoint = map->journal()->checkpoint ();
+    Task->Callback = callback;
+    Task->Data = data;
+    Task->Result = false;
+    Task->Done = 0;
+
+    if (MapBinary::has_extension (fname))
+    {
+        Task->Snapshot = MapBinary::snapshot (map);
+    }
+    else
+    {
+        Task->Record = map->record ();
+    }
+
+    // map cannot be stored in the requested format
+    if (Task->Snapshot == NULL && Task->Record == NULL)
+    {
+        finish ();
+        return;
+    }
+
+    Thread = g_thread_create (run, Task, TRUE, NULL);
+    if (Thread == NULL)
+    {
+        // no threads, so save right away
+        run (Task);
+        finish ();
+        return;
+    }
+
+    SourceId = g_timeout_add (SAVE_POLL_INTERVAL, poll, NULL);
+}
+
+// wait for save to complete
+void MapSaver::wait ()
+{
+    if (Task == NULL) return;
+
+    if (SourceId != 0)
+    {
+        g_source_remove (SourceId);
+        SourceId = 0;
+    }
+
+    finish ();
+}
+
+// write map to disk
+gpointer MapSaver::run (gpointer data)
+{
+    save_task *task = (save_task *) data;
+    if (task->Snapshot != NULL)
+    {
+        task->Result = task->Snapshot->write (task->Filename);
+    }
+    else
+    {
+        task->Result = MapData::writeRecord (task->Record, task->Filename);
+    }
+
+    g_atomic_int_set (&task->Done, 1);
+    return NULL;
+}
+
+// check for completion
+gboolean MapSaver::poll (gpointer data)
+{
+    if (!g_atomic_int_get (&Task->Done))
+    {
+        return TRUE;
+    }
+
+    SourceId = 0;
+    finish ();
+    return FALSE;
+}
+
+// cleanup after saving
+void MapSaver::finish ()
+{
+    if (Thread != NULL)
+    {
+        g_thread_join (Thread);
+        Thread = NULL;
+    }
+
+    save_task *task = Task;
+    Task = NULL;
+
+    if (task->Result)
+    {
+        task->Map->fileSaved (task->Filename, task->Checkpoint);
+    }
+
+    task->Callback (task->Map, task->Result, task->Data);
+
+    delete task->Snapshot;
+    delete task->Record;
+    delete task;
+}
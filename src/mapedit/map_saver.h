@@ -0,0 +1,142 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_saver.h
+ *
+ * @author Kai Sterker
+ * @brief Saving maps in the background.
+ */
+
+#ifndef MAP_SAVER_H
+#define MAP_SAVER_H
+
+#include <string>
+#include <glib.h>
+
+namespace base
+{
+    class diskio;
+}
+
+class MapData;
+class MapSnapshot;
+
+/**
+ * Writes maps from a background thread, so that editing can continue
+ * while a large map is saved. A copy of the map is taken when saving
+ * starts and only that copy is accessed by the thread. Completion is
+ * noticed from the main loop, so the callback runs on the GUI thread.
+ * Only one map is saved at a time.
+ *
+ * For binary maps, the copy only holds the plain records of the map
+ * and the thread sorts and writes them. For XML maps, the copy is the
+ * record produced by the engine's world::area::put_state, so building
+ * it stays on the GUI thread and only encoding the XML and writing the
+ * file happen in the background. The XML layout is owned by the engine
+ * and is not streamed section by section.
+ */
+class MapSaver
+{
+public:
+    /**
+     * Function called once a map has been saved.
+     * @param map the map that has been saved.
+     * @param result true if the map was written, false on error.
+     * @param data user data passed to start().
+     */
+    typedef void (*finished_callback) (MapData *map, const bool & result, void *data);
+
+    /**
+     * Start writing the given map. Files ending in BINARY_MAP_EXT
+     * are written in binary format, everything else as XML. Waits
+     * for a save still in progress first.
+     * @param map the map to save.
+     * @param fname full path of the map.
+     * @param callback function to call once saving is complete.
+     * @param data user data passed to the callback.
+     */
+    static void start (MapData *map, const std::string & fname, finished_callback callback, void *data);
+
+    /**
+     * Block until a save in progress is complete and run its callback.
+     */
+    static void wait ();
+
+    /**
+     * Check whether a map is currently being saved.
+     * @return true if that is the case, false otherwise.
+     */
+    static bool busy () { return Task != NULL; }
+
+private:
+    /**
+     * Everything needed to save a map.
+     */
+    struct save_task
+    {
+        /// the map being saved
+        MapData *Map;
+        /// copy of the map's contents for binary maps
+        MapSnapshot *Snapshot;
+        /// copy of the map's contents for XML maps
+        base::diskio *Record;
+        /// file to write to
+        std::string Filename;
+        /// journal position when the copy was taken
+        long Checkpoint;
+        /// called when done
+        finished_callback Callback;
+        /// user data for the callback
+        void *Data;
+        /// whether writing was successful
+        bool Result;
+        /// set by the thread once writing is complete
+        volatile gint Done;
+    };
+
+    /**
+     * Write the copy of the map to disk. Runs in the background thread.
+     * @param data the save_task.
+     * @return always NULL.
+     */
+    static gpointer run (gpointer data);
+
+    /**
+     * Check from the main loop whether saving is complete.
+     * @param data unused.
+     * @return FALSE once saving is complete, TRUE otherwise.
+     */
+    static gboolean poll (gpointer data);
+
+    /**
+     * Wait for the background thread, then notify the map and
+     * the callback.
+     */
+    static void finish ();
+
+    /// the save in progress or NULL
+    static save_task *Task;
+    /// the background thread or NULL
+    static GThread *Thread;
+    /// id of the main loop source checking for completion
+    static guint SourceId;
+};
+
+#endif // MAP_SAVER_H
@@ -0,0 +1,196 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_shape_tree.cc
+ *
+ * @author Kai Sterker
+ * @brief Bounding volume hierarchy of an object's shapes.
+ */
+
+#include <algorithm>
+
+#include "map_shape_tree.h"
+
+/**
+ * Order leaves by the center of their bounding box along one axis.
+ */
+class compare_center
+{
+public:
+    compare_center (const int & axis) : Axis (axis) { }
+
+    template <class T> bool operator() (const T & a, const T & b) const
+    {
+        return a.Bounds.Min[Axis] + a.Bounds.Max[Axis] < b.Bounds.Min[Axis] + b.Bounds.Max[Axis];
+    }
+
+private:
+    int Axis;
+};
+
+// ctor
+MapShapeTree::MapShapeTree ()
+{
+}
+
+// create tree from object's shapes
+void MapShapeTree::build (const world::placeable *obj)
+{
+    std::vector<node> leaves;
+
+    Nodes.clear ();
+    Shapes.clear ();
+
+    for (world::placeable::iterator model = obj->begin(); model != obj->end(); model++)
+    {
+        const world::placeable_shape *shape = (*model)->current_shape ();
+        Shapes.push_back (shape);
+
+        // only solid shapes can cause overlap
+        node leaf;
+        if (shape != NULL && shape->is_solid() && get_bounds (shape, leaf.Bounds))
+        {
+            leaf.Left = -1;
+            leaf.Right = -1;
+            leaf.Shape = shape;
+            leaves.push_back (leaf);
+        }
+    }
+
+    if (!leaves.empty())
+    {
+        Nodes.reserve (2 * leaves.size() - 1);
+        build (leaves, 0, leaves.size());
+    }
+}
+
+// recursively create nodes, top down
+s_int32 MapShapeTree::build (std::vector<node> & leaves, const u_int32 & first, const u_int32 & last)
+{
+    if (last - first == 1)
+    {
+        Nodes.push_back (leaves[first]);
+        return Nodes.size() - 1;
+    }
+
+    // bounding box of all leaves in range
+    node n = leaves[first];
+    for (u_int32 i = first + 1; i < last; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            n.Bounds.Min[j] = std::min (n.Bounds.Min[j], leaves[i].Bounds.Min[j]);
+            n.Bounds.Max[j] = std::max (n.Bounds.Max[j], leaves[i].Bounds.Max[j]);
+        }
+    }
+    n.Shape = NULL;
+
+    // split along longest axis
+    int axis = 0;
+    for (int j = 1; j < 3; j++)
+    {
+        if (n.Bounds.Max[j] - n.Bounds.Min[j] > n.Bounds.Max[axis] - n.Bounds.Min[axis]) axis = j;
+    }
+
+    u_int32 mid = first + (last - first) / 2;
+    std::nth_element (leaves.begin() + first, leaves.begin() + mid, leaves.begin() + last, compare_center (axis));
+
+    s_int32 index = Nodes.size();
+    Nodes.push_back (n);
+
+    s_int32 left = build (leaves, first, mid);
+    s_int32 right = build (leaves, mid, last);
+
+    Nodes[index].Left = left;
+    Nodes[index].Right = right;
+
+    return index;
+}
+
+// check whether tree is up to date
+bool MapShapeTree::is_current (const world::placeable *obj) const
+{
+    std::vector<const world::placeable_shape*>::const_iterator shape = Shapes.begin();
+    for (world::placeable::iterator model = obj->begin(); model != obj->end(); model++, shape++)
+    {
+        if (shape == Shapes.end() || *shape != (*model)->current_shape ()) return false;
+    }
+
+    return shape == Shapes.end() && !Shapes.empty();
+}
+
+// check for overlap with given shape
+bool MapShapeTree::intersects (const world::placeable_shape *other_shape, const world::vector3<s_int32> & offset) const
+{
+    box query;
+    if (Nodes.empty() || !get_bounds (other_shape, query)) return false;
+
+    // move other shape into our coordinate system
+    query.Min[0] -= offset.x(); query.Max[0] -= offset.x();
+    query.Min[1] -= offset.y(); query.Max[1] -= offset.y();
+    query.Min[2] -= offset.z(); query.Max[2] -= offset.z();
+
+    std::vector<s_int32> stack;
+    stack.push_back (0);
+
+    while (!stack.empty())
+    {
+        const node & n = Nodes[stack.back()];
+        stack.pop_back ();
+
+        if (!overlap (n.Bounds, query)) continue;
+
+        if (n.Shape != NULL)
+        {
+            // only leaves passing the broad phase need a detailed check
+            if (n.Shape->intersects (other_shape, offset)) return true;
+        }
+        else
+        {
+            stack.push_back (n.Right);
+            stack.push_back (n.Left);
+        }
+    }
+
+    return false;
+}
+
+// get bounding box of all parts of a shape
+bool MapShapeTree::get_bounds (const world::placeable_shape *shape, box & bounds)
+{
+    std::vector<world::cube3*>::const_iterator part = shape->begin();
+    if (part == shape->end()) return false;
+
+    bounds.Min[0] = (*part)->min_x(); bounds.Max[0] = (*part)->max_x();
+    bounds.Min[1] = (*part)->min_y(); bounds.Max[1] = (*part)->max_y();
+    bounds.Min[2] = (*part)->min_z(); bounds.Max[2] = (*part)->max_z();
+
+    for (part++; part != shape->end(); part++)
+    {
+        bounds.Min[0] = std::min (bounds.Min[0], (s_int32) (*part)->min_x());
+        bounds.Max[0] = std::max (bounds.Max[0], (s_int32) (*part)->max_x());
+        bounds.Min[1] = std::min (bounds.Min[1], (s_int32) (*part)->min_y());
+        bounds.Max[1] = std::max (bounds.Max[1], (s_int32) (*part)->max_y());
+        bounds.Min[2] = std::min (bounds.Min[2], (s_int32) (*part)->min_z());
+        bounds.Max[2] = std::max (bounds.Max[2], (s_int32) (*part)->max_z());
+    }
+
+    return true;
+}
@@ -0,0 +1,133 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_shape_tree.h
+ *
+ * @author Kai Sterker
+ * @brief Bounding volume hierarchy of an object's shapes.
+ */
+
+#ifndef MAP_SHAPE_TREE_H
+#define MAP_SHAPE_TREE_H
+
+#include <vector>
+
+#include <adonthell/world/placeable.h>
+#include <adonthell/world/coordinates.h>
+
+/**
+ * A bounding volume hierarchy over the solid shapes of all models
+ * an object consists of. When checking the object for overlap with
+ * another shape, only those of its shapes whose bounding box touches
+ * the other shape's bounding box need to be tested in detail. The
+ * tree is built from the object's current shapes and needs to be
+ * rebuilt if the object changes state.
+ */
+class MapShapeTree
+{
+public:
+    /**
+     * Create an empty tree.
+     */
+    MapShapeTree ();
+
+    /**
+     * Build the tree from the current shapes of the given object.
+     * @param obj the object whose shapes to add.
+     */
+    void build (const world::placeable *obj);
+
+    /**
+     * Check whether the tree has been built from the current
+     * shapes of the given object.
+     * @param obj the object to check.
+     * @return true if tree is up to date, false otherwise.
+     */
+    bool is_current (const world::placeable *obj) const;
+
+    /**
+     * Check whether any of the shapes in the tree intersects with
+     * the given shape.
+     * @param other_shape the shape to compare.
+     * @param offset offset between the other shape and the shapes in the tree.
+     * @return true if an intersection is found, false otherwise.
+     */
+    bool intersects (const world::placeable_shape *other_shape, const world::vector3<s_int32> & offset) const;
+
+private:
+    /**
+     * An axis aligned bounding box.
+     */
+    struct box
+    {
+        /// minimum along x, y and z axis
+        s_int32 Min[3];
+        /// maximum along x, y and z axis
+        s_int32 Max[3];
+    };
+
+    /**
+     * A node of the tree.
+     */
+    struct node
+    {
+        /// bounding box of everything below this node
+        box Bounds;
+        /// index of the child nodes, -1 for leaves
+        s_int32 Left, Right;
+        /// the shape, for leaves only
+        const world::placeable_shape *Shape;
+    };
+
+    /**
+     * Calculate the bounding box of a shape.
+     * @param shape the shape.
+     * @param bounds receives the bounding box.
+     * @return false if the shape has no parts, true otherwise.
+     */
+    static bool get_bounds (const world::placeable_shape *shape, box & bounds);
+
+    /**
+     * Check whether two boxes overlap or touch.
+     * @return true if that is the case, false otherwise.
+     */
+    static bool overlap (const box & a, const box & b)
+    {
+        return a.Min[0] <= b.Max[0] && b.Min[0] <= a.Max[0] &&
+               a.Min[1] <= b.Max[1] && b.Min[1] <= a.Max[1] &&
+               a.Min[2] <= b.Max[2] && b.Min[2] <= a.Max[2];
+    }
+
+    /**
+     * Recursively create the nodes for the given range of leaves.
+     * @param leaves the leaf nodes.
+     * @param first first leaf of the range.
+     * @param last one past the last leaf of the range.
+     * @return index of the node created.
+     */
+    s_int32 build (std::vector<node> & leaves, const u_int32 & first, const u_int32 & last);
+
+    /// the nodes, with the root at index 0
+    std::vector<node> Nodes;
+    /// the shapes the tree was built from, one per model
+    std::vector<const world::placeable_shape*> Shapes;
+};
+
+#endif // MAP_SHAPE_TREE_H
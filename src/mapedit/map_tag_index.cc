@@ -0,0 +1,130 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_tag_index.cc
+ *
+ * @author Kai Sterker
+ * @brief Index of the entities carrying a certain tag.
+ */
+
+#include "map_tag_index.h"
+
+// entities per tag
+std::vector<MapTagIndex::bitset> MapTagIndex::Entities;
+// indices available for reuse
+std::vector<u_int32> MapTagIndex::FreeIndices;
+// number of indices handed out
+u_int32 MapTagIndex::NumEntities = 0;
+// current revision
+u_int32 MapTagIndex::Revision = 0;
+
+// reserve index for new entity
+u_int32 MapTagIndex::add_entity ()
+{
+    if (!FreeIndices.empty ())
+    {
+        u_int32 entity = FreeIndices.back ();
+        FreeIndices.pop_back ();
+        return entity;
+    }
+
+    return NumEntities++;
+}
+
+// release index of deleted entity
+void MapTagIndex::remove_entity (const u_int32 & entity)
+{
+    u_int32 word = entity >> 5;
+    u_int32 mask = ~(1u << (entity & 31));
+
+    // make sure a reused index starts without tags
+    for (std::vector<bitset>::iterator i = Entities.begin(); i != Entities.end(); i++)
+    {
+        if (word < i->size()) (*i)[word] &= mask;
+    }
+
+    FreeIndices.push_back (entity);
+    Revision++;
+}
+
+// tag entity
+void MapTagIndex::add (const u_int32 & entity, const u_int32 & tag)
+{
+    if (tag >= Entities.size()) Entities.resize (tag + 1);
+    bitset & entities = Entities[tag];
+
+    u_int32 word = entity >> 5;
+    if (word >= entities.size()) entities.resize (word + 1, 0);
+
+    entities[word] |= 1u << (entity & 31);
+    Revision++;
+}
+
+// untag entity
+void MapTagIndex::remove (const u_int32 & entity, const u_int32 & tag)
+{
+    if (tag >= Entities.size()) return;
+    bitset & entities = Entities[tag];
+
+    u_int32 word = entity >> 5;
+    if (word < entities.size())
+    {
+        entities[word] &= ~(1u << (entity & 31));
+        Revision++;
+    }
+}
+
+// check if entity is tagged
+bool MapTagIndex::has_tag (const u_int32 & entity, const u_int32 & tag)
+{
+    return tag < Entities.size() && contains (Entities[tag], entity);
+}
+
+// result = result | entities
+void MapTagIndex::merge (const u_int32 & tag, bitset & result)
+{
+    if (tag >= Entities.size()) return;
+
+    const bitset & entities = Entities[tag];
+    if (result.size() < entities.size()) result.resize (entities.size(), 0);
+
+    for (u_int32 i = 0; i < entities.size(); i++)
+    {
+        result[i] |= entities[i];
+    }
+}
+
+// result = result & entities
+void MapTagIndex::intersect (const u_int32 & tag, bitset & result)
+{
+    if (tag >= Entities.size())
+    {
+        result.clear ();
+        return;
+    }
+
+    const bitset & entities = Entities[tag];
+    if (result.size() > entities.size()) result.resize (entities.size());
+
+    for (u_int32 i = 0; i < result.size(); i++)
+    {
+        result[i] &= entities[i];
+    }
+}
@@ -0,0 +1,128 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_tag_index.h
+ *
+ * @author Kai Sterker
+ * @brief Index of the entities carrying a certain tag.
+ */
+
+#ifndef MAP_TAG_INDEX_H
+#define MAP_TAG_INDEX_H
+
+#include <vector>
+
+#include <adonthell/base/types.h>
+
+/**
+ * Keeps track of which entities carry which tag. Each entity is
+ * assigned a small index on creation and each tag owns a bitset
+ * of entity indices, so that the entities matching a combination
+ * of tags can be determined by combining bitsets instead of
+ * checking the tags of each entity.
+ */
+class MapTagIndex
+{
+public:
+    /// a set of entity indices
+    typedef std::vector<u_int32> bitset;
+
+    /**
+     * Reserve an index for a new entity.
+     * @return index of the entity.
+     */
+    static u_int32 add_entity ();
+
+    /**
+     * Release the index of an entity that is being deleted.
+     * @param entity index of the entity.
+     */
+    static void remove_entity (const u_int32 & entity);
+
+    /**
+     * Add a tag to the given entity.
+     * @param entity index of the entity.
+     * @param tag the interned tag to add.
+     */
+    static void add (const u_int32 & entity, const u_int32 & tag);
+
+    /**
+     * Remove a tag from the given entity.
+     * @param entity index of the entity.
+     * @param tag the interned tag to remove.
+     */
+    static void remove (const u_int32 & entity, const u_int32 & tag);
+
+    /**
+     * Check whether the given entity carries a tag.
+     * @param entity index of the entity.
+     * @param tag the interned tag.
+     * @return true if that is the case, false otherwise.
+     */
+    static bool has_tag (const u_int32 & entity, const u_int32 & tag);
+
+    /**
+     * Add all entities carrying the given tag to the given set.
+     * @param tag the interned tag.
+     * @param result set of entities to extend.
+     */
+    static void merge (const u_int32 & tag, bitset & result);
+
+    /**
+     * Remove all entities not carrying the given tag from the given set.
+     * @param tag the interned tag.
+     * @param result set of entities to restrict.
+     */
+    static void intersect (const u_int32 & tag, bitset & result);
+
+    /**
+     * Check whether an entity is contained in the given set.
+     * @param set a set of entities.
+     * @param entity index of the entity.
+     * @return true if entity is part of the set, false otherwise.
+     */
+    static bool contains (const bitset & set, const u_int32 & entity)
+    {
+        u_int32 word = entity >> 5;
+        return word < set.size() && (set[word] & (1u << (entity & 31))) != 0;
+    }
+
+    /**
+     * Get a number that changes whenever the tags of any entity change.
+     * Allows to cache results computed from the index.
+     * @return the current revision of the index.
+     */
+    static u_int32 revision () { return Revision; }
+
+private:
+    /// forbid instantiation
+    MapTagIndex ();
+
+    /// entities carrying a tag, indexed by interned tag
+    static std::vector<bitset> Entities;
+    /// indices of deleted entities, for reuse
+    static std::vector<u_int32> FreeIndices;
+    /// number of entity indices handed out so far
+    static u_int32 NumEntities;
+    /// incremented on each change
+    static u_int32 Revision;
+};
+
+#endif // MAP_TAG_INDEX_H
@@ -0,0 +1,180 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_walk_grid.cc
+ *
+ * @author Kai Sterker
+ * @brief Walkability of the map.
+ */
+
+#include "map_data.h"
+#include "map_walk_grid.h"
+
+// ctor
+MapWalkGrid::MapWalkGrid ()
+{
+    Built = false;
+    Revision = 0;
+}
+
+// create grid from all objects on the map
+void MapWalkGrid::rebuild (MapData *map)
+{
+    Blocked.clear ();
+    Footprints.clear ();
+
+    std::list<world::chunk_info*> objects = map->objects_in_bbox (map->min(), map->max());
+    for (std::list<world::chunk_info*>::const_iterator i = objects.begin(); i != objects.end(); i++)
+    {
+        std::vector<footprint> & fp = Footprints[*i];
+        get_footprint (*i, fp);
+        mark (fp, Blocked, true);
+    }
+
+    Built = true;
+    Revision++;
+}
+
+// block cells covered by object
+void MapWalkGrid::add (const world::chunk_info *ci)
+{
+    if (!Built || ci == NULL || Footprints.find (ci) != Footprints.end()) return;
+
+    std::vector<footprint> & fp = Footprints[ci];
+    get_footprint (ci, fp);
+
+    if (!fp.empty())
+    {
+        mark (fp, Blocked, true);
+        Revision++;
+    }
+}
+
+// free cells covered by object
+void MapWalkGrid::remove (const world::chunk_info *ci)
+{
+    footprint_map::iterator i = Footprints.find (ci);
+    if (i == Footprints.end()) return;
+
+    if (!i->second.empty())
+    {
+        mark (i->second, Blocked, false);
+        Revision++;
+    }
+
+    Footprints.erase (i);
+}
+
+// get blocked cells in area
+void MapWalkGrid::blocked_cells (const world::vector3<s_int32> & min, const world::vector3<s_int32> & max,
+    std::vector<world::vector3<s_int32> > & cells) const
+{
+    cell first = { min.x() >> MAP_WALK_CELL_SHIFT, min.y() >> MAP_WALK_CELL_SHIFT, min.z() };
+    s_int32 max_x = max.x() >> MAP_WALK_CELL_SHIFT;
+    s_int32 max_y = max.y() >> MAP_WALK_CELL_SHIFT;
+
+    cell_map::const_iterator i = Blocked.lower_bound (first);
+    while (i != Blocked.end() && i->first.Z <= max.z())
+    {
+        const cell & c = i->first;
+
+        // skip to the next row or level when past the area
+        cell next = c;
+        if (c.Y > max_y)
+        {
+            next.Z++;
+            next.Y = first.Y;
+            next.X = first.X;
+        }
+        else if (c.Y < first.Y)
+        {
+            next.Y = first.Y;
+            next.X = first.X;
+        }
+        else if (c.X > max_x)
+        {
+            next.Y++;
+            next.X = first.X;
+        }
+        else if (c.X < first.X)
+        {
+            next.X = first.X;
+        }
+        else
+        {
+            cells.push_back (world::vector3<s_int32> (c.X, c.Y, c.Z));
+            i++;
+            continue;
+        }
+
+        i = Blocked.lower_bound (next);
+    }
+}
+
+// cells covered by solid parts of an object
+void MapWalkGrid::get_footprint (const world::chunk_info *ci, std::vector<footprint> & result)
+{
+    const world::placeable *obj = ci->get_object();
+    const world::vector3<s_int32> pos = ci->center_min();
+
+    for (world::placeable::iterator model = obj->begin(); model != obj->end(); model++)
+    {
+        const world::placeable_shape *shape = (*model)->current_shape ();
+        if (shape == NULL || !shape->is_solid()) continue;
+
+        for (std::vector<world::cube3*>::const_iterator part = shape->begin(); part != shape->end(); part++)
+        {
+            // low parts are walked upon rather than blocking the way
+            if ((*part)->max_z() - (*part)->min_z() <= MAP_WALK_STEP) continue;
+
+            footprint fp;
+            fp.MinX = (pos.x() + (*part)->min_x()) >> MAP_WALK_CELL_SHIFT;
+            fp.MinY = (pos.y() + (*part)->min_y()) >> MAP_WALK_CELL_SHIFT;
+            fp.MaxX = (pos.x() + (*part)->max_x()) >> MAP_WALK_CELL_SHIFT;
+            fp.MaxY = (pos.y() + (*part)->max_y()) >> MAP_WALK_CELL_SHIFT;
+            fp.Z = ci->Min.z();
+            result.push_back (fp);
+        }
+    }
+}
+
+// block or free cells of a footprint
+void MapWalkGrid::mark (const std::vector<footprint> & fp, cell_map & blocked, const bool & add)
+{
+    for (std::vector<footprint>::const_iterator i = fp.begin(); i != fp.end(); i++)
+    {
+        cell c;
+        c.Z = i->Z;
+        for (c.Y = i->MinY; c.Y <= i->MaxY; c.Y++)
+        {
+            for (c.X = i->MinX; c.X <= i->MaxX; c.X++)
+            {
+                if (add)
+                {
+                    blocked[c]++;
+                    continue;
+                }
+
+                cell_map::iterator b = blocked.find (c);
+                if (b != blocked.end() && --(b->second) == 0) blocked.erase (b);
+            }
+        }
+    }
+}
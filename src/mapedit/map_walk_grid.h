@@ -0,0 +1,176 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_walk_grid.h
+ *
+ * @author Kai Sterker
+ * @brief Walkability of the map.
+ */
+
+#ifndef MAP_WALK_GRID_H
+#define MAP_WALK_GRID_H
+
+#include <map>
+#include <vector>
+
+#include <adonthell/world/area.h>
+
+class MapData;
+
+/// walkability is tracked in cells of 2^MAP_WALK_CELL_SHIFT pixels
+#define MAP_WALK_CELL_SHIFT 4
+/// solid parts up to this high can be stepped onto and do not block
+#define MAP_WALK_STEP 8
+
+/**
+ * Keeps track of the parts of the map blocked by solid objects, on
+ * a grid of square cells per level. This is what characters finding
+ * their way across the map will run into, so the grid shows designers
+ * where characters can walk.
+ *
+ * The grid is built for the whole map once and then kept up to date
+ * as objects are placed or removed. Each object remembers the cells
+ * it covers, so only those need updating, even if the object changed
+ * state in the meantime.
+ *
+ * For binary maps, only the parts of the map that are loaded are
+ * covered, as the rest has no objects on the map. That always includes
+ * the map view, where the grid is shown, and cells loaded later are
+ * added as their objects are placed.
+ */
+class MapWalkGrid
+{
+public:
+    /**
+     * Create an empty grid.
+     */
+    MapWalkGrid ();
+
+    /**
+     * Create the grid from all objects on the given map, which
+     * excludes parts of a binary map that are not loaded.
+     * @param map the map.
+     */
+    void rebuild (MapData *map);
+
+    /**
+     * Check whether the grid has been built.
+     * @return true if that is the case, false otherwise.
+     */
+    bool is_built () const { return Built; }
+
+    /**
+     * Block the cells covered by an object placed on the map.
+     * @param ci the object placed.
+     */
+    void add (const world::chunk_info *ci);
+
+    /**
+     * Free the cells covered by an object, before it is removed
+     * from the map.
+     * @param ci the object being removed.
+     */
+    void remove (const world::chunk_info *ci);
+
+    /**
+     * Get the blocked cells in the given area.
+     * @param min minimum of the area, in pixels.
+     * @param max maximum of the area, in pixels.
+     * @param cells receives column, row and level of each blocked cell.
+     */
+    void blocked_cells (const world::vector3<s_int32> & min, const world::vector3<s_int32> & max,
+        std::vector<world::vector3<s_int32> > & cells) const;
+
+    /**
+     * Get a number that changes whenever cells are blocked or freed.
+     * Allows to cache anything computed from the grid.
+     * @return current revision of the grid.
+     */
+    u_int32 revision () const { return Revision; }
+
+private:
+    /**
+     * A cell of the grid.
+     */
+    struct cell
+    {
+        /// column of the cell
+        s_int32 X;
+        /// row of the cell
+        s_int32 Y;
+        /// level of the cell, in pixels
+        s_int32 Z;
+
+        bool operator < (const cell & c) const
+        {
+            if (Z != c.Z) return Z < c.Z;
+            if (Y != c.Y) return Y < c.Y;
+            return X < c.X;
+        }
+    };
+
+    /**
+     * Cells covered by a solid part of an object.
+     */
+    struct footprint
+    {
+        /// first column
+        s_int32 MinX;
+        /// first row
+        s_int32 MinY;
+        /// last column
+        s_int32 MaxX;
+        /// last row
+        s_int32 MaxY;
+        /// level of the object
+        s_int32 Z;
+    };
+
+    /// number of objects blocking a cell
+    typedef std::map<cell, u_int32> cell_map;
+    /// cells covered by each object on the map
+    typedef std::map<const world::chunk_info*, std::vector<footprint> > footprint_map;
+
+    /**
+     * Compute the cells covered by the solid parts of an object.
+     * @param ci the object on the map.
+     * @param result receives the cells covered.
+     */
+    static void get_footprint (const world::chunk_info *ci, std::vector<footprint> & result);
+
+    /**
+     * Add or remove the given footprint to or from a grid.
+     * @param fp cells covered by an object.
+     * @param blocked the grid to update.
+     * @param add true to block the cells, false to free them.
+     */
+    static void mark (const std::vector<footprint> & fp, cell_map & blocked, const bool & add);
+
+    /// number of objects blocking each cell
+    cell_map Blocked;
+    /// cells covered by each object
+    footprint_map Footprints;
+    /// whether the grid has been built
+    bool Built;
+    /// incremented whenever cells change
+    u_int32 Revision;
+};
+
+#endif // MAP_WALK_GRID_H
@@ -0,0 +1,194 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_zone_index.cc
+ *
+ * @author Kai Sterker
+ * @brief Spatial index of the zones on a map.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "map_zone_index.h"
+
+/// maximum number of children per node
+#define NODE_CAPACITY 8
+
+/**
+ * Order items by their center along the x axis.
+ */
+struct compare_x
+{
+    template <class T> bool operator() (const T & a, const T & b) const
+    {
+        return a.Bounds.MinX + a.Bounds.MaxX < b.Bounds.MinX + b.Bounds.MaxX;
+    }
+};
+
+/**
+ * Order items by their center along the y/z axis.
+ */
+struct compare_yz
+{
+    template <class T> bool operator() (const T & a, const T & b) const
+    {
+        return a.Bounds.MinYZ + a.Bounds.MaxYZ < b.Bounds.MinYZ + b.Bounds.MaxYZ;
+    }
+};
+
+/**
+ * Order entries by their position in the map's list of zones.
+ */
+struct compare_pos
+{
+    template <class T> bool operator() (const T & a, const T & b) const
+    {
+        return a.first < b.first;
+    }
+};
+
+// ctor
+MapZoneIndex::MapZoneIndex ()
+{
+}
+
+// pack zones into tree
+void MapZoneIndex::build (const std::list<world::zone*> & zones)
+{
+    Entries.clear ();
+    Nodes.clear ();
+
+    u_int32 pos = 0;
+    for (std::list<world::zone*>::const_iterator i = zones.begin(); i != zones.end(); i++, pos++)
+    {
+        entry e;
+        e.Bounds.MinX = (*i)->min().x();
+        e.Bounds.MaxX = (*i)->max().x();
+        e.Bounds.MinYZ = (*i)->min().y() - (*i)->max().z();
+        e.Bounds.MaxYZ = (*i)->max().y() - (*i)->min().z();
+        e.Pos = pos;
+        e.Zone = *i;
+        Entries.push_back (e);
+    }
+
+    if (Entries.empty()) return;
+
+    // bottom level refers to the zones
+    tile (Entries);
+    std::vector<node> level = pack (Entries, 0, true);
+
+    // then add levels until only the root is left
+    while (level.size() > 1)
+    {
+        tile (level);
+
+        u_int32 first = Nodes.size();
+        Nodes.insert (Nodes.end(), level.begin(), level.end());
+
+        level = pack (level, first, false);
+    }
+
+    Nodes.push_back (level.front());
+}
+
+// sort-tile ordering
+template <class T> void MapZoneIndex::tile (std::vector<T> & items)
+{
+    // number of parent nodes and vertical slices of parents
+    u_int32 parents = (items.size() + NODE_CAPACITY - 1) / NODE_CAPACITY;
+    u_int32 slices = (u_int32) ceil (sqrt ((double) parents));
+    u_int32 slice_size = slices * NODE_CAPACITY;
+
+    std::sort (items.begin(), items.end(), compare_x ());
+    for (u_int32 i = 0; i < items.size(); i += slice_size)
+    {
+        u_int32 end = std::min ((u_int32) items.size(), i + slice_size);
+        std::sort (items.begin() + i, items.begin() + end, compare_yz ());
+    }
+}
+
+// create parents for runs of children
+template <class T> std::vector<MapZoneIndex::node> MapZoneIndex::pack (const std::vector<T> & children, const u_int32 & first, const bool & leaf)
+{
+    std::vector<node> parents;
+
+    for (u_int32 i = 0; i < children.size(); i += NODE_CAPACITY)
+    {
+        node n;
+        n.First = first + i;
+        n.Count = std::min ((u_int32) children.size() - i, (u_int32) NODE_CAPACITY);
+        n.Leaf = leaf;
+        n.Bounds = children[i].Bounds;
+
+        for (u_int32 j = i + 1; j < i + n.Count; j++)
+        {
+            const rect & r = children[j].Bounds;
+            n.Bounds.MinX = std::min (n.Bounds.MinX, r.MinX);
+            n.Bounds.MaxX = std::max (n.Bounds.MaxX, r.MaxX);
+            n.Bounds.MinYZ = std::min (n.Bounds.MinYZ, r.MinYZ);
+            n.Bounds.MaxYZ = std::max (n.Bounds.MaxYZ, r.MaxYZ);
+        }
+
+        parents.push_back (n);
+    }
+
+    return parents;
+}
+
+// find zones in given area
+void MapZoneIndex::find (const s_int32 & min_x, const s_int32 & max_x, const s_int32 & min_yz, const s_int32 & max_yz, std::list<world::zone*> & result) const
+{
+    if (Nodes.empty()) return;
+
+    rect area;
+    area.MinX = min_x;
+    area.MaxX = max_x;
+    area.MinYZ = min_yz;
+    area.MaxYZ = max_yz;
+
+    std::vector<std::pair<u_int32, world::zone*> > found;
+    std::vector<u_int32> stack;
+    stack.push_back (Nodes.size() - 1);
+
+    while (!stack.empty())
+    {
+        const node & n = Nodes[stack.back()];
+        stack.pop_back ();
+
+        if (!overlap (n.Bounds, area)) continue;
+
+        for (u_int32 i = n.First; i < n.First + n.Count; i++)
+        {
+            if (!n.Leaf) stack.push_back (i);
+            else if (overlap (Entries[i].Bounds, area))
+            {
+                found.push_back (std::make_pair (Entries[i].Pos, Entries[i].Zone));
+            }
+        }
+    }
+
+    // keep zones in the same order as on the map
+    std::sort (found.begin(), found.end(), compare_pos ());
+    for (std::vector<std::pair<u_int32, world::zone*> >::const_iterator i = found.begin(); i != found.end(); i++)
+    {
+        result.push_back (i->second);
+    }
+}
@@ -0,0 +1,135 @@
+/*
+ Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+ Part of the Adonthell Project http://adonthell.linuxgames.com
+
+ Mapedit is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ Mapedit is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Mapedit; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * @file mapedit/map_zone_index.h
+ *
+ * @author Kai Sterker
+ * @brief Spatial index of the zones on a map.
+ */
+
+#ifndef MAP_ZONE_INDEX_H
+#define MAP_ZONE_INDEX_H
+
+#include <list>
+#include <vector>
+
+#include <adonthell/world/zone.h>
+
+/**
+ * An R-tree over the zones of a map, used to quickly find the zones
+ * visible in the map view. Zones are indexed by their extent on the
+ * screen, i.e. along the x axis and along the y axis minus height.
+ * The tree is packed in one go from all zones of the map, using the
+ * Sort-Tile-Recursive algorithm, so it needs to be rebuilt whenever
+ * zones are added, removed or resized.
+ */
+class MapZoneIndex
+{
+public:
+    /**
+     * Create an empty index.
+     */
+    MapZoneIndex ();
+
+    /**
+     * Build the index from the given zones.
+     * @param zones the zones of a map.
+     */
+    void build (const std::list<world::zone*> & zones);
+
+    /**
+     * Find all zones overlapping the given area on screen.
+     * @param min_x start of the area along the x axis.
+     * @param max_x end of the area along the x axis.
+     * @param min_yz start of the area along the y axis, minus height.
+     * @param max_yz end of the area along the y axis, minus height.
+     * @param result receives the zones, in the order they have been built from.
+     */
+    void find (const s_int32 & min_x, const s_int32 & max_x, const s_int32 & min_yz, const s_int32 & max_yz, std::list<world::zone*> & result) const;
+
+private:
+    /**
+     * Extent of a zone or node on screen.
+     */
+    struct rect
+    {
+        s_int32 MinX, MaxX;
+        s_int32 MinYZ, MaxYZ;
+    };
+
+    /**
+     * A zone of the map.
+     */
+    struct entry
+    {
+        /// extent of the zone
+        rect Bounds;
+        /// position of the zone in the map's list of zones
+        u_int32 Pos;
+        /// the zone
+        world::zone *Zone;
+    };
+
+    /**
+     * A node of the tree.
+     */
+    struct node
+    {
+        /// extent of everything below this node
+        rect Bounds;
+        /// index of first child node or entry
+        u_int32 First;
+        /// number of children
+        u_int32 Count;
+        /// whether the children are entries
+        bool Leaf;
+    };
+
+    /**
+     * Check whether two rects overlap or touch.
+     * @return true if that is the case, false otherwise.
+     */
+    static bool overlap (const rect & a, const rect & b)
+    {
+        return a.MinX <= b.MaxX && b.MinX <= a.MaxX && a.MinYZ <= b.MaxYZ && b.MinYZ <= a.MaxYZ;
+    }
+
+    /**
+     * Order the given items into tiles of neighbouring items.
+     * @param items the entries or nodes to order.
+     */
+    template <class T> static void tile (std::vector<T> & items);
+
+    /**
+     * Create a parent node for each run of children.
+     * @param children the children, already tiled.
+     * @param first index of the first child in Nodes or Entries.
+     * @param leaf whether children are entries.
+     * @return the parent nodes.
+     */
+    template <class T> static std::vector<node> pack (const std::vector<T> & children, const u_int32 & first, const bool & leaf);
+
+    /// the zones, ordered by tile
+    std::vector<entry> Entries;
+    /// the nodes, with the root being last
+    std::vector<node> Nodes;
+};
+
+#endif // MAP_ZONE_INDEX_H
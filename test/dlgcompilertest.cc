@@ -0,0 +1,295 @@
+/*
+   Copyright (C) 2011 Kai Sterker <kaisterker@linuxgames.com>
+   Part of the Adonthell Project http://adonthell.linuxgames.com
+
+   Adonthell is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   Adonthell is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Adonthell; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ * @file test/dlgcompilertest.cc
+ *
+ * @author Kai Sterker
+ * @brief Compares the code rewriting of the dialogue compiler with
+ *        the original implementation.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "dlgedit/dlg_compiler.h"
+
+/// number of random lines to compare
+#define NUM_LINES 100000
+
+/// pieces random lines are made of
+static const char *pieces[] = {
+    "x", "abc", "gift", "self", "quests", "the_npc", "the_player",
+    "if ", "elif ", "else:", "and", "or", "not", "pass", "return",
+    "_or", "orx", "ifx", "y = ", "z.w", "12", "-3", " ", "  ",
+    "==", "!=", "<", "<=", ">", ">=", "=", ".", ":", "+", "-", "*",
+    "/", "\"", "'", "(", ")", "[", "]", ",", "#", "%", "&", "|", "^"
+};
+
+/**
+ * Has access to the internals of the dialogue compiler.
+ */
+class DlgCompilerTest
+{
+public:
+    DlgCompilerTest (DlgCompiler *compiler) { Compiler = compiler; }
+
+    /**
+     * Check that every operator chain ends, as matchOperator
+     * would loop forever otherwise.
+     * @return true if that is the case, false otherwise.
+     */
+    bool chainsLinked () const
+    {
+        for (int c = 0; c < 256; c++)
+        {
+            int steps = 0;
+            for (int i = DlgCompiler::firstOperator[c]; i != -1; i = DlgCompiler::nextOperator[i])
+            {
+                if (i < 0 || i >= NUM_OPS || ++steps > NUM_OPS) return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * The operator search before it used the operator chains:
+     * the first operator of the table found at the position.
+     */
+    unsigned int oldMatch (const std::string & code, const unsigned long & pos) const
+    {
+        for (unsigned int i = 0; i < NUM_OPS; i++)
+            if (!strncmp (code.substr (pos).c_str (), DlgCompiler::operators[i].c_str (),
+                DlgCompiler::operators[i].length ()))
+                return i;
+
+        return NUM_OPS;
+    }
+
+    unsigned int newMatch (const std::string & code, const unsigned long & pos) const
+    {
+        return Compiler->matchOperator (code, pos);
+    }
+
+    std::string newInflate (const std::string & code) const
+    {
+        return Compiler->inflateCode (code);
+    }
+
+    std::string oldInflate (std::string code) const;
+
+private:
+    DlgCompiler *Compiler;
+};
+
+/**
+ * DlgCompiler::inflateCode as it was before scanning for operators
+ * through the operator chains. Only the stripping of blank tokens
+ * and the skipping of unterminated strings have been changed like
+ * in the new code, as the original read outside the string there.
+ */
+std::string DlgCompilerTest::oldInflate (std::string code) const
+{
+    const std::string *operators = DlgCompiler::operators;
+    unsigned long pos, begin = 0;
+    unsigned int i, prefix, suffix;
+    std::string token, stripped;
+    const std::string the_player("the_player");
+    const std::string the_npc("the_npc");
+    bool is_local = true;
+
+    // replace the_npc/the_player with self.the_npc/self.the_player
+    pos = code.find (the_npc, 0);
+
+    while (pos != code.npos)
+    {
+        if (pos < 5 || strncmp (code.substr (pos-5, pos).c_str(), "self.", 5))
+        {
+            code.insert (pos, "self.");
+            pos += 5;
+        }
+
+        pos = code.find (the_npc, pos + the_npc.size());
+    }
+
+    pos = code.find (the_player, 0);
+
+    while (pos != code.npos)
+    {
+        if (pos < 5 || strncmp (code.substr (pos-5, pos).c_str(), "self.", 5))
+        {
+            code.insert (pos, "self.");
+            pos += 5;
+        }
+
+        pos = code.find (the_player, pos + the_player.size());
+    }
+
+    // scan the string from left to right
+    for (pos = 0; pos < code.length (); pos++)
+        for (i = 0; i < NUM_OPS; i++)
+            // search for the leftmost operator from the current position
+            if (!strncmp (code.substr (pos).c_str (), operators[i].c_str (),
+                operators[i].length ()) || (i == NUM_OPS-1 && pos == code.length()-1))
+            {
+                if (pos == code.length()-1 && i == NUM_OPS-1) pos++;
+
+                token = code.substr (begin, pos-begin);
+
+                for (prefix = 0; prefix < token.length() && token[prefix] == ' '; prefix++);
+                for (suffix = token.length(); suffix > prefix && token[suffix-1] == ' '; suffix--);
+                stripped = token.substr (prefix, suffix-prefix);
+
+                if (i == DlgCompiler::BAND || i == DlgCompiler::BOR || i == DlgCompiler::NOT ||
+                    i == DlgCompiler::RETURN || i == DlgCompiler::PASS || i == DlgCompiler::IF ||
+                    i == DlgCompiler::ELIF || i == DlgCompiler::ELSE)
+                {
+                    if (pos > 0 && isalpha (code[pos-1]))
+                        break;
+                    if (pos < code.length()-operators[i].length()-1 &&
+                        isalpha (code[pos+operators[i].length()]))
+                        break;
+                }
+
+                if (i == DlgCompiler::LBRACKET || i == DlgCompiler::LBRACE)
+                {
+                    begin = pos + 1;
+                    break;
+                }
+
+                if (Compiler->getToken (stripped) == DlgCompiler::LOCAL_VAR)
+                {
+                    is_local = true;
+                }
+                else if (Compiler->getToken (stripped) == DlgCompiler::CHARACTER)
+                {
+                    code.insert (begin+prefix+stripped.length(), "\")");
+                    code.insert (begin+prefix, "rpg.character.get_character(\"");
+
+                    is_local = false;
+                    pos += 31;
+                }
+
+                if (Compiler->getToken (stripped) == DlgCompiler::VARIABLE)
+                {
+                    if (!is_local)
+                    {
+                        if (i == DlgCompiler::ASSIGN)
+                        {
+                            code[pos] = ',';
+                            code.insert (begin+suffix, "\"");
+                            code.insert (begin+prefix, "set_val (\"");
+                            code.append (")");
+                            pos += 11;
+                        }
+                        else
+                        {
+                            code.insert (begin+suffix, "\")");
+                            code.insert (begin+prefix, "get_val (\"");
+                            pos += 12;
+                        }
+                    }
+
+                    if (i == DlgCompiler::ACCESS || i == DlgCompiler::EQ ||
+                        i == DlgCompiler::NEQ || i == DlgCompiler::ASSIGN)
+                    {
+                        if (Compiler->dialogue->entry ()->isQuest (stripped))
+                        {
+                            code.insert (begin+prefix+stripped.length(), "\")");
+                            code.insert (begin+prefix, "adonthell.gamedata_get_quest(\"");
+                            pos += 32;
+                            is_local = false;
+                        }
+
+                        if (Compiler->dialogue->entry ()->isCharacter (stripped))
+                        {
+                            code.insert (begin+prefix+stripped.length(), "\")");
+                            code.insert (begin+prefix, "rpg.character.get_character(\"");
+                            pos += 31;
+                            is_local = false;
+                        }
+                    }
+                    else is_local = true;
+                }
+
+                if (stripped == the_npc || stripped == the_player)
+                    is_local = false;
+
+                if (i == DlgCompiler::COMMA)
+                    is_local = true;
+
+                if (i == DlgCompiler::QUOT || i == DlgCompiler::SQUOT)
+                {
+                    pos = code.find (operators[i], pos+1);
+                    pos = (pos == code.npos ? code.length () : pos) - 1;
+                }
+
+                if (i == DlgCompiler::COMMENT)
+                    pos = code.length ();
+
+                pos += operators[i].length ();
+                begin = pos;
+                break;
+            }
+
+    return code;
+}
+
+int main (int argc, char *argv[])
+{
+    DlgModule module ("", "test", "", "");
+    DlgCompiler compiler (&module);
+    DlgCompilerTest test (&compiler);
+
+    if (!test.chainsLinked ())
+    {
+        std::cout << "operator chains are not set up" << std::endl;
+        return 1;
+    }
+
+    const int num_pieces = sizeof (pieces) / sizeof (pieces[0]);
+    srand (1);
+
+    for (int n = 0; n < NUM_LINES; n++)
+    {
+        std::string line;
+        for (int len = rand () % 10 + 1; len > 0; len--)
+            line += pieces[rand () % num_pieces];
+
+        for (unsigned long pos = 0; pos < line.length (); pos++)
+        {
+            if (test.oldMatch (line, pos) != test.newMatch (line, pos))
+            {
+                std::cout << "operator at " << pos << " differs in '" << line << "'" << std::endl;
+                return 1;
+            }
+        }
+
+        std::string expected = test.oldInflate (line);
+        std::string result = test.newInflate (line);
+        if (expected != result)
+        {
+            std::cout << "'" << line << "' gives '" << result << "' instead of '" << expected << "'" << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}